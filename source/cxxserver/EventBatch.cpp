@@ -0,0 +1,60 @@
+#include "EventBatch.hpp"
+
+#include <algorithm>
+#include <enet/enet.h>
+
+namespace cxxserver {
+
+EventBatch::EventBatch()
+{
+    m_receives.reserve(DEFAULT_CAPACITY);
+}
+
+EventBatch::~EventBatch()
+{
+    release();
+}
+
+void EventBatch::push(const ENetEvent& event)
+{
+    switch (event.type) {
+        case ENET_EVENT_TYPE_NONE:
+            break;
+        case ENET_EVENT_TYPE_CONNECT:
+            m_connects.push_back(event.peer);
+            break;
+        case ENET_EVENT_TYPE_DISCONNECT:
+            m_disconnects.push_back(event.peer);
+            break;
+        case ENET_EVENT_TYPE_RECEIVE:
+            {
+                auto type = event.packet->dataLength != 0 ? event.packet->data[0] : INVALID_TYPE;
+                m_receives.push_back({event.peer, event.packet, type, event.channelID});
+                break;
+            }
+    }
+}
+
+void EventBatch::sort()
+{
+    std::ranges::stable_sort(m_receives, [](const Receive& lhs, const Receive& rhs) {
+        return lhs.peer->incomingPeerID < rhs.peer->incomingPeerID;
+    });
+}
+
+void EventBatch::release()
+{
+    for (const auto& receive : m_receives) {
+        enet_packet_destroy(receive.packet);
+    }
+    clear();
+}
+
+void EventBatch::clear() noexcept
+{
+    m_connects.clear();
+    m_disconnects.clear();
+    m_receives.clear();
+}
+
+} // namespace cxxserver
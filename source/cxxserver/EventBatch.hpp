@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <enet/enet.h>
+#include <span>
+#include <vector>
+
+namespace cxxserver {
+
+///
+/// @brief Events collected from the host during a single tick
+///
+/// Packets are owned by the batch and released together in release() (or on destruction).
+///
+class EventBatch {
+public:
+
+    static constexpr std::size_t  DEFAULT_CAPACITY = 256;  //!< Initial capacity of the receive list
+    static constexpr std::uint8_t INVALID_TYPE     = 0xFF; //!< Packet type of empty packets
+
+    ///
+    /// @brief Received packet
+    ///
+    ///
+    struct Receive {
+        ENetPeer*    peer;    //!< Source peer
+        ENetPacket*  packet;  //!< Packet (owned by the batch)
+        std::uint8_t type;    //!< Packet type (first byte or INVALID_TYPE)
+        std::uint8_t channel; //!< Channel the packet arrived on
+    };
+
+    ///
+    /// @brief Construct a new EventBatch object
+    ///
+    ///
+    EventBatch();
+
+    EventBatch(const EventBatch&)            = delete;
+    EventBatch(EventBatch&&)                 = delete;
+    EventBatch& operator=(const EventBatch&) = delete;
+    EventBatch& operator=(EventBatch&&)      = delete;
+
+    ///
+    /// @brief Destroy the EventBatch object (releases remaining packets)
+    ///
+    ///
+    ~EventBatch();
+
+    ///
+    /// @brief Add event to the batch
+    ///
+    /// @param event ENet event
+    ///
+    void push(const ENetEvent& event);
+
+    ///
+    /// @brief Group received packets by peer
+    ///
+    /// Packets of a peer keep their arrival order, so a peer's packets are never handled out of
+    /// order. for_each_group() then yields the runs of the same packet type inside a peer.
+    ///
+    void sort();
+
+    ///
+    /// @brief Destroy all received packets and clear the batch
+    ///
+    ///
+    void release();
+
+    ///
+    /// @brief Clear the batch without destroying received packets (ownership was taken over)
+    ///
+    ///
+    void clear() noexcept;
+
+    ///
+    /// @brief Check whether the batch has no events
+    ///
+    /// @return true If there are no events
+    ///
+    [[nodiscard]]
+    bool empty() const noexcept
+    {
+        return m_connects.empty() && m_disconnects.empty() && m_receives.empty();
+    }
+
+    ///
+    /// @brief Get connected peers
+    ///
+    /// @return Peers
+    ///
+    [[nodiscard]]
+    std::span<ENetPeer* const> connects() const noexcept
+    {
+        return m_connects;
+    }
+
+    ///
+    /// @brief Get disconnected peers
+    ///
+    /// @return Peers
+    ///
+    [[nodiscard]]
+    std::span<ENetPeer* const> disconnects() const noexcept
+    {
+        return m_disconnects;
+    }
+
+    ///
+    /// @brief Get received packets (grouped after sort())
+    ///
+    /// @return Received packets
+    ///
+    [[nodiscard]]
+    std::span<const Receive> receives() const noexcept
+    {
+        return m_receives;
+    }
+
+    ///
+    /// @brief Call function for every run of packets with the same type
+    ///
+    /// @tparam Function Callable with (std::uint8_t, std::span<const Receive>)
+    /// @param function Function
+    ///
+    template <typename Function>
+    void for_each_group(Function&& function) const
+    {
+        std::span<const Receive> receives{m_receives};
+        while (!receives.empty()) {
+            auto type  = receives.front().type;
+            auto count = 1UZ;
+            while (count < receives.size() && receives[count].type == type) {
+                ++count;
+            }
+            function(type, receives.first(count));
+            receives = receives.subspan(count);
+        }
+    }
+
+private:
+
+    std::vector<ENetPeer*> m_connects;
+    std::vector<ENetPeer*> m_disconnects;
+    std::vector<Receive>   m_receives;
+};
+
+} // namespace cxxserver
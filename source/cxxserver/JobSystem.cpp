@@ -0,0 +1,117 @@
+#include "JobSystem.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace cxxserver {
+
+namespace {
+
+thread_local const JobSystem* s_owner = nullptr; //!< Pool of the current worker thread
+thread_local std::size_t      s_index = 0;       //!< Queue of the current worker thread
+
+} // namespace
+
+JobSystem::JobSystem(std::size_t workers)
+{
+    m_queues.reserve(workers + 1);
+    for (std::size_t i = 0; i <= workers; ++i) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+
+    m_workers.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        m_workers.emplace_back([this, i] { run(i); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    m_stop.store(true, std::memory_order_release);
+    m_epoch.fetch_add(1, std::memory_order_release);
+    m_epoch.notify_all();
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void JobSystem::push(const Job& job)
+{
+    auto& queue = *m_queues[queue_index()];
+    {
+        std::scoped_lock lock{queue.mutex};
+        queue.jobs.push_back(job);
+    }
+    m_epoch.fetch_add(1, std::memory_order_release);
+    m_epoch.notify_all();
+}
+
+void JobSystem::wait(const std::atomic<std::size_t>& pending)
+{
+    auto index = queue_index();
+    while (pending.load(std::memory_order_acquire) != 0) {
+        if (!try_execute(index)) {
+            std::this_thread::yield(); // remaining chunks are running on other threads
+        }
+    }
+}
+
+bool JobSystem::try_execute(std::size_t index)
+{
+    Job job{};
+    if (!try_pop(index, job) && !try_steal(index, job)) {
+        return false;
+    }
+    job.function(job.context, job.begin, job.end);
+    job.pending->fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+bool JobSystem::try_pop(std::size_t index, Job& job)
+{
+    auto&            queue = *m_queues[index];
+    std::scoped_lock lock{queue.mutex};
+    if (queue.jobs.empty()) {
+        return false;
+    }
+    job = queue.jobs.back();
+    queue.jobs.pop_back();
+    return true;
+}
+
+bool JobSystem::try_steal(std::size_t index, Job& job)
+{
+    for (std::size_t offset = 1; offset < m_queues.size(); ++offset) {
+        auto&            queue = *m_queues[(index + offset) % m_queues.size()];
+        std::scoped_lock lock{queue.mutex};
+        if (!queue.jobs.empty()) {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::run(std::size_t index)
+{
+    s_owner = this;
+    s_index = index;
+
+    while (!m_stop.load(std::memory_order_acquire)) {
+        auto epoch = m_epoch.load(std::memory_order_acquire);
+        if (!try_execute(index)) {
+            m_epoch.wait(epoch, std::memory_order_acquire);
+        }
+    }
+}
+
+std::size_t JobSystem::queue_index() const noexcept
+{
+    return s_owner == this ? s_index : m_workers.size();
+}
+
+} // namespace cxxserver
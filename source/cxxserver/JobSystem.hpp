@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace cxxserver {
+
+///
+/// @brief Work-stealing thread pool
+///
+/// Every thread owns a queue, the owner takes the newest job and idle threads steal the oldest
+/// jobs of other queues. Callers outside the pool share one extra queue and help executing jobs
+/// while they wait, so a pool without workers runs everything inline. Jobs must not throw.
+///
+class JobSystem {
+public:
+
+    ///
+    /// @brief Construct a new JobSystem object
+    ///
+    /// @param workers Number of worker threads (0 = run jobs on the calling thread)
+    ///
+    explicit JobSystem(std::size_t workers);
+
+    JobSystem(const JobSystem&)            = delete;
+    JobSystem(JobSystem&&)                 = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    JobSystem& operator=(JobSystem&&)      = delete;
+
+    ///
+    /// @brief Stop workers and destroy the JobSystem object
+    ///
+    ///
+    ~JobSystem();
+
+    ///
+    /// @brief Get number of threads executing jobs (workers and the caller)
+    ///
+    /// @return Concurrency
+    ///
+    [[nodiscard]]
+    std::size_t concurrency() const noexcept
+    {
+        return m_workers.size() + 1;
+    }
+
+    ///
+    /// @brief Split range into chunks and execute them in parallel (blocks until all chunks are done)
+    ///
+    /// @tparam Function Callable with (std::size_t begin, std::size_t end)
+    /// @param count Number of items
+    /// @param grain Max items per chunk
+    /// @param function Function
+    ///
+    template <typename Function>
+    void parallel_for(std::size_t count, std::size_t grain, Function&& function)
+    {
+        using FunctionT = std::remove_reference_t<Function>;
+
+        if (count == 0) {
+            return;
+        }
+        grain = grain == 0 ? 1 : grain;
+        if (m_workers.empty() || count <= grain) {
+            function(std::size_t{0}, count);
+            return;
+        }
+
+        std::atomic<std::size_t> pending{(count + grain - 1) / grain};
+        auto trampoline = [](void* context, std::size_t begin, std::size_t end) {
+            (*static_cast<FunctionT*>(context))(begin, end);
+        };
+        for (std::size_t begin = 0; begin < count; begin += grain) {
+            push({trampoline, const_cast<void*>(static_cast<const void*>(&function)), begin, std::min(begin + grain, count), &pending});
+        }
+        wait(pending);
+    }
+
+    ///
+    /// @brief Execute count calls in parallel (blocks until all calls are done)
+    ///
+    /// @tparam Function Callable with (std::size_t index)
+    /// @param count Number of calls
+    /// @param function Function
+    ///
+    template <typename Function>
+    void parallel_invoke(std::size_t count, Function&& function)
+    {
+        parallel_for(count, 1, [&function](std::size_t begin, std::size_t end) {
+            for (auto index = begin; index < end; ++index) {
+                function(index);
+            }
+        });
+    }
+
+private:
+
+    struct Job {
+        void (*function)(void*, std::size_t, std::size_t);
+        void*                     context;
+        std::size_t               begin;
+        std::size_t               end;
+        std::atomic<std::size_t>* pending;
+    };
+
+    struct Queue {
+        std::mutex      mutex;
+        std::deque<Job> jobs;
+    };
+
+    void push(const Job& job);
+    void wait(const std::atomic<std::size_t>& pending);
+    bool try_execute(std::size_t index);
+    bool try_pop(std::size_t index, Job& job);
+    bool try_steal(std::size_t index, Job& job);
+    void run(std::size_t index);
+
+    [[nodiscard]]
+    std::size_t queue_index() const noexcept;
+
+    std::vector<std::unique_ptr<Queue>> m_queues;      //!< Worker queues and the shared caller queue (last)
+    std::vector<std::thread>            m_workers;     //!< Worker threads
+    std::atomic<std::uint64_t>          m_epoch{0};    //!< Incremented on every push (sleeping workers wait on it)
+    std::atomic<bool>                   m_stop{false}; //!< Stop workers
+};
+
+} // namespace cxxserver
@@ -1,5 +1,11 @@
+#include "cxxserver/Configuration.h"
+
 #include <memory>
 
+#if CXXSERVER_WITH_TESTS
+#include <doctest_fwd.h>
+#endif
+
 struct Context {
     Context(int /*argc*/, char** /*argv*/) { }
 
@@ -12,11 +18,22 @@ struct Context {
 ///
 /// @brief Main entry
 ///
+/// Test builds run the selected test cases first and exit early when only listing them.
+///
 /// @param argc Number of arguments
 /// @param argv Arguments
 /// @return 0 on success
 ///
 int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
 {
+#if CXXSERVER_WITH_TESTS
+    doctest::Context tests{argc, argv};
+    int              result = tests.run();
+    if (tests.shouldExit()) {
+        return result;
+    }
+    return result + std::make_unique<Context>(argc, argv)->run();
+#else
     return std::make_unique<Context>(argc, argv)->run();
+#endif
 }
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+
+namespace cxxserver {
+
+///
+/// @brief Lock-free bounded multi-producer single-consumer ring buffer
+///
+/// Every cell carries a sequence number, producers claim cells with a single compare-exchange on
+/// the tail and publish them by advancing the cell sequence.
+///
+/// @tparam T Element type
+/// @tparam Capacity Number of elements (power of two)
+///
+template <typename T, std::size_t Capacity>
+class MpscRing {
+public:
+
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "elements must be trivially copyable");
+
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+    static constexpr std::size_t MASK            = Capacity - 1;
+
+    MpscRing() noexcept
+    {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&)            = delete;
+    MpscRing(MpscRing&&)                 = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+    MpscRing& operator=(MpscRing&&)      = delete;
+    ~MpscRing()                          = default;
+
+    ///
+    /// @brief Push element (any producer)
+    ///
+    /// @param value Element
+    /// @return false if the ring is full
+    ///
+    bool try_push(const T& value) noexcept
+    {
+        auto  position = m_tail.load(std::memory_order_relaxed);
+        Cell* cell     = nullptr;
+        for (;;) {
+            cell          = &m_cells[position & MASK];
+            auto sequence = cell->sequence.load(std::memory_order_acquire);
+            auto diff     = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = value;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    ///
+    /// @brief Pop element (consumer only)
+    ///
+    /// @return Element or nothing if the ring is empty
+    ///
+    std::optional<T> try_pop() noexcept
+    {
+        auto& cell = m_cells[m_head & MASK];
+        if (cell.sequence.load(std::memory_order_acquire) != m_head + 1) {
+            return std::nullopt;
+        }
+        T value = cell.value;
+        cell.sequence.store(m_head + Capacity, std::memory_order_release);
+        ++m_head;
+        return value;
+    }
+
+private:
+
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T                        value;
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail{0}; //!< Producer position
+    alignas(CACHE_LINE_SIZE) std::size_t m_head{0};              //!< Consumer position
+    alignas(CACHE_LINE_SIZE) std::array<Cell, Capacity> m_cells{};
+};
+
+} // namespace cxxserver
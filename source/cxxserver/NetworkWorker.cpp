@@ -0,0 +1,386 @@
+#include "NetworkWorker.hpp"
+
+#include "cxxserver/EventBatch.hpp"
+#include "cxxserver/PacketAllocator.hpp"
+#include "cxxserver/Server.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <enet/enet.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <vector>
+
+namespace cxxserver {
+
+namespace {
+
+Host::CreateInfo without_timeout(Host::CreateInfo config) noexcept
+{
+    config.timeout = 0; // the worker sleeps in epoll, so the wake up descriptor is watched too
+    return config;
+}
+
+} // namespace
+
+NetworkWorker::NetworkWorker(std::uint8_t index, const Host::CreateInfo& config, EventRing& events)
+    : m_index{index}
+    , m_wait{std::max<std::uint32_t>(config.timeout, 1)}
+    , m_host{without_timeout(config)}
+    , m_events{events}
+    , m_connectIDs(config.connections, 0)
+    , m_links(config.connections, PeerLink{})
+    , m_publishedLinks(config.connections, PeerLink{})
+    , m_wake{eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)}
+    , m_epoll{epoll_create1(EPOLL_CLOEXEC)}
+    , m_watching{m_host.valid() && watch(m_host.socket()) && watch(m_wake)}
+    , m_thread{[this](const std::stop_token& token) { run(token); }}
+{ }
+
+NetworkWorker::~NetworkWorker()
+{
+    m_thread.request_stop();
+    wake();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    if (m_epoll >= 0) {
+        close(m_epoll);
+    }
+    if (m_wake >= 0) {
+        close(m_wake);
+    }
+
+    for (const auto& pending : m_pendingEvents) {
+        if (pending.packet != nullptr) {
+            enet_packet_destroy(pending.packet);
+        }
+    }
+
+    // commands never executed, a packet may be queued for several peers
+    while (auto command = m_commands.try_pop()) {
+        m_stagedCommands.push_back(*command);
+    }
+    m_stagedCommands.insert(m_stagedCommands.end(), m_pendingCommands.begin(), m_pendingCommands.end());
+    for (const auto& staged : m_stagedCommands) {
+        if (staged.packet != nullptr) {
+            m_dropped.push_back(staged.packet);
+        }
+    }
+    release_dropped();
+}
+
+void NetworkWorker::push(const NetworkCommand& command)
+{
+    m_pendingCommands.push_back(command);
+}
+
+void NetworkWorker::flush()
+{
+    // ticks without commands do not need a flush
+    if (!m_pendingCommands.empty() && m_pendingCommands.back().type != NetworkCommand::Type::FLUSH) {
+        m_pendingCommands.push_back({NetworkCommand::Type::FLUSH, 0, 0, 0, 0, nullptr});
+    }
+
+    auto sent = std::ranges::find_if_not(m_pendingCommands, [this](const NetworkCommand& command) {
+        return m_commands.try_push(command);
+    });
+    if (sent != m_pendingCommands.begin()) {
+        wake();
+    }
+    m_pendingCommands.erase(m_pendingCommands.begin(), sent);
+}
+
+std::optional<PeerLink> NetworkWorker::link(std::uint16_t peer, std::uint32_t connectID) const
+{
+    std::scoped_lock lock{m_publishedMutex};
+    if (peer >= m_publishedLinks.size() || m_publishedLinks[peer].connectID != connectID) {
+        return std::nullopt;
+    }
+    return m_publishedLinks[peer];
+}
+
+void NetworkWorker::run(const std::stop_token& token)
+{
+    if (!valid()) {
+        return;
+    }
+    PacketAllocator::warm_thread();
+
+    while (!token.stop_requested()) {
+        execute();
+
+        if (!m_host.poll(m_batch)) {
+            m_batch.release();
+            continue;
+        }
+
+        bool received = !m_batch.empty();
+        decode();
+        publish_links(); // before the events, a new connection has its link state right away
+        publish();
+
+        if (received) {
+            m_host.flush(); // acknowledgements of the received packets, the next datagrams may be waiting already
+        } else {
+            wait();
+        }
+    }
+}
+
+void NetworkWorker::wait()
+{
+    std::array<epoll_event, 2> events{};
+
+    int count = epoll_wait(m_epoll, events.data(), static_cast<int>(events.size()), static_cast<int>(m_wait));
+    for (int i = 0; i < count; ++i) {
+        if (events[i].data.fd == m_wake) {
+            std::uint64_t wakeups = 0;
+            [[maybe_unused]] auto result = read(m_wake, &wakeups, sizeof(wakeups)); // resets the counter
+        }
+    }
+}
+
+void NetworkWorker::wake() noexcept
+{
+    if (m_wake < 0) {
+        return;
+    }
+    // fails only while the counter is saturated, the worker wakes up then anyway
+    std::uint64_t         wakeup = 1;
+    [[maybe_unused]] auto result = write(m_wake, &wakeup, sizeof(wakeup));
+}
+
+bool NetworkWorker::watch(int descriptor) noexcept
+{
+    if (m_epoll < 0 || descriptor < 0) {
+        return false;
+    }
+    epoll_event event{};
+    event.events  = EPOLLIN;
+    event.data.fd = descriptor;
+    return epoll_ctl(m_epoll, EPOLL_CTL_ADD, descriptor, &event) == 0;
+}
+
+void NetworkWorker::decode()
+{
+    for (auto* peer : m_batch.connects()) {
+        m_connectIDs[peer->incomingPeerID] = peer->connectID;
+        m_links[peer->incomingPeerID]      = PeerLink{};
+
+        NetworkEvent event{};
+        event.type    = NetworkEvent::Type::CONNECT;
+        event.channel = static_cast<std::uint8_t>(peer->channelCount);
+        event.source  = handle(peer);
+        event.data    = peer->eventData;
+        event.address = peer->address;
+        m_pendingEvents.push_back(event);
+    }
+
+    for (const auto& receive : m_batch.receives()) {
+        NetworkEvent event{};
+        event.type       = NetworkEvent::Type::RECEIVE;
+        event.channel    = receive.channel;
+        event.packetType = receive.type;
+        event.length     = static_cast<std::uint16_t>(std::min<std::size_t>(receive.packet->dataLength, UINT16_MAX));
+        event.source     = handle(receive.peer);
+        if (receive.packet->dataLength <= NetworkEvent::INLINE_SIZE) {
+            std::memcpy(event.payload.data(), receive.packet->data, receive.packet->dataLength);
+            enet_packet_destroy(receive.packet);
+        } else {
+            event.packet = receive.packet; // ownership moves to the simulation thread
+        }
+        m_pendingEvents.push_back(event);
+    }
+
+    for (auto* peer : m_batch.disconnects()) {
+        NetworkEvent event{};
+        event.type    = NetworkEvent::Type::DISCONNECT;
+        event.source  = handle(peer);
+        event.address = peer->address;
+        m_pendingEvents.push_back(event);
+    }
+
+    m_batch.clear();
+}
+
+void NetworkWorker::publish()
+{
+    auto published = std::ranges::find_if_not(m_pendingEvents, [this](const NetworkEvent& event) {
+        return m_events.try_push(event);
+    });
+    m_pendingEvents.erase(m_pendingEvents.begin(), published);
+}
+
+void NetworkWorker::publish_links()
+{
+    for (std::uint16_t id = 0; id < m_links.size(); ++id) {
+        auto* peer = m_host.peer(id);
+        auto& link = m_links[id];
+        if (peer == nullptr || peer->connectID != m_connectIDs[id] ||
+            (peer->state != ENET_PEER_STATE_CONNECTED && peer->state != ENET_PEER_STATE_DISCONNECT_LATER))
+        {
+            link.connectID = 0;
+            continue;
+        }
+
+        link.connectID      = peer->connectID;
+        link.roundTripTime  = peer->roundTripTime;
+        link.fragmentLength = static_cast<std::uint32_t>(peer->mtu - sizeof(ENetProtocolHeader) - sizeof(ENetProtocolSendFragment));
+        if (peer->host->checksum != nullptr) {
+            link.fragmentLength -= sizeof(enet_uint32);
+        }
+        link.window    = std::max(peer->windowSize * peer->packetThrottle / ENET_PEER_PACKET_THROTTLE_SCALE, peer->mtu);
+        link.inTransit = peer->reliableDataInTransit;
+
+        for (auto& channel : link.channels) {
+            channel.backlog  = 0;
+            channel.commands = 0;
+        }
+        for (auto* list : {&peer->sentReliableCommands, &peer->outgoingSendReliableCommands, &peer->outgoingCommands}) {
+            for (auto it = enet_list_begin(list); it != enet_list_end(list); it = enet_list_next(it)) {
+                const auto* command = reinterpret_cast<const ENetOutgoingCommand*>(it);
+                if (command->command.header.channelID < PeerLink::MAX_CHANNELS) {
+                    auto& channel = link.channels[command->command.header.channelID];
+                    ++channel.commands;
+                    channel.backlog += command->fragmentLength;
+                }
+            }
+        }
+    }
+
+    std::scoped_lock lock{m_publishedMutex};
+    m_publishedLinks = m_links;
+}
+
+void NetworkWorker::execute()
+{
+    while (auto command = m_commands.try_pop()) {
+        if (command->type != NetworkCommand::Type::FLUSH) {
+            m_stagedCommands.push_back(*command);
+            continue;
+        }
+        for (const auto& staged : m_stagedCommands) {
+            execute(staged);
+        }
+        m_stagedCommands.clear();
+        release_dropped(); // before the flush releases the packets sent unreliably
+        m_host.flush();
+    }
+}
+
+void NetworkWorker::execute(const NetworkCommand& command)
+{
+    auto* peer = m_host.peer(command.peer);
+    if (peer != nullptr && peer->connectID != command.connectID) {
+        peer = nullptr; // the connection is gone, the slot may serve another one already
+    }
+
+    switch (command.type) {
+        case NetworkCommand::Type::SEND:
+            if (peer != nullptr && command.channel < PeerLink::MAX_CHANNELS) {
+                m_links[command.peer].channels[command.channel].sent += static_cast<std::uint32_t>(command.packet->dataLength);
+            }
+            if (peer == nullptr || enet_peer_send(peer, command.channel, command.packet) != 0) {
+                m_dropped.push_back(command.packet);
+            }
+            break;
+        case NetworkCommand::Type::DISCONNECT:
+            if (peer != nullptr) {
+                enet_peer_disconnect_later(peer, command.data);
+            }
+            break;
+        case NetworkCommand::Type::FLUSH:
+            break;
+    }
+}
+
+void NetworkWorker::release_dropped()
+{
+    std::ranges::sort(m_dropped);
+    auto [first, last] = std::ranges::unique(m_dropped);
+    m_dropped.erase(first, last);
+    for (auto* packet : m_dropped) {
+        if (packet->referenceCount == 0) {
+            enet_packet_destroy(packet);
+        }
+    }
+    m_dropped.clear();
+}
+
+PeerHandle NetworkWorker::handle(const ENetPeer* peer) const noexcept
+{
+    // a peer is reset before its disconnect event is returned, so the recorded connect ID is used
+    return {m_index, peer->incomingPeerID, m_connectIDs[peer->incomingPeerID]};
+}
+
+NetworkWorkerGroup::NetworkWorkerGroup(const CreateInfo& config)
+    : m_events{std::make_unique<NetworkWorker::EventRing>()}
+{
+    const auto workers = std::max<std::uint8_t>(config.workers, 1);
+
+    auto host        = config.host;
+    host.reusePort   = config.reusePort && workers > 1;
+    host.connections = static_cast<std::uint8_t>((config.host.connections + workers - 1) / workers);
+
+    m_workers.reserve(workers);
+    for (std::uint8_t i = 0; i < workers; ++i) {
+        if (!config.reusePort) {
+            host.port = static_cast<std::uint16_t>(config.host.port + i);
+        }
+        m_workers.push_back(std::make_unique<NetworkWorker>(i, host, *m_events));
+    }
+}
+
+NetworkWorkerGroup::~NetworkWorkerGroup()
+{
+    m_workers.clear();
+    drain([](const NetworkEvent& /*event*/) { });
+}
+
+void NetworkWorkerGroup::send(PeerHandle peer, std::uint8_t channel, ENetPacket* packet)
+{
+    if (peer.worker >= m_workers.size()) {
+        enet_packet_destroy(packet);
+        return;
+    }
+    m_workers[peer.worker]->push({NetworkCommand::Type::SEND, channel, peer.peer, peer.connectID, 0, packet});
+}
+
+void NetworkWorkerGroup::disconnect(PeerHandle peer, DisconnectReason reason)
+{
+    if (peer.worker >= m_workers.size()) {
+        return;
+    }
+    m_workers[peer.worker]->push({NetworkCommand::Type::DISCONNECT, 0, peer.peer, peer.connectID, static_cast<std::uint32_t>(reason), nullptr});
+}
+
+void NetworkWorkerGroup::flush()
+{
+    for (auto& worker : m_workers) {
+        worker->flush();
+    }
+}
+
+std::optional<PeerLink> NetworkWorkerGroup::link(PeerHandle peer) const
+{
+    if (peer.worker >= m_workers.size()) {
+        return std::nullopt;
+    }
+    return m_workers[peer.worker]->link(peer.peer, peer.connectID);
+}
+
+bool NetworkWorkerGroup::valid() const noexcept
+{
+    return std::ranges::all_of(m_workers, [](const auto& worker) { return worker->valid(); });
+}
+
+} // namespace cxxserver
@@ -0,0 +1,368 @@
+#pragma once
+
+#include "cxxserver/EventBatch.hpp"
+#include "cxxserver/MpscRing.hpp"
+#include "cxxserver/Server.hpp"
+#include "cxxserver/SpscRing.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <enet/enet.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+namespace cxxserver {
+
+///
+/// @brief Peer owned by a network worker
+///
+///
+struct PeerHandle {
+    std::uint8_t  worker;    //!< Worker index
+    std::uint16_t peer;      //!< Incoming peer ID within the worker host
+    std::uint32_t connectID; //!< Connect ID of the connection (tells reused peer slots apart)
+};
+
+///
+/// @brief Event passed from a network worker to the simulation thread
+///
+/// Packets that fit into the inline payload are copied and released by the worker, larger packets
+/// are owned by the simulation thread after the event is popped.
+///
+struct NetworkEvent {
+    static constexpr std::size_t INLINE_SIZE = 32; //!< Largest packet copied into the event
+
+    enum class Type : std::uint8_t { CONNECT, DISCONNECT, RECEIVE };
+
+    Type                                  type;       //!< Event type
+    std::uint8_t                          channel;    //!< Channel (RECEIVE) or number of channels opened by the client (CONNECT)
+    std::uint8_t                          packetType; //!< First byte of the packet (RECEIVE)
+    std::uint16_t                         length;     //!< Packet length (RECEIVE)
+    PeerHandle                            source;     //!< Source peer
+    std::uint32_t                         data;       //!< Event data (CONNECT: protocol version)
+    ENetAddress                           address;    //!< Remote address (CONNECT, DISCONNECT)
+    ENetPacket*                           packet;     //!< Packet larger than INLINE_SIZE (RECEIVE)
+    std::array<std::uint8_t, INLINE_SIZE> payload;    //!< Inline packet data (RECEIVE)
+
+    ///
+    /// @brief Get packet data
+    ///
+    /// @return Packet data
+    ///
+    [[nodiscard]]
+    std::span<const std::uint8_t> bytes() const noexcept
+    {
+        if (packet != nullptr) {
+            return {packet->data, packet->dataLength};
+        }
+        return {payload.data(), length};
+    }
+};
+
+///
+/// @brief Link state of a peer published by its worker
+///
+/// Taken after every host service and after the commands of a tick were executed. The sent data
+/// counters are cumulative, comparing them with the data queued on the simulation thread tells
+/// how much of it has not reached ENet yet.
+///
+struct PeerLink {
+    static constexpr std::size_t MAX_CHANNELS = Host::CreateInfo::DEFAULT_CHANNELS; //!< Channels reported
+
+    struct Channel {
+        std::uint32_t sent;     //!< Packet data handed to ENet or dropped (cumulative, wraps around)
+        std::uint32_t backlog;  //!< Packet data queued or in transit
+        std::uint32_t commands; //!< Commands (fragments) queued or in transit
+    };
+
+    std::uint32_t                     connectID;      //!< Connect ID of the connection
+    std::uint32_t                     roundTripTime;  //!< Mean round trip time in milliseconds
+    std::uint32_t                     fragmentLength; //!< Largest packet sent without fragmentation
+    std::uint32_t                     window;         //!< Reliable data ENet puts in transit (throttled)
+    std::uint32_t                     inTransit;      //!< Reliable data in transit (all channels)
+    std::array<Channel, MAX_CHANNELS> channels;       //!< Channels
+};
+
+///
+/// @brief Command passed from the simulation thread to a network worker
+///
+/// Packets are owned by the worker after the command is pushed. FLUSH ends a tick: the worker holds
+/// commands back until the FLUSH of their tick arrives, then hands all of them to ENet and flushes
+/// the host once, so every peer gets the messages of a tick packed into as few datagrams as
+/// possible. Commands for a connection that is gone (its peer slot reused or reset) are dropped.
+///
+struct NetworkCommand {
+    enum class Type : std::uint8_t { SEND, DISCONNECT, FLUSH };
+
+    Type          type;      //!< Command type
+    std::uint8_t  channel;   //!< Channel (SEND)
+    std::uint16_t peer;      //!< Incoming peer ID within the worker host
+    std::uint32_t connectID; //!< Connect ID of the target connection
+    std::uint32_t data;      //!< Command data (DISCONNECT: reason)
+    ENetPacket*   packet;    //!< Packet (SEND)
+};
+
+///
+/// @brief Protocol driven by NetworkWorkerGroup (never touches ENet objects directly)
+///
+///
+template <typename T>
+concept EventProtocolType = requires(T& protocol, const NetworkEvent& event) {
+    protocol.try_connect(event);
+    protocol.try_disconnect(event);
+    protocol.try_receive(event);
+};
+
+///
+/// @brief Network thread owning a single host and a subset of peers
+///
+/// The thread sleeps in epoll on the host socket and an eventfd. Received datagrams and published
+/// commands wake it at once, otherwise the host is serviced when the host timeout (at least 1 ms)
+/// elapses, which drives the ENet timers (retransmissions, pings, timeouts).
+///
+class NetworkWorker {
+public:
+
+    static constexpr std::size_t EVENT_RING_CAPACITY   = 8192; //!< Capacity of the shared event ring
+    static constexpr std::size_t COMMAND_RING_CAPACITY = 4096; //!< Capacity of the command ring
+
+    using EventRing   = MpscRing<NetworkEvent, EVENT_RING_CAPACITY>;
+    using CommandRing = SpscRing<NetworkCommand, COMMAND_RING_CAPACITY>;
+
+    NetworkWorker(const NetworkWorker&)            = delete;
+    NetworkWorker(NetworkWorker&&)                 = delete;
+    NetworkWorker& operator=(const NetworkWorker&) = delete;
+    NetworkWorker& operator=(NetworkWorker&&)      = delete;
+
+    ///
+    /// @brief Construct a new NetworkWorker object and start the thread
+    ///
+    /// @param index Worker index
+    /// @param config Host create information (timeout = longest sleep between host services)
+    /// @param events Event ring shared by all workers
+    ///
+    NetworkWorker(std::uint8_t index, const Host::CreateInfo& config, EventRing& events);
+
+    ///
+    /// @brief Stop the thread and destroy the NetworkWorker object
+    ///
+    ///
+    ~NetworkWorker();
+
+    ///
+    /// @brief Queue command, commands are published in flush() (simulation thread only)
+    ///
+    /// @param command Command
+    ///
+    void push(const NetworkCommand& command);
+
+    ///
+    /// @brief End the tick, publish queued commands and wake the worker (simulation thread only)
+    ///
+    /// Commands that do not fit into the ring are kept and published by the next flush(), together
+    /// with the FLUSH of their tick.
+    ///
+    void flush();
+
+    ///
+    /// @brief Get link state of peer (any thread)
+    ///
+    /// @param peer Incoming peer ID
+    /// @param connectID Connect ID of the connection
+    /// @return Link state or nothing if the connection is gone or was not published yet
+    ///
+    [[nodiscard]]
+    std::optional<PeerLink> link(std::uint16_t peer, std::uint32_t connectID) const;
+
+    ///
+    /// @brief Check whether the host was created
+    ///
+    /// @return true If the host is valid
+    ///
+    [[nodiscard]]
+    bool valid() const noexcept
+    {
+        return m_host.valid() && m_watching;
+    }
+
+private:
+
+    void run(const std::stop_token& token);
+    void wait();
+    void wake() noexcept;
+    bool watch(int descriptor) noexcept;
+    void decode();
+    void publish();
+    void publish_links();
+    void execute();
+    void execute(const NetworkCommand& command);
+    void release_dropped();
+    PeerHandle handle(const ENetPeer* peer) const noexcept;
+
+    std::uint8_t                m_index;
+    std::uint32_t               m_wait; //!< Longest sleep between host services in milliseconds
+    Host                        m_host;
+    EventBatch                  m_batch;
+    EventRing&                  m_events;
+    CommandRing                 m_commands;
+    std::vector<std::uint32_t>  m_connectIDs;      //!< Connect ID per peer slot, recorded on connect (worker thread)
+    std::vector<PeerLink>       m_links;           //!< Link state per peer slot (worker thread)
+    std::vector<NetworkEvent>   m_pendingEvents;   //!< Events waiting for space in the ring (worker thread)
+    std::vector<NetworkCommand> m_pendingCommands; //!< Commands of the current tick (simulation thread)
+    std::vector<NetworkCommand> m_stagedCommands;  //!< Commands of a tick not ended yet (worker thread)
+    std::vector<ENetPacket*>    m_dropped;         //!< Packets of the tick some peer did not take (worker thread)
+    mutable std::mutex          m_publishedMutex;
+    std::vector<PeerLink>       m_publishedLinks; //!< Link state per peer slot (guarded by m_publishedMutex)
+    int                         m_wake{-1};       //!< eventfd signalled when commands are published
+    int                         m_epoll{-1};      //!< Watches the host socket and m_wake
+    bool                        m_watching{false}; //!< Host socket and m_wake are watched
+    std::jthread                m_thread;
+};
+
+///
+/// @brief Network I/O threads decoupled from the simulation thread
+///
+/// A single worker is a dedicated I/O thread, more workers share the port (SO_REUSEPORT) or use
+/// consecutive ports. All workers publish events into one ring consumed by the simulation thread,
+/// outbound commands are collected during the tick and published per worker in flush().
+///
+/// Every tick with commands costs a worker exactly one enet_host_flush, right after the commands of
+/// the tick were handed to ENet. ENet still sends on its own between ticks: acknowledgements after
+/// received datagrams, pings, retransmissions, and reliable data held back by the window earlier.
+/// Commands are never handed to ENet before the FLUSH of their tick, so these sends never carry
+/// part of a tick still being built.
+///
+/// The simulation thread never touches ENet objects: protocols satisfying EventProtocolType see
+/// peers as PeerHandle, send through the group and read the link state the workers publish. A slow
+/// tick does not delay acknowledgements and a burst of packets does not delay the tick.
+///
+class NetworkWorkerGroup {
+public:
+
+    struct CreateInfo {
+        Host::CreateInfo host;            //!< Host create information (connections are split between workers)
+        std::uint8_t     workers{1};      //!< Number of workers
+        bool             reusePort{true}; //!< Share the port, otherwise worker i listens on port + i
+    };
+
+    NetworkWorkerGroup(const NetworkWorkerGroup&)            = delete;
+    NetworkWorkerGroup(NetworkWorkerGroup&&)                 = delete;
+    NetworkWorkerGroup& operator=(const NetworkWorkerGroup&) = delete;
+    NetworkWorkerGroup& operator=(NetworkWorkerGroup&&)      = delete;
+
+    ///
+    /// @brief Construct a new NetworkWorkerGroup object
+    ///
+    /// @param config Create information
+    ///
+    explicit NetworkWorkerGroup(const CreateInfo& config);
+
+    ///
+    /// @brief Stop workers and destroy the NetworkWorkerGroup object
+    ///
+    ///
+    ~NetworkWorkerGroup();
+
+    ///
+    /// @brief Call function for every pending event (simulation thread only)
+    ///
+    /// Packets referenced by the events are released after the function returns.
+    ///
+    /// @tparam Function Callable with (const NetworkEvent&)
+    /// @param function Function
+    ///
+    template <typename Function>
+    void drain(Function&& function)
+    {
+        while (auto event = m_events->try_pop()) {
+            function(*event);
+            if (event->packet != nullptr) {
+                enet_packet_destroy(event->packet);
+            }
+        }
+    }
+
+    ///
+    /// @brief Dispatch pending events to the protocol (simulation thread only)
+    ///
+    /// Replies of the protocol are queued until flush() ends the tick.
+    ///
+    /// @tparam ProtocolT Protocol type
+    /// @param protocol Protocol
+    ///
+    template <EventProtocolType ProtocolT>
+    void service(ProtocolT& protocol)
+    {
+        drain([&protocol](const NetworkEvent& event) {
+            switch (event.type) {
+                case NetworkEvent::Type::CONNECT:
+                    protocol.try_connect(event);
+                    break;
+                case NetworkEvent::Type::DISCONNECT:
+                    protocol.try_disconnect(event);
+                    break;
+                case NetworkEvent::Type::RECEIVE:
+                    protocol.try_receive(event);
+                    break;
+            }
+        });
+    }
+
+    ///
+    /// @brief Queue packet for peer (takes ownership of the packet)
+    ///
+    /// The same packet may be queued for several peers of one worker during a tick, it is released
+    /// once none of them needs it. Peers of different workers need their own packets, ENet counts
+    /// packet references without synchronization.
+    ///
+    /// @param peer Peer
+    /// @param channel Channel
+    /// @param packet Packet
+    ///
+    void send(PeerHandle peer, std::uint8_t channel, ENetPacket* packet);
+
+    ///
+    /// @brief Queue disconnect of peer
+    ///
+    /// @param peer Peer
+    /// @param reason Disconnect reason
+    ///
+    void disconnect(PeerHandle peer, DisconnectReason reason);
+
+    ///
+    /// @brief End the tick and publish commands queued during it
+    ///
+    /// Workers with commands wake up at once and send them with a single host flush.
+    ///
+    void flush();
+
+    ///
+    /// @brief Get link state of peer
+    ///
+    /// @param peer Peer
+    /// @return Link state or nothing if the connection is gone or was not published yet
+    ///
+    [[nodiscard]]
+    std::optional<PeerLink> link(PeerHandle peer) const;
+
+    ///
+    /// @brief Check whether all hosts were created
+    ///
+    /// @return true If all hosts are valid
+    ///
+    [[nodiscard]]
+    bool valid() const noexcept;
+
+private:
+
+    std::unique_ptr<NetworkWorker::EventRing>   m_events;
+    std::vector<std::unique_ptr<NetworkWorker>> m_workers;
+};
+
+} // namespace cxxserver
@@ -0,0 +1,463 @@
+#include "PacketAllocator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <enet/enet.h>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace cxxserver {
+
+namespace {
+
+using SizeClass = std::uint32_t;
+
+constexpr SizeClass LARGE_CLASS = PacketAllocator::NUM_SIZE_CLASSES;
+
+///
+/// @brief Header placed before every block (keeps payload aligned)
+///
+///
+struct alignas(std::max_align_t) BlockHeader {
+    SizeClass sizeClass;
+};
+
+///
+/// @brief Free block (stored in the payload)
+///
+///
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+using FreeLists  = std::array<FreeBlock*, PacketAllocator::NUM_SIZE_CLASSES>;
+using FreeCounts = std::array<std::size_t, PacketAllocator::NUM_SIZE_CLASSES>;
+
+///
+/// @brief Counters written only by the owning thread
+///
+///
+struct Counters {
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> deallocations{0};
+    std::atomic<std::uint64_t> poolHits{0};
+    std::atomic<std::uint64_t> slabRefills{0};
+    std::atomic<std::uint64_t> heapFallbacks{0};
+    std::atomic<std::uint64_t> bytesReserved{0};
+};
+
+void increment(std::atomic<std::uint64_t>& counter, std::uint64_t value = 1) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void accumulate(PacketAllocator::Stats& stats, const Counters& counters) noexcept
+{
+    stats.allocations   += counters.allocations.load(std::memory_order_relaxed);
+    stats.deallocations += counters.deallocations.load(std::memory_order_relaxed);
+    stats.poolHits      += counters.poolHits.load(std::memory_order_relaxed);
+    stats.slabRefills   += counters.slabRefills.load(std::memory_order_relaxed);
+    stats.heapFallbacks += counters.heapFallbacks.load(std::memory_order_relaxed);
+    stats.bytesReserved += counters.bytesReserved.load(std::memory_order_relaxed);
+}
+
+BlockHeader* to_header(void* memory) noexcept
+{
+    return static_cast<BlockHeader*>(memory) - 1;
+}
+
+void* to_payload(BlockHeader* header) noexcept
+{
+    return header + 1;
+}
+
+class ThreadCache;
+
+///
+/// @brief Shared allocator state (slabs, caches, warm up counts and the shared pool)
+///
+/// The shared pool holds blocks spilled by caches, blocks of exited threads and blocks released
+/// after the cache of a thread was destroyed. Every member is guarded by the mutex.
+///
+struct Registry {
+    ///
+    /// @brief Carve a new slab into blocks of the size class
+    ///
+    /// @param sizeClass Size class
+    /// @param list Free list receiving the blocks
+    /// @return Number of blocks (0 if the heap is exhausted)
+    ///
+    std::size_t grow(SizeClass sizeClass, FreeBlock*& list) noexcept
+    {
+        const std::size_t stride = sizeof(BlockHeader) + PacketAllocator::block_size(sizeClass);
+        const std::size_t count  = std::max(PacketAllocator::SLAB_SIZE / stride, std::size_t{1});
+        auto*             slab   = static_cast<std::byte*>(std::malloc(stride * count)); // NOLINT(cppcoreguidelines-no-malloc)
+        if (slab == nullptr) {
+            return 0;
+        }
+
+        try {
+            slabs.push_back(slab);
+        } catch (...) {
+            std::free(slab); // NOLINT(cppcoreguidelines-no-malloc)
+            return 0;
+        }
+
+        for (std::size_t i = count; i-- > 0;) {
+            auto* header = new (slab + (i * stride)) BlockHeader{sizeClass};
+            list         = new (to_payload(header)) FreeBlock{list};
+        }
+        return count;
+    }
+
+    std::mutex                mutex;
+    std::vector<ThreadCache*> caches;
+    std::vector<void*>        slabs; //!< Never released, blocks may be returned during static destruction
+    FreeLists                 orphans{};
+    FreeCounts                warm{}; //!< Blocks every thread cache is warmed with (set on install)
+    PacketAllocator::Stats    retired;
+};
+
+Registry& registry()
+{
+    // never destroyed, ENet and static objects may release packets during static destruction
+    static auto* s_registry = new Registry; // NOLINT(cppcoreguidelines-owning-memory)
+    return *s_registry;
+}
+
+thread_local constinit bool s_retired = false; //!< Cache of the current thread was destroyed
+
+///
+/// @brief Allocate from the shared pool (threads whose cache was destroyed)
+///
+/// @param size Requested size
+/// @return Pointer to memory or nullptr
+///
+void* allocate_shared(std::size_t size) noexcept
+{
+    auto&            shared = registry();
+    std::scoped_lock lock{shared.mutex};
+    ++shared.retired.allocations;
+
+    auto sizeClass = static_cast<SizeClass>(PacketAllocator::size_class(size));
+    if (sizeClass == LARGE_CLASS) {
+        ++shared.retired.heapFallbacks;
+        auto* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size)); // NOLINT(cppcoreguidelines-no-malloc)
+        if (header == nullptr) {
+            return nullptr;
+        }
+        header->sizeClass = LARGE_CLASS;
+        return to_payload(header);
+    }
+
+    auto& list = shared.orphans.at(sizeClass);
+    if (list != nullptr) {
+        ++shared.retired.poolHits;
+    } else if (auto count = shared.grow(sizeClass, list); count != 0) {
+        ++shared.retired.slabRefills;
+        shared.retired.bytesReserved += count * (sizeof(BlockHeader) + PacketAllocator::block_size(sizeClass));
+    } else {
+        return nullptr;
+    }
+    auto* block = list;
+    list        = block->next;
+    return block;
+}
+
+///
+/// @brief Release memory into the shared pool (threads whose cache was destroyed)
+///
+/// @param memory Memory returned by allocate
+///
+void deallocate_shared(void* memory) noexcept
+{
+    auto*            header = to_header(memory);
+    auto&            shared = registry();
+    std::scoped_lock lock{shared.mutex};
+    ++shared.retired.deallocations;
+
+    if (header->sizeClass == LARGE_CLASS) {
+        std::free(header); // NOLINT(cppcoreguidelines-no-malloc)
+        return;
+    }
+    auto* block                          = static_cast<FreeBlock*>(memory);
+    block->next                          = shared.orphans.at(header->sizeClass);
+    shared.orphans.at(header->sizeClass) = block;
+}
+
+///
+/// @brief Per-thread free lists
+///
+///
+class ThreadCache {
+public:
+
+    ThreadCache()
+    {
+        {
+            auto&            shared = registry();
+            std::scoped_lock lock{shared.mutex};
+            shared.caches.push_back(this);
+        }
+        warm();
+    }
+
+    ThreadCache(const ThreadCache&)            = delete;
+    ThreadCache(ThreadCache&&)                 = delete;
+    ThreadCache& operator=(const ThreadCache&) = delete;
+    ThreadCache& operator=(ThreadCache&&)      = delete;
+
+    ~ThreadCache()
+    {
+        auto&            shared = registry();
+        std::scoped_lock lock{shared.mutex};
+        for (std::size_t sizeClass = 0; sizeClass < m_free.size(); ++sizeClass) {
+            while (m_free.at(sizeClass) != nullptr) {
+                auto* block                  = m_free.at(sizeClass);
+                m_free.at(sizeClass)         = block->next;
+                block->next                  = shared.orphans.at(sizeClass);
+                shared.orphans.at(sizeClass) = block;
+            }
+        }
+        accumulate(shared.retired, m_counters);
+        std::erase(shared.caches, this);
+        s_retired = true;
+    }
+
+    void* allocate(SizeClass sizeClass) noexcept
+    {
+        increment(m_counters.allocations);
+        if (m_free.at(sizeClass) != nullptr) {
+            increment(m_counters.poolHits);
+        } else if (!refill(sizeClass)) {
+            return nullptr;
+        }
+        auto* block          = m_free.at(sizeClass);
+        m_free.at(sizeClass) = block->next;
+        --m_count.at(sizeClass);
+        return block;
+    }
+
+    void* allocate_large(std::size_t size) noexcept
+    {
+        increment(m_counters.allocations);
+        increment(m_counters.heapFallbacks);
+        auto* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size)); // NOLINT(cppcoreguidelines-no-malloc)
+        if (header == nullptr) {
+            return nullptr;
+        }
+        header->sizeClass = LARGE_CLASS;
+        return to_payload(header);
+    }
+
+    void deallocate(void* memory, SizeClass sizeClass) noexcept
+    {
+        increment(m_counters.deallocations);
+        auto* block          = static_cast<FreeBlock*>(memory);
+        block->next          = m_free.at(sizeClass);
+        m_free.at(sizeClass) = block;
+        if (++m_count.at(sizeClass) > PacketAllocator::CACHE_LIMIT) {
+            spill(sizeClass);
+        }
+    }
+
+    void deallocate_large(BlockHeader* header) noexcept
+    {
+        increment(m_counters.deallocations);
+        std::free(header); // NOLINT(cppcoreguidelines-no-malloc)
+    }
+
+    // reserve the blocks every thread is warmed with
+    void warm()
+    {
+        FreeCounts counts{};
+        {
+            auto&            shared = registry();
+            std::scoped_lock lock{shared.mutex};
+            counts = shared.warm;
+        }
+        for (std::size_t sizeClass = 0; sizeClass < counts.size(); ++sizeClass) {
+            reserve(static_cast<SizeClass>(sizeClass), counts.at(sizeClass));
+        }
+    }
+
+    void reserve(SizeClass sizeClass, std::size_t count)
+    {
+        std::size_t available = 0;
+        for (auto* block = m_free.at(sizeClass); block != nullptr && available < count; block = block->next) {
+            ++available;
+        }
+        while (available < count && refill(sizeClass)) {
+            available = 0;
+            for (auto* block = m_free.at(sizeClass); block != nullptr && available < count; block = block->next) {
+                ++available;
+            }
+        }
+    }
+
+    void collect(PacketAllocator::Stats& stats) const noexcept
+    {
+        accumulate(stats, m_counters);
+    }
+
+private:
+
+    // return half of the cached blocks to the shared pool (blocks allocated by other threads)
+    void spill(SizeClass sizeClass) noexcept
+    {
+        auto* first = m_free.at(sizeClass);
+        auto* last  = first;
+        for (std::size_t i = 1; i < PacketAllocator::CACHE_LIMIT / 2; ++i) {
+            last = last->next;
+        }
+        m_free.at(sizeClass)  = last->next;
+        m_count.at(sizeClass) -= PacketAllocator::CACHE_LIMIT / 2;
+
+        auto&            shared = registry();
+        std::scoped_lock lock{shared.mutex};
+        last->next                   = shared.orphans.at(sizeClass);
+        shared.orphans.at(sizeClass) = first;
+    }
+
+    bool refill(SizeClass sizeClass) noexcept
+    {
+        auto& shared = registry();
+
+        std::scoped_lock lock{shared.mutex};
+
+        // reuse blocks released by exited or other threads first, at most a slab worth so other
+        // threads find blocks as well
+        const std::size_t stride = sizeof(BlockHeader) + PacketAllocator::block_size(sizeClass);
+        if (auto* orphans = shared.orphans.at(sizeClass); orphans != nullptr) {
+            const std::size_t limit = std::max(PacketAllocator::SLAB_SIZE / stride, std::size_t{1});
+            auto*             last  = orphans;
+            std::size_t       count = 1;
+            while (last->next != nullptr && count < limit) {
+                last = last->next;
+                ++count;
+            }
+            shared.orphans.at(sizeClass) = last->next;
+            last->next                   = m_free.at(sizeClass);
+            m_free.at(sizeClass)         = orphans;
+            m_count.at(sizeClass)        += count;
+            return true;
+        }
+
+        const std::size_t count = shared.grow(sizeClass, m_free.at(sizeClass));
+        if (count == 0) {
+            return false;
+        }
+        m_count.at(sizeClass) += count;
+
+        increment(m_counters.slabRefills);
+        increment(m_counters.bytesReserved, stride * count);
+        return true;
+    }
+
+    FreeLists  m_free{};
+    FreeCounts m_count{};
+    Counters   m_counters;
+};
+
+///
+/// @brief Get cache of the calling thread (warmed on first use, must not be called once retired)
+///
+/// @return Thread cache
+///
+ThreadCache& thread_cache()
+{
+    thread_local ThreadCache s_cache;
+    return s_cache;
+}
+
+} // namespace
+
+bool PacketAllocator::install()
+{
+    ENetCallbacks callbacks{};
+    callbacks.malloc = &PacketAllocator::allocate;
+    callbacks.free   = &PacketAllocator::deallocate;
+
+    if (enet_initialize_with_callbacks(ENET_VERSION, &callbacks) != 0) {
+        return false;
+    }
+
+    // every packet is an ENetPacket followed by a separate data allocation
+    FreeCounts counts{};
+    counts.at(size_class(sizeof(ENetPacket))) += TEMPLATE_COUNT * TEMPLATE_SIZES.size();
+    for (auto size : TEMPLATE_SIZES) {
+        counts.at(size_class(size)) += TEMPLATE_COUNT;
+    }
+    {
+        auto&            shared = registry();
+        std::scoped_lock lock{shared.mutex};
+        shared.warm = counts;
+    }
+
+    // caches created from now on are warmed when they are created
+    warm_thread();
+    return true;
+}
+
+void* PacketAllocator::allocate(std::size_t size) noexcept
+{
+    if (s_retired) {
+        return allocate_shared(size);
+    }
+    auto sizeClass = size_class(size);
+    if (sizeClass == NUM_SIZE_CLASSES) {
+        return thread_cache().allocate_large(size);
+    }
+    return thread_cache().allocate(static_cast<SizeClass>(sizeClass));
+}
+
+void PacketAllocator::deallocate(void* memory) noexcept
+{
+    if (memory == nullptr) {
+        return;
+    }
+    if (s_retired) {
+        deallocate_shared(memory);
+        return;
+    }
+    auto* header = to_header(memory);
+    if (header->sizeClass == LARGE_CLASS) {
+        thread_cache().deallocate_large(header);
+    } else {
+        thread_cache().deallocate(memory, header->sizeClass);
+    }
+}
+
+void PacketAllocator::warm_thread()
+{
+    if (!s_retired) {
+        thread_cache().warm();
+    }
+}
+
+void PacketAllocator::reserve(std::size_t size, std::size_t count)
+{
+    auto sizeClass = size_class(size);
+    if (sizeClass != NUM_SIZE_CLASSES && !s_retired) {
+        thread_cache().reserve(static_cast<SizeClass>(sizeClass), count);
+    }
+}
+
+PacketAllocator::Stats PacketAllocator::stats()
+{
+    auto&            shared = registry();
+    std::scoped_lock lock{shared.mutex};
+
+    Stats result = shared.retired;
+    for (const auto* cache : shared.caches) {
+        cache->collect(result);
+    }
+    return result;
+}
+
+} // namespace cxxserver
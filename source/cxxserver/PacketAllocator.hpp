@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace cxxserver {
+
+///
+/// @brief Size-classed pool allocator used by ENet (installed through ENet callbacks)
+///
+/// Each thread owns a cache of free blocks per size class, blocks are carved from slabs that are
+/// never returned to the global heap. Blocks freed by a different thread than the one that
+/// allocated them are returned to the shared pool once a thread caches more than CACHE_LIMIT blocks
+/// of a size class. Allocations larger than the largest size class fall back to
+/// the global heap.
+///
+/// Once installed, every thread cache is warmed with the template blocks when it is created, threads
+/// call warm_thread() on start to do so before their first packet. Memory released after the cache
+/// of a thread was destroyed (thread exit, static destruction) goes to the shared pool.
+///
+class PacketAllocator {
+public:
+
+    static constexpr std::size_t NUM_SIZE_CLASSES = 10;                                        //!< Number of size classes
+    static constexpr std::size_t MIN_BLOCK_SIZE   = 32;                                        //!< Smallest block size
+    static constexpr std::size_t MAX_BLOCK_SIZE   = MIN_BLOCK_SIZE << (NUM_SIZE_CLASSES - 1); //!< Largest block size
+    static constexpr std::size_t SLAB_SIZE        = 64 * 1024;                                 //!< Memory requested from the heap at once
+    static constexpr std::size_t TEMPLATE_COUNT   = 64;                                        //!< Preallocated blocks per template size
+    static constexpr std::size_t CACHE_LIMIT      = 4096;                                      //!< Free blocks kept per thread and size class
+
+    ///
+    /// @brief Fixed packet sizes that are preallocated per thread (world update, input data, set color, ...)
+    ///
+    ///
+    static constexpr std::array<std::size_t, 5> TEMPLATE_SIZES{3, 5, 15, 30, 769};
+
+    ///
+    /// @brief Allocator statistics (all threads)
+    ///
+    ///
+    struct Stats {
+        std::uint64_t allocations{0};   //!< Number of allocations
+        std::uint64_t deallocations{0}; //!< Number of deallocations
+        std::uint64_t poolHits{0};      //!< Allocations served from the free lists
+        std::uint64_t slabRefills{0};   //!< Number of slabs requested from the heap
+        std::uint64_t heapFallbacks{0}; //!< Allocations too large for the pool
+        std::uint64_t bytesReserved{0}; //!< Bytes held in slabs
+    };
+
+    PacketAllocator() = delete;
+
+    ///
+    /// @brief Install allocator and initialize ENet
+    ///
+    /// @return true on success
+    ///
+    static bool install();
+
+    ///
+    /// @brief Allocate memory (ENet malloc callback)
+    ///
+    /// @param size Requested size
+    /// @return Pointer to memory or nullptr
+    ///
+    static void* allocate(std::size_t size) noexcept;
+
+    ///
+    /// @brief Release memory (ENet free callback)
+    ///
+    /// @param memory Memory returned by allocate
+    ///
+    static void deallocate(void* memory) noexcept;
+
+    ///
+    /// @brief Warm the calling thread's cache with the template blocks (no-op before install)
+    ///
+    ///
+    static void warm_thread();
+
+    ///
+    /// @brief Preallocate blocks for the given size in the calling thread's cache
+    ///
+    /// @param size Block size
+    /// @param count Number of blocks
+    ///
+    static void reserve(std::size_t size, std::size_t count);
+
+    ///
+    /// @brief Collect statistics of all threads
+    ///
+    /// @return Statistics
+    ///
+    [[nodiscard]]
+    static Stats stats();
+
+    ///
+    /// @brief Get size class for the given size
+    ///
+    /// @param size Size
+    /// @return Size class or NUM_SIZE_CLASSES if the size is too large
+    ///
+    static constexpr std::size_t size_class(std::size_t size) noexcept
+    {
+        std::size_t index = 0;
+        for (std::size_t block = MIN_BLOCK_SIZE; block < size && index < NUM_SIZE_CLASSES; block <<= 1U) {
+            ++index;
+        }
+        return index;
+    }
+
+    ///
+    /// @brief Get block size of the size class
+    ///
+    /// @param sizeClass Size class
+    /// @return Block size
+    ///
+    static constexpr std::size_t block_size(std::size_t sizeClass) noexcept
+    {
+        return MIN_BLOCK_SIZE << sizeClass;
+    }
+};
+
+} // namespace cxxserver
@@ -0,0 +1,323 @@
+#pragma once
+
+#include "cxxserver/EventBatch.hpp"
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <enet/enet.h>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace cxxserver {
+
+///
+/// @brief Result of verify handler
+///
+///
+enum class HandlerResult {
+    VALID,           //!< Packet is valid
+    INVALID_ID,      //!< Packet has invalid source ID
+    INVALID_LENGTH,  //!< Packet does not have expected length
+    INVALID_CONTENT, //!< Packet content cannot be parsed
+    NOT_ALLOWED      //!< Packet operation is not allowed
+};
+
+///
+/// @brief Connection state (selects the dispatch table)
+///
+///
+enum class ConnectionState : std::uint8_t {
+    CONNECTING, //!< Connected, existing player packet not received yet
+    JOINED      //!< Player has joined
+};
+
+///
+/// @brief Received packet passed to handlers
+///
+///
+class Packet {
+public:
+
+    ///
+    /// @brief Construct a new Packet object
+    ///
+    /// @param receive Received packet
+    ///
+    explicit Packet(const EventBatch::Receive& receive) noexcept
+        : m_peer{receive.peer}
+        , m_data{receive.packet->data, receive.packet->dataLength}
+        , m_type{receive.type}
+        , m_channel{receive.channel}
+    { }
+
+    ///
+    /// @brief Construct a new Packet object
+    ///
+    /// @param peer Source peer
+    /// @param packet Packet
+    /// @param channel Channel the packet arrived on
+    ///
+    Packet(ENetPeer* peer, const ENetPacket* packet, std::uint8_t channel = 0) noexcept
+        : m_peer{peer}
+        , m_data{packet->data, packet->dataLength}
+        , m_type{packet->dataLength != 0 ? packet->data[0] : EventBatch::INVALID_TYPE}
+        , m_channel{channel}
+    { }
+
+    ///
+    /// @brief Construct a new Packet object without source peer (received by a network worker)
+    ///
+    /// @param data Packet data
+    /// @param channel Channel the packet arrived on
+    ///
+    explicit Packet(std::span<const std::uint8_t> data, std::uint8_t channel = 0) noexcept
+        : m_peer{nullptr}
+        , m_data{data}
+        , m_type{!data.empty() ? data[0] : EventBatch::INVALID_TYPE}
+        , m_channel{channel}
+    { }
+
+    ///
+    /// @brief Get source peer
+    ///
+    /// @return Source peer or nullptr if the peer is owned by a network worker
+    ///
+    [[nodiscard]]
+    ENetPeer* peer() const noexcept
+    {
+        return m_peer;
+    }
+
+    ///
+    /// @brief Get packet data (starting with the packet type)
+    ///
+    /// @return Packet data
+    ///
+    [[nodiscard]]
+    std::span<const std::uint8_t> data() const noexcept
+    {
+        return m_data;
+    }
+
+    [[nodiscard]]
+    std::uint8_t type() const noexcept
+    {
+        return m_type;
+    }
+
+    [[nodiscard]]
+    std::uint8_t channel() const noexcept
+    {
+        return m_channel;
+    }
+
+private:
+
+    ENetPeer*                     m_peer;
+    std::span<const std::uint8_t> m_data;
+    std::uint8_t                  m_type;
+    std::uint8_t                  m_channel;
+};
+
+///
+/// @brief Runtime registered handler (plain function pointer with user context)
+///
+///
+struct HandlerType {
+    HandlerResult (*function)(void* context, const Packet& packet); //!< Handler
+    void* context{nullptr};                                         //!< Passed to the handler
+};
+
+///
+/// @brief Handler registered at compile time
+///
+/// accepts() selects the packet types and connection states the handler runs for, it is evaluated
+/// while the dispatch tables are built, so other packet types do not see the handler at all.
+///
+template <typename T>
+concept StaticHandlerType = requires(T& handler, const Packet& packet) {
+    { T::accepts(ConnectionState::JOINED, std::uint8_t{0}) } -> std::same_as<bool>;
+    { handler.handle(packet) } -> std::same_as<HandlerResult>;
+};
+
+///
+/// @brief Verify and handle pipeline of received packets
+///
+/// Every connection state has a flat table of 256 entries indexed by the packet type. An entry is
+/// generated per state and type: it calls the compile-time handlers accepting that pair inline, in
+/// template argument order, and then the runtime handlers registered for it. The first result
+/// other than VALID stops the chain. Types without any handler are NOT_ALLOWED. Every outcome is
+/// counted per packet type.
+///
+/// @tparam Handlers Compile-time handlers
+///
+template <StaticHandlerType... Handlers>
+class PacketDispatcher {
+public:
+
+    static constexpr std::size_t STATE_COUNT  = 2;
+    static constexpr std::size_t TYPE_COUNT   = 256;
+    static constexpr std::size_t RESULT_COUNT = 5;
+
+    ///
+    /// @brief Construct a new PacketDispatcher object
+    ///
+    /// @param handlers Compile-time handlers
+    ///
+    explicit PacketDispatcher(Handlers... handlers)
+        : m_handlers{std::move(handlers)...}
+    { }
+
+    ///
+    /// @brief Register handler (runs after the compile-time handlers and earlier registered ones)
+    ///
+    /// @param state Connection state
+    /// @param type Packet type
+    /// @param handler Handler
+    ///
+    void register_handler(ConnectionState state, std::uint8_t type, HandlerType handler)
+    {
+        m_runtime[index(state)][type].push_back(handler);
+    }
+
+    ///
+    /// @brief Verify and handle packet
+    ///
+    /// @param state Connection state of the source
+    /// @param packet Packet
+    /// @return Result of the first handler which did not return VALID (or VALID)
+    ///
+    HandlerResult dispatch(ConnectionState state, const Packet& packet)
+    {
+        static constexpr std::array<Table, STATE_COUNT> TABLES{make_table<ConnectionState::CONNECTING>(), make_table<ConnectionState::JOINED>()};
+
+        auto result = TABLES[index(state)][packet.type()](*this, packet);
+        ++m_counters[packet.type()][static_cast<std::size_t>(result)];
+        return result;
+    }
+
+    ///
+    /// @brief Get compile-time handler
+    ///
+    /// @tparam T Handler type
+    /// @return Handler
+    ///
+    template <typename T>
+    [[nodiscard]]
+    T& handler() noexcept
+    {
+        return std::get<T>(m_handlers);
+    }
+
+    ///
+    /// @brief Get number of dispatched packets of type with result
+    ///
+    /// @param type Packet type
+    /// @param result Result
+    /// @return Number of packets
+    ///
+    [[nodiscard]]
+    std::uint64_t count(std::uint8_t type, HandlerResult result) const noexcept
+    {
+        return m_counters[type][static_cast<std::size_t>(result)];
+    }
+
+    ///
+    /// @brief Get number of dispatched packets with result (all types)
+    ///
+    /// @param result Result
+    /// @return Number of packets
+    ///
+    [[nodiscard]]
+    std::uint64_t count(HandlerResult result) const noexcept
+    {
+        std::uint64_t total = 0;
+        for (const auto& counters : m_counters) {
+            total += counters[static_cast<std::size_t>(result)];
+        }
+        return total;
+    }
+
+    ///
+    /// @brief Reset all counters
+    ///
+    ///
+    void reset_counters() noexcept
+    {
+        m_counters = {};
+    }
+
+private:
+
+    using Entry = HandlerResult (*)(PacketDispatcher&, const Packet&);
+    using Table = std::array<Entry, TYPE_COUNT>;
+
+    static constexpr std::size_t index(ConnectionState state) noexcept
+    {
+        return static_cast<std::size_t>(state);
+    }
+
+    ///
+    /// @brief Run handler I if it accepts the state and type
+    ///
+    /// @return false if the chain has to stop
+    ///
+    template <std::size_t I, ConnectionState State, std::uint8_t Type>
+    static bool run_static(PacketDispatcher& self, const Packet& packet, HandlerResult& result)
+    {
+        using Handler = std::tuple_element_t<I, std::tuple<Handlers...>>;
+        if constexpr (Handler::accepts(State, Type)) {
+            result = std::get<I>(self.m_handlers).handle(packet);
+            return result == HandlerResult::VALID;
+        } else {
+            return true;
+        }
+    }
+
+    template <ConnectionState State, std::uint8_t Type>
+    static HandlerResult entry(PacketDispatcher& self, const Packet& packet)
+    {
+        constexpr bool HAS_STATIC = (Handlers::accepts(State, Type) || ...);
+
+        const auto& runtime = self.m_runtime[index(State)][Type];
+        if constexpr (!HAS_STATIC) {
+            if (runtime.empty()) {
+                return HandlerResult::NOT_ALLOWED;
+            }
+        }
+
+        auto result = HandlerResult::VALID;
+        bool valid  = [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return (run_static<I, State, Type>(self, packet, result) && ...);
+        }(std::index_sequence_for<Handlers...>{});
+        if (!valid) {
+            return result;
+        }
+
+        for (const auto& handler : runtime) {
+            result = handler.function(handler.context, packet);
+            if (result != HandlerResult::VALID) {
+                return result;
+            }
+        }
+        return result;
+    }
+
+    template <ConnectionState State>
+    static consteval Table make_table()
+    {
+        return []<std::size_t... Type>(std::index_sequence<Type...>) {
+            return Table{&entry<State, static_cast<std::uint8_t>(Type)>...};
+        }(std::make_index_sequence<TYPE_COUNT>{});
+    }
+
+    std::tuple<Handlers...>                                                   m_handlers;
+    std::array<std::array<std::vector<HandlerType>, TYPE_COUNT>, STATE_COUNT> m_runtime{};
+    std::array<std::array<std::uint64_t, RESULT_COUNT>, TYPE_COUNT>           m_counters{}; //!< Outcomes per packet type
+};
+
+} // namespace cxxserver
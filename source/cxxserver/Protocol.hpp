@@ -8,7 +8,11 @@
 
 #pragma once
 
+#include "cxxserver/EventBatch.hpp"
+
+#include <cstdint>
 #include <enet/enet.h>
+#include <span>
 
 namespace cxxserver {
 
@@ -45,4 +49,24 @@ public:
     virtual void try_receive(ENetPeer* peer, ENetPacket* packet) = 0;
 };
 
+///
+/// @brief Protocol accepted by Server (dispatched statically)
+///
+///
+template <typename T>
+concept ProtocolType = requires(T& protocol, ENetPeer* peer, ENetPacket* packet) {
+    protocol.try_connect(peer);
+    protocol.try_disconnect(peer);
+    protocol.try_receive(peer, packet);
+};
+
+///
+/// @brief Protocol that handles all packets of the same type at once
+///
+///
+template <typename T>
+concept BatchProtocolType = ProtocolType<T> && requires(T& protocol, std::uint8_t type, std::span<const EventBatch::Receive> receives) {
+    protocol.try_receive_batch(type, receives);
+};
+
 } // namespace cxxserver
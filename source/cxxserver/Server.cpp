@@ -1,21 +1,40 @@
 #include "Server.hpp"
 
-#include "cxxserver/Protocol.hpp"
+#include "cxxserver/EventBatch.hpp"
 
 #include <enet/enet.h>
+#include <sys/socket.h>
 
 namespace cxxserver {
 
-Server::Server(const CreateInfo& config)
+Host::Host(const CreateInfo& config)
     : m_timeout{config.timeout}
 {
     ENetAddress address;
     address.host = ENET_HOST_ANY;
     address.port = config.port;
-    m_host       = enet_host_create(&address, config.connections, 2, config.bandwidthIncoming, config.bandwidthOutgoing);
+
+    if (!config.reusePort) {
+        m_host = enet_host_create(&address, config.connections, config.channels, config.bandwidthIncoming, config.bandwidthOutgoing);
+    } else {
+        // create unbound host, the option has to be set before the socket is bound
+        m_host = enet_host_create(nullptr, config.connections, config.channels, config.bandwidthIncoming, config.bandwidthOutgoing);
+        if (m_host != nullptr) {
+            int enable = 1;
+            if (setsockopt(m_host->socket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0 ||
+                enet_socket_bind(m_host->socket, &address) != 0)
+            {
+                enet_host_destroy(m_host);
+                m_host = nullptr;
+            } else {
+                m_host->address = address;
+            }
+        }
+    }
 
     if (m_host == nullptr) {
         // error
+        return;
     }
 
     if (enet_host_compress_with_range_coder(m_host) != 0) {
@@ -23,35 +42,34 @@ Server::Server(const CreateInfo& config)
     }
 }
 
-Server::~Server()
+Host::~Host()
 {
     enet_host_destroy(m_host);
 }
 
-bool Server::service(Protocol& protocol)
+bool Host::poll(EventBatch& batch)
 {
     ENetEvent event;
-    while (true) {
-        int result = enet_host_service(m_host, &event, m_timeout);
-        if (result <= 0) {
-            return result == 0;
-        }
 
-        switch (event.type) {
-            case ENET_EVENT_TYPE_NONE:
-                break;
-            case ENET_EVENT_TYPE_CONNECT:
-                protocol.try_connect(event.peer);
-                break;
-            case ENET_EVENT_TYPE_DISCONNECT:
-                protocol.try_disconnect(event.peer);
-                break;
-            case ENET_EVENT_TYPE_RECEIVE:
-                protocol.try_receive(event.peer, event.packet);
-                enet_packet_destroy(event.packet);
-                break;
-        }
+    int result = enet_host_service(m_host, &event, m_timeout);
+    while (result > 0) {
+        batch.push(event);
+        result = enet_host_check_events(m_host, &event);
+    }
+    return result == 0;
+}
+
+void Host::flush()
+{
+    enet_host_flush(m_host);
+}
+
+ENetPeer* Host::peer(std::uint16_t id) const noexcept
+{
+    if (id >= m_host->peerCount) {
+        return nullptr;
     }
+    return &m_host->peers[id];
 }
 
 } // namespace cxxserver
@@ -1,13 +1,14 @@
 #pragma once
 
+#include "cxxserver/EventBatch.hpp"
+#include "cxxserver/PacketDispatcher.hpp"
+#include "cxxserver/Protocol.hpp"
+
 #include <cstdint>
 #include <enet/enet.h>
-#include <functional>
 
 namespace cxxserver {
 
-class Protocol;
-
 ///
 /// @brief Protocol version
 ///
@@ -21,42 +22,110 @@ enum class ProtocolVersion { V75 = 3, V76 = 4 };
 enum class DisconnectReason { UNKNOWN = 0, BANNED = 1, IP_LIMIT_EXCEEDED = 2, WRONG_PROTOCOL_VERSION = 3, SERVER_FULL = 4, KICKED = 10 };
 
 ///
-/// @brief Result of verify handler
-///
+/// @brief ENetHost wrapper
 ///
-enum class HandlerResult {
-    VALID,           //!< Packet is valid
-    INVALID_ID,      //!< Packet has invalid source ID
-    INVALID_LENGTH,  //!< Packet does not have expected length
-    INVALID_CONTENT, //!< Packet content cannot be parsed
-    NOT_ALLOWED      //!< Packet operation is not allowed
-};
-
-///
-/// @brief Handler to verify packet
-///
-///
-using HandlerType = std::function<HandlerResult(const class Packet&)>;
-
 ///
-/// @brief Server (ENetHost wrapper)
-///
-///
-class Server {
+class Host {
 public:
 
     struct CreateInfo {
         static constexpr std::uint16_t DEFAULT_PORT              = 32887;
         static constexpr std::uint8_t  DEFAULT_CONNECTIONS_LIMIT = 32;
+        static constexpr std::uint8_t  DEFAULT_CHANNELS          = 3; //!< Game, map and state channel
 
         std::uint32_t   bandwidthIncoming{0};                   //!< Incoming bandwidth in bytes per second
         std::uint32_t   bandwidthOutgoing{0};                   //!< Outgoing bandwidth in bytes per second
         std::uint32_t   timeout{0};                             //!< Server receive event timeout in milliseconds
         std::uint16_t   port{DEFAULT_PORT};                     //!< Server port
         std::uint8_t    connections{DEFAULT_CONNECTIONS_LIMIT}; //!< Max server connections
+        std::uint8_t    channels{DEFAULT_CHANNELS};             //!< Max channels per connection
         ProtocolVersion protocol{ProtocolVersion::V75};         //!< Protocol version
+        bool            reusePort{false};                       //!< Share the port with other hosts (SO_REUSEPORT)
     };
 
+    Host(const Host&)            = delete;
+    Host(Host&&)                 = delete;
+    Host& operator=(const Host&) = delete;
+    Host& operator=(Host&&)      = delete;
+
+    ///
+    /// @brief Construct a new Host object
+    ///
+    /// @param config Create information
+    ///
+    explicit Host(const CreateInfo& config);
+
+    ///
+    /// @brief Destroy the Host object
+    ///
+    ///
+    ~Host();
+
+    ///
+    /// @brief Wait for events and drain all ready events into the batch
+    ///
+    /// Blocks for at most the configured timeout for the first event, the remaining events are
+    /// taken from the already received queue without blocking.
+    ///
+    /// @param batch Event batch
+    /// @return false on failure
+    ///
+    bool poll(EventBatch& batch);
+
+    ///
+    /// @brief Send all queued packets
+    ///
+    ///
+    void flush();
+
+    ///
+    /// @brief Get peer by incoming peer ID
+    ///
+    /// @param id Incoming peer ID
+    /// @return Peer or nullptr if the ID is out of range
+    ///
+    [[nodiscard]]
+    ENetPeer* peer(std::uint16_t id) const noexcept;
+
+    ///
+    /// @brief Check whether the host was created
+    ///
+    /// @return true If the host is valid
+    ///
+    [[nodiscard]]
+    bool valid() const noexcept
+    {
+        return m_host != nullptr;
+    }
+
+    ///
+    /// @brief Get host socket (for waiting in TickScheduler)
+    ///
+    /// @return Socket
+    ///
+    [[nodiscard]]
+    ENetSocket socket() const noexcept
+    {
+        return m_host->socket;
+    }
+
+private:
+
+    ENetHost*     m_host;
+    std::uint32_t m_timeout;
+};
+
+///
+/// @brief Server (dispatches host events to the protocol)
+///
+/// @tparam ProtocolT Protocol type
+///
+template <ProtocolType ProtocolT>
+class Server {
+public:
+
+    using CreateInfo = Host::CreateInfo;
+
     Server(const Server&)            = delete;
     Server(Server&&)                 = delete;
     Server& operator=(const Server&) = delete;
@@ -67,26 +136,83 @@ public:
     ///
     /// @param config Create information
     ///
-    explicit Server(const CreateInfo& config);
+    explicit Server(const CreateInfo& config)
+        : m_host{config}
+    { }
 
     ///
     /// @brief Destroy the Server object
     ///
     ///
-    ~Server();
+    ~Server() = default;
 
     ///
-    /// @brief Run protocol
+    /// @brief Run single tick of the protocol
+    ///
+    /// Connects are handled first, then received packets grouped by peer in arrival order, then
+    /// disconnects. Packets are released after all events are dispatched. Replies stay queued until flush().
     ///
     /// @param protocol Protocol
-    /// @return 0 on success
+    /// @return false on failure
     ///
-    bool service(Protocol& protocol);
+    bool service(ProtocolT& protocol)
+    {
+        if (!m_host.poll(m_batch)) {
+            m_batch.release();
+            return false;
+        }
+
+        m_batch.sort();
+
+        for (auto* peer : m_batch.connects()) {
+            protocol.try_connect(peer);
+        }
+
+        m_batch.for_each_group([&protocol](std::uint8_t type, std::span<const EventBatch::Receive> receives) {
+            if constexpr (BatchProtocolType<ProtocolT>) {
+                protocol.try_receive_batch(type, receives);
+            } else {
+                for (const auto& receive : receives) {
+                    protocol.try_receive(receive.peer, receive.packet);
+                }
+            }
+        });
+
+        for (auto* peer : m_batch.disconnects()) {
+            protocol.try_disconnect(peer);
+        }
+
+        m_batch.release();
+        return true;
+    }
+
+    ///
+    /// @brief Send everything the protocol queued during the tick
+    ///
+    /// Call once at the end of the tick (after the protocol update). Messages queued for a peer
+    /// since the last flush go out together, packed into as few datagrams as the MTU allows.
+    ///
+    ///
+    void flush()
+    {
+        m_host.flush();
+    }
+
+    ///
+    /// @brief Get host socket (for waiting in TickScheduler, use zero host timeout)
+    ///
+    /// @return Socket
+    ///
+    [[nodiscard]]
+    ENetSocket socket() const noexcept
+    {
+        return m_host.socket();
+    }
 
 private:
 
-    ENetHost*     m_host;
-    std::uint32_t m_timeout;
+    Host       m_host;
+    EventBatch m_batch;
 };
 
 } // namespace cxxserver
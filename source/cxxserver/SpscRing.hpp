@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+
+namespace cxxserver {
+
+///
+/// @brief Lock-free single-producer single-consumer ring buffer
+///
+/// @tparam T Element type
+/// @tparam Capacity Number of elements (power of two)
+///
+template <typename T, std::size_t Capacity>
+class SpscRing {
+public:
+
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "elements must be trivially copyable");
+
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+    static constexpr std::size_t MASK            = Capacity - 1;
+
+    ///
+    /// @brief Push element (producer only)
+    ///
+    /// @param value Element
+    /// @return false if the ring is full
+    ///
+    bool try_push(const T& value) noexcept
+    {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_headCache == Capacity) {
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if (tail - m_headCache == Capacity) {
+                return false;
+            }
+        }
+        m_buffer[tail & MASK] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    ///
+    /// @brief Pop element (consumer only)
+    ///
+    /// @return Element or nothing if the ring is empty
+    ///
+    std::optional<T> try_pop() noexcept
+    {
+        auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tailCache) {
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if (head == m_tailCache) {
+                return std::nullopt;
+            }
+        }
+        T value = m_buffer[head & MASK];
+        m_head.store(head + 1, std::memory_order_release);
+        return value;
+    }
+
+    ///
+    /// @brief Check whether the ring is empty (approximate)
+    ///
+    /// @return true If empty
+    ///
+    [[nodiscard]]
+    bool empty() const noexcept
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_head{0}; //!< Consumer position
+    std::size_t m_tailCache{0};                                   //!< Consumer copy of tail
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail{0}; //!< Producer position
+    std::size_t m_headCache{0};                                   //!< Producer copy of head
+    alignas(CACHE_LINE_SIZE) std::array<T, Capacity> m_buffer{};
+};
+
+} // namespace cxxserver
@@ -0,0 +1,44 @@
+#include "TickGraph.hpp"
+
+#include "cxxserver/JobSystem.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+namespace cxxserver {
+
+std::size_t TickGraph::add(Phase phase)
+{
+    std::size_t level = 0;
+    for (std::size_t i = 0; i < m_phases.size(); ++i) {
+        const auto& other = m_phases[i];
+        bool conflict     = (other.writes & (phase.reads | phase.writes)) != 0 || (other.reads & phase.writes) != 0;
+        if (conflict) {
+            level = std::max(level, m_levels[i] + 1);
+        }
+    }
+
+    if (level == m_waves.size()) {
+        m_waves.emplace_back();
+    }
+    m_waves[level].push_back(m_phases.size());
+    m_levels.push_back(level);
+    m_phases.push_back(std::move(phase));
+    return m_phases.size() - 1;
+}
+
+void TickGraph::run(JobSystem& jobs)
+{
+    for (const auto& wave : m_waves) {
+        if (wave.size() == 1) {
+            m_phases[wave.front()].function(jobs);
+            continue;
+        }
+        jobs.parallel_invoke(wave.size(), [this, &wave, &jobs](std::size_t index) {
+            m_phases[wave[index]].function(jobs);
+        });
+    }
+}
+
+} // namespace cxxserver
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "cxxserver/JobSystem.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace cxxserver {
+
+///
+/// @brief Set of resources (bit per resource, meaning is defined by the user of the graph)
+///
+///
+using ResourceSet = std::uint32_t;
+
+///
+/// @brief Declarative tick pipeline
+///
+/// Phases declare the resources they read and write. A phase runs after every earlier phase it
+/// conflicts with (write/read, read/write or write/write), phases without conflicts run in
+/// parallel on the job system. Phases may use the job system internally as well.
+///
+class TickGraph {
+public:
+
+    using Function = std::function<void(JobSystem&)>;
+
+    ///
+    /// @brief Phase of the tick
+    ///
+    ///
+    struct Phase {
+        std::string_view name;   //!< Name (diagnostics)
+        ResourceSet      reads;  //!< Resources read by the phase
+        ResourceSet      writes; //!< Resources written by the phase
+        Function         function;
+    };
+
+    ///
+    /// @brief Add phase (order of conflicting phases is the order of add calls)
+    ///
+    /// @param phase Phase
+    /// @return Phase index
+    ///
+    std::size_t add(Phase phase);
+
+    ///
+    /// @brief Run all phases wave by wave
+    ///
+    /// @param jobs Job system
+    ///
+    void run(JobSystem& jobs);
+
+    ///
+    /// @brief Get phases grouped into waves (phases of the same wave run in parallel)
+    ///
+    /// @return Phase indices per wave
+    ///
+    [[nodiscard]]
+    std::span<const std::vector<std::size_t>> waves() const noexcept
+    {
+        return m_waves;
+    }
+
+    ///
+    /// @brief Get phase
+    ///
+    /// @param index Phase index
+    /// @return Phase
+    ///
+    [[nodiscard]]
+    const Phase& phase(std::size_t index) const noexcept
+    {
+        return m_phases[index];
+    }
+
+private:
+
+    std::vector<Phase>                    m_phases;
+    std::vector<std::size_t>              m_levels; //!< Wave of every phase
+    std::vector<std::vector<std::size_t>> m_waves;
+};
+
+} // namespace cxxserver
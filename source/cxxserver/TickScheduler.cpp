@@ -0,0 +1,149 @@
+#include "TickScheduler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace cxxserver {
+
+namespace {
+
+timespec to_timespec(std::chrono::nanoseconds value) noexcept
+{
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(value);
+    return {static_cast<time_t>(seconds.count()), static_cast<long>((value - seconds).count())};
+}
+
+} // namespace
+
+TickScheduler::TickScheduler(const CreateInfo& config)
+    : m_period{std::max(config.period, std::chrono::nanoseconds{1})}
+    , m_maxCatchUp{std::max(config.maxCatchUp, std::uint32_t{1})}
+{
+    m_threadConfigured = configure_thread(config.cpu, config.realtime, config.priority);
+
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (!valid()) {
+        // error
+        return;
+    }
+
+    // steady_clock uses CLOCK_MONOTONIC, deadlines are absolute so ticks do not drift
+    m_deadline = std::chrono::steady_clock::now() + m_period;
+
+    itimerspec spec{};
+    spec.it_interval = to_timespec(m_period);
+    spec.it_value    = to_timespec(m_deadline.time_since_epoch());
+    if (timerfd_settime(m_timer, TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+        close(m_timer);
+        m_timer = -1;
+        return;
+    }
+
+    epoll_event event{};
+    event.events  = EPOLLIN;
+    event.data.fd = m_timer;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_timer, &event) != 0) {
+        close(m_timer);
+        m_timer = -1;
+    }
+}
+
+TickScheduler::~TickScheduler()
+{
+    if (m_timer >= 0) {
+        close(m_timer);
+    }
+    if (m_epoll >= 0) {
+        close(m_epoll);
+    }
+}
+
+bool TickScheduler::watch(int descriptor)
+{
+    if (!valid()) {
+        return false;
+    }
+    epoll_event event{};
+    event.events  = EPOLLIN;
+    event.data.fd = descriptor;
+    return epoll_ctl(m_epoll, EPOLL_CTL_ADD, descriptor, &event) == 0;
+}
+
+std::uint32_t TickScheduler::wait()
+{
+    if (!valid()) {
+        return 0;
+    }
+
+    std::array<epoll_event, 8> events{};
+
+    int count = epoll_wait(m_epoll, events.data(), static_cast<int>(events.size()), -1);
+    if (count <= 0) {
+        return 0; // interrupted
+    }
+
+    std::uint64_t expirations = 0;
+    for (int i = 0; i < count; ++i) {
+        if (events[i].data.fd == m_timer) {
+            if (read(m_timer, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                expirations = 0;
+            }
+        }
+    }
+
+    if (expirations == 0) {
+        ++m_stats.wakeups;
+        return 0;
+    }
+
+    // lateness of the most recent expiration
+    auto now    = std::chrono::steady_clock::now();
+    auto latest = m_deadline + (m_period * static_cast<std::int64_t>(expirations - 1));
+    record(std::max(std::chrono::nanoseconds{0}, std::chrono::duration_cast<std::chrono::nanoseconds>(now - latest)));
+    m_deadline = latest + m_period;
+
+    auto ticks = static_cast<std::uint32_t>(std::min<std::uint64_t>(expirations, m_maxCatchUp));
+    m_stats.ticks   += ticks;
+    m_stats.dropped += expirations - ticks;
+    return ticks;
+}
+
+bool TickScheduler::configure_thread(int cpu, bool realtime, int priority)
+{
+    bool result = true;
+
+    if (cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(static_cast<std::size_t>(cpu), &set);
+        result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+
+    if (realtime) {
+        sched_param param{};
+        param.sched_priority = std::clamp(priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+        result               = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0 && result;
+    }
+
+    return result;
+}
+
+void TickScheduler::record(std::chrono::nanoseconds lateness) noexcept
+{
+    auto micros = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(lateness).count());
+    auto bucket = std::min<std::size_t>(std::bit_width(micros), HISTOGRAM_BUCKETS - 1);
+    ++m_stats.lateness[bucket];
+    m_stats.maxLateness = std::max(m_stats.maxLateness, lateness);
+}
+
+} // namespace cxxserver
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace cxxserver {
+
+///
+/// @brief Fixed timestep scheduler (timerfd and epoll)
+///
+/// The calling thread sleeps until the next tick is due or one of the watched descriptors (ENet
+/// sockets) becomes readable. Missed ticks are caught up to a bounded number, the rest are dropped
+/// so the simulation never spirals after a stall.
+///
+class TickScheduler {
+public:
+
+    static constexpr std::size_t HISTOGRAM_BUCKETS = 16; //!< Lateness buckets (powers of two in microseconds)
+
+    struct CreateInfo {
+        static constexpr std::chrono::nanoseconds DEFAULT_PERIOD{std::chrono::seconds{1}};
+        static constexpr std::uint32_t            DEFAULT_RATE         = 60;
+        static constexpr std::uint32_t            DEFAULT_MAX_CATCH_UP = 5;
+
+        std::chrono::nanoseconds period{DEFAULT_PERIOD / DEFAULT_RATE}; //!< Tick period
+        std::uint32_t            maxCatchUp{DEFAULT_MAX_CATCH_UP};     //!< Max ticks run after a single wake up
+        int                      cpu{-1};                              //!< Pin the calling thread to CPU (-1 = no pinning)
+        bool                     realtime{false};                      //!< Use SCHED_FIFO for the calling thread
+        int                      priority{1};                          //!< SCHED_FIFO priority
+    };
+
+    ///
+    /// @brief Scheduler statistics
+    ///
+    /// Bucket 0 counts ticks started less than 1 us late, bucket i counts ticks started
+    /// [2^(i-1), 2^i) us late, the last bucket counts everything later.
+    ///
+    struct Stats {
+        std::uint64_t                                ticks{0};       //!< Ticks returned by wait()
+        std::uint64_t                                dropped{0};     //!< Ticks dropped by bounded catch-up
+        std::uint64_t                                wakeups{0};     //!< Wake ups caused by watched descriptors
+        std::chrono::nanoseconds                     maxLateness{0}; //!< Worst lateness
+        std::array<std::uint64_t, HISTOGRAM_BUCKETS> lateness{};     //!< Lateness histogram
+    };
+
+    TickScheduler(const TickScheduler&)            = delete;
+    TickScheduler(TickScheduler&&)                 = delete;
+    TickScheduler& operator=(const TickScheduler&) = delete;
+    TickScheduler& operator=(TickScheduler&&)      = delete;
+
+    ///
+    /// @brief Construct a new TickScheduler object and configure the calling thread
+    ///
+    /// @param config Create information
+    ///
+    explicit TickScheduler(const CreateInfo& config);
+
+    ///
+    /// @brief Destroy the TickScheduler object
+    ///
+    ///
+    ~TickScheduler();
+
+    ///
+    /// @brief Check whether the timer was created
+    ///
+    /// @return true If the scheduler is valid
+    ///
+    [[nodiscard]]
+    bool valid() const noexcept
+    {
+        return m_epoll >= 0 && m_timer >= 0;
+    }
+
+    ///
+    /// @brief Check whether CPU pinning and real-time priority were applied
+    ///
+    /// @return true If the thread was configured as requested
+    ///
+    [[nodiscard]]
+    bool thread_configured() const noexcept
+    {
+        return m_threadConfigured;
+    }
+
+    ///
+    /// @brief Wake up when the descriptor becomes readable
+    ///
+    /// @param descriptor File descriptor (e.g. ENet socket)
+    /// @return false on failure
+    ///
+    bool watch(int descriptor);
+
+    ///
+    /// @brief Wait for the next tick or a watched descriptor
+    ///
+    /// @return Number of fixed steps to run (0 if woken by a descriptor)
+    ///
+    std::uint32_t wait();
+
+    ///
+    /// @brief Get tick period
+    ///
+    /// @return Tick period
+    ///
+    [[nodiscard]]
+    std::chrono::nanoseconds period() const noexcept
+    {
+        return m_period;
+    }
+
+    ///
+    /// @brief Get statistics
+    ///
+    /// @return Statistics
+    ///
+    [[nodiscard]]
+    const Stats& stats() const noexcept
+    {
+        return m_stats;
+    }
+
+    ///
+    /// @brief Pin the calling thread to CPU and optionally switch it to SCHED_FIFO
+    ///
+    /// @param cpu CPU index (-1 = no pinning)
+    /// @param realtime Use SCHED_FIFO
+    /// @param priority SCHED_FIFO priority
+    /// @return false if any setting could not be applied
+    ///
+    static bool configure_thread(int cpu, bool realtime, int priority);
+
+private:
+
+    void record(std::chrono::nanoseconds lateness) noexcept;
+
+    std::chrono::nanoseconds              m_period;
+    std::uint32_t                         m_maxCatchUp;
+    std::chrono::steady_clock::time_point m_deadline; //!< Expiration of the next pending tick
+    Stats                                 m_stats;
+    int                                   m_epoll{-1};
+    int                                   m_timer{-1};
+    bool                                  m_threadConfigured{false};
+};
+
+} // namespace cxxserver
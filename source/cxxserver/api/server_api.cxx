@@ -8,7 +8,12 @@
 
 #include "server_api.hxx"
 
-#include <cxxserver/server.hxx>
+#include <cxxserver/NetworkWorker.hpp>
+#include <cxxserver/PacketAllocator.hpp>
+#include <cxxserver/Server.hpp>
+#include <cxxserver/TickScheduler.hpp>
+#include <cxxserver/old/ctf.hxx>
+#include <chrono>
 #include <memory>
 
 namespace cxxserver {
@@ -27,26 +32,75 @@ class ServerApi : public IServerApi
     ~ServerApi() override = default;
 
     int  run() override;
-    void registerHandler(std::uint8_t packetType, HandlerType handler) override;
+    void register_handler(ConnectionState state, std::uint8_t packetType, HandlerType handler) override;
 
   private:
 
-    std::unique_ptr<Server>   mServer {};
-    std::unique_ptr<Protocol> mProtocol {};
+    using GameProtocol = spadesx::ctf_protocol;
+
+    static NetworkWorkerGroup::CreateInfo network_config(const CreateInfo & createInfo) noexcept;
+
+    std::unique_ptr<NetworkWorkerGroup> mNetwork {}; // outlives the protocol, peers disconnect through it
+    std::unique_ptr<GameProtocol>       mProtocol {};
+    TickScheduler::CreateInfo           mScheduler {};
+    bool                                mEncoderThread {};
 };
 
 ServerApi::ServerApi(const CreateInfo & createInfo)
-    : mServer { std::make_unique<Server>(createInfo) }
-    , mProtocol { Protocol::create(createInfo.protocol) }
+    : mNetwork { std::make_unique<NetworkWorkerGroup>(network_config(createInfo)) }
+    , mProtocol { std::make_unique<GameProtocol>(createInfo.host.connections) }
+    , mScheduler { createInfo.scheduler }
+    , mEncoderThread { createInfo.encoderThread }
 {
+    mProtocol->set_network(*mNetwork);
+    mProtocol->set_fixed_step(std::chrono::duration<double>(mScheduler.period).count());
+    mProtocol->set_max_catch_up(mScheduler.maxCatchUp);
+}
+
+NetworkWorkerGroup::CreateInfo ServerApi::network_config(const CreateInfo & createInfo) noexcept
+{
+    NetworkWorkerGroup::CreateInfo config;
+    config.host    = createInfo.host;
+    config.workers = 1; // broadcasts queue one packet for every peer, so all peers share the worker
+    return config;
 }
 
 int ServerApi::run()
 {
-    return mServer->service(*mProtocol) ? 0 : 1;
+    TickScheduler scheduler { mScheduler };
+    if (!scheduler.valid() || !mNetwork->valid())
+    {
+        return 1;
+    }
+
+    // world updates are encoded from published snapshots while the next step simulates
+    if (mEncoderThread)
+    {
+        mProtocol->get_encoder().start();
+    }
+    mProtocol->start();
+
+    // the I/O thread receives and acknowledges packets meanwhile, each tick takes what arrived
+    while (mNetwork->valid())
+    {
+        auto steps = scheduler.wait();
+        if (steps == 0)
+        {
+            continue; // interrupted
+        }
+        mNetwork->service(*mProtocol);
+        mProtocol->update(steps);
+        mNetwork->flush();
+    }
+
+    mProtocol->get_encoder().stop();
+    return 1;
 }
 
-void ServerApi::registerHandler([[maybe_unused]] std::uint8_t packetType, [[maybe_unused]] HandlerType handler) { }
+void ServerApi::register_handler(ConnectionState state, std::uint8_t packetType, HandlerType handler)
+{
+    mProtocol->get_dispatcher().register_handler(state, packetType, handler);
+}
 
 IServerApi * IServerApi::create(const CreateInfo & createInfo)
 {
@@ -55,7 +109,7 @@ IServerApi * IServerApi::create(const CreateInfo & createInfo)
 
 bool IServerApi::init()
 {
-    return enet_initialize() < 0;
+    return !PacketAllocator::install();
 }
 
 void IServerApi::stop()
@@ -8,11 +8,13 @@
 
 #pragma once
 
+#include <cxxserver/PacketDispatcher.hpp>
+#include <cxxserver/Server.hpp>
+#include <cxxserver/TickScheduler.hpp>
 #include <cxxserver/version.hxx>
 
 #include <array>
 #include <cstdint>
-#include <functional>
 #include <string_view>
 
 namespace cxxserver {
@@ -28,7 +30,11 @@ public:
     /// @brief Server API options
     ///
     ///
-    struct CreateInfo { };
+    struct CreateInfo {
+        Host::CreateInfo          host;                //!< Host options (connections = max players, timeout = longest wait of the I/O thread)
+        TickScheduler::CreateInfo scheduler;           //!< Tick options
+        bool                      encoderThread{true}; //!< Encode world updates on a separate thread
+    };
 
     IServerApi()                             = default;
     IServerApi(const IServerApi&)            = delete;
@@ -47,10 +53,25 @@ public:
     ///
     /// @brief Register verify handler
     ///
+    /// Received packets pass the built-in verify step and the registered handlers before the
+    /// built-in handling. A handler result other than VALID drops the packet.
+    ///
+    /// @param state Connection state
+    /// @param packetType Packet type
+    /// @param handler Verify handler
+    ///
+    virtual void register_handler(ConnectionState state, std::uint8_t packetType, HandlerType handler) = 0;
+
+    ///
+    /// @brief Register verify handler for joined players
+    ///
     /// @param packetType Packet type
     /// @param handler Verify handler
     ///
-    virtual void register_handler(std::uint8_t packetType, HandlerType handler) = 0;
+    void register_handler(std::uint8_t packetType, HandlerType handler)
+    {
+        register_handler(ConnectionState::JOINED, packetType, handler);
+    }
 
     ///
     /// @brief Create server API
@@ -48,7 +48,7 @@ class command
      * @param connection Source connection
      * @param protocol Protocol
      */
-    virtual void on_execute(std::string_view args, connection & connection, protocol & protocol) { }
+    virtual void on_execute(std::string_view /*args*/, connection & /*connection*/, protocol & /*protocol*/) { }
 
     /**
      * @brief Return true if is enabled
@@ -25,7 +25,7 @@ class kill_command : public command
     {
         if (connection.m_alive)
         {
-            protocol.kill_and_broadcast(connection, connection, kill_type::weapon, 1);
+            protocol.kill(connection, connection, kill_type::weapon, 1);
         }
         else
         {
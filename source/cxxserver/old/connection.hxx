@@ -71,16 +71,24 @@ class connection : public peer, public player_data
      * @brief Send map start packet
      *
      * @param size Size of the map
-     * @param channel Channel
      * @return true On success
      */
-    bool send_map_start(std::uint32_t size, std::uint8_t channel = 0)
+    bool send_map_start(std::uint32_t size)
     {
-        packet packet(nullptr, 5, false);
+        packet packet(nullptr, packet::map_start_size, packet_type::map_start);
         auto   stream = packet.stream();
-        stream.write_type(packet_type::map_start);
-        stream.write_int(size);
-        return send(packet, channel);
+        stream.write_packet(packets::map_start { size });
+        return send(packet);
+    }
+
+    /**
+     * @brief Get map download pacer
+     *
+     * @return Map pacer
+     */
+    map_pacer & pacer() noexcept
+    {
+        return m_map_pacer;
     }
 
     /**
@@ -88,31 +96,27 @@ class connection : public peer, public player_data
      *
      * @param chunk Pointer to the memory location containing chunk
      * @param size Size of the chunk
-     * @param unsequenced Unsequenced flag
-     * @param channel Channel
      * @return true On success
      */
-    bool send_map_chunk(void * chunk, std::uint32_t size, bool unsequenced = false, std::uint8_t channel = 0)
+    bool send_map_chunk(const void * chunk, std::uint32_t size)
     {
-        packet packet(nullptr, size + 1, unsequenced);
+        packet packet(nullptr, size + 1, packet_type::map_chunk);
         auto   stream = packet.stream();
         stream.write_type(packet_type::map_chunk);
         stream.write_array(chunk, size);
-        return send(packet, channel);
+        return send(packet);
     }
 
     /**
-     * @brief Send generic packet
+     * @brief Send generic packet (delivered according to the policy of its type)
      *
-     * @param data Pointer to the memory location containing packet data
+     * @param data Pointer to the memory location containing packet data (starting with the packet type)
      * @param size Size of the packet
-     * @param unsequenced Unsequenced flag
-     * @param channel Channel
      * @return true On success
      */
-    bool send_packet(const void * data, std::size_t size, bool unsequenced = true, std::uint8_t channel = 0)
+    bool send_packet(const void * data, std::size_t size)
     {
-        return send({ data, size, unsequenced }, channel);
+        return send({ data, size, static_cast<packet_type>(*static_cast<const std::uint8_t *>(data)) });
     }
 
     /**
@@ -120,14 +124,12 @@ class connection : public peer, public player_data
      *
      * @tparam N Size of the packet
      * @param data Pointer to the memory location containing packet data
-     * @param unsequenced Unsequenced flag
-     * @param channel Channel
      * @return true On success
      */
     template <std::size_t N>
-    bool send_packet(const std::array<std::uint8_t, N> & data, bool unsequenced = true, std::uint8_t channel = 0)
+    bool send_packet(const std::array<std::uint8_t, N> & data)
     {
-        return send_packet(data.data(), data.size(), unsequenced, channel);
+        return send_packet(data.data(), data.size());
     }
 
     /**
@@ -185,30 +187,41 @@ class connection : public peer, public player_data
      * @brief Send existing player packet
      *
      * @param other Other connection
-     * @param channel Channel
      * @return true On success
      */
-    bool send_existing_player(connection & other, std::uint8_t channel = 0)
+    bool send_existing_player(connection & other)
     {
-        packet packet(nullptr, 12 + other.m_name_length, false);
+        packet packet(nullptr, packets::existing_player::layout::min_size + other.m_name_length, packet_type::existing_player);
         auto   stream = packet.stream();
         other.fill_existing_player(stream);
-        return send(packet, channel);
+        return send(packet);
     }
 
     /**
      * @brief Send kill action packet
      *
      * @param other Other connection
-     * @param channel Channel
      * @return true On success
      */
-    bool send_kill_action(connection & other, std::uint8_t channel = 0)
+    bool send_kill_action(connection & other)
     {
-        packet packet(nullptr, packet::kill_action_size, false);
+        packet packet(nullptr, packet::kill_action_size, packet_type::kill_action);
         auto   stream = packet.stream();
         other.fill_kill_action(stream);
-        return send(packet, channel);
+        return send(packet);
+    }
+
+    /**
+     * @brief Send position data packet (moves the player to its server position)
+     *
+     * @return true on success
+     */
+    bool send_position_data()
+    {
+        packet packet(nullptr, packet::position_data_size, packet_type::position_data);
+        auto   stream = packet.stream();
+        stream.write_packet(packets::position_data { m_position });
+        return send(packet);
     }
 
     /**
@@ -216,15 +229,14 @@ class connection : public peer, public player_data
      *
      * @param source Source (enemy or block?)
      * @param weapon If true, source of the damage is a weapon
-     * @param channel Channel
      * @return true on success
      */
-    bool send_set_hp(const glm::vec3 & source, bool weapon, std::uint8_t channel = 0)
+    bool send_set_hp(const glm::vec3 & source, bool weapon)
     {
-        packet packet(nullptr, packet::set_hp_size, false);
+        packet packet(nullptr, packet::set_hp_size, packet_type::set_hp);
         auto   stream = packet.stream();
         fill_set_hp(stream, source, weapon);
-        return send(packet, channel);
+        return send(packet);
     }
 
     /**
@@ -236,10 +248,7 @@ class connection : public peer, public player_data
      */
     void fill_set_hp(data_stream & stream, const glm::vec3 & source, bool weapon)
     {
-        stream.write_type(packet_type::set_hp);
-        stream.write_byte(m_health);
-        stream.write_byte(weapon ? 1 : 0);
-        stream.write_vec3(source);
+        stream.write_packet(packets::set_hp { m_health, weapon, source });
     }
 
     /**
@@ -250,15 +259,8 @@ class connection : public peer, public player_data
      */
     std::uint32_t fill_existing_player(data_stream & stream) const
     {
-        stream.write_type(packet_type::existing_player);
-        stream.write_byte(m_id);
-        stream.write_type(m_team);
-        stream.write_type(m_weapon);
-        stream.write_type(m_tool);
-        stream.write_int(m_score.kills());
-        stream.write_color3b(m_color);
-        stream.write_array(m_name, m_name_length);
-        return 12 + m_name_length;
+        return static_cast<std::uint32_t>(stream.write_packet(
+            packets::existing_player { m_id, m_team, m_weapon, m_tool, m_score.kills(), m_color, { { m_name, m_name_length } } }));
     }
 
     /**
@@ -269,13 +271,7 @@ class connection : public peer, public player_data
      */
     std::uint32_t fill_create_player(data_stream & stream) const
     {
-        stream.write_type(packet_type::create_player);
-        stream.write_byte(m_id);
-        stream.write_type(m_weapon);
-        stream.write_type(m_team);
-        stream.write_vec3(m_position);
-        stream.write_array(m_name, m_name_length);
-        return 16 + m_name_length;
+        return static_cast<std::uint32_t>(stream.write_packet(packets::create_player { m_id, m_weapon, m_team, m_position, { { m_name, m_name_length } } }));
     }
 
     /**
@@ -285,8 +281,7 @@ class connection : public peer, public player_data
      */
     void fill_player_left(data_stream & stream) const
     {
-        stream.write_type(packet_type::player_left);
-        stream.write_byte(m_id);
+        stream.write_packet(packets::player_left { m_id });
     }
 
     /**
@@ -296,11 +291,7 @@ class connection : public peer, public player_data
      */
     void fill_kill_action(data_stream & stream) const
     {
-        stream.write_type(packet_type::kill_action);
-        stream.write_byte(m_id);
-        stream.write_byte(m_last_kill_killer);
-        stream.write_type(m_last_kill_type);
-        stream.write_byte(m_respawn_time);
+        stream.write_packet(packets::kill_action { m_id, m_last_kill_killer, m_last_kill_type, m_respawn_time });
     }
 
     /**
@@ -310,9 +301,7 @@ class connection : public peer, public player_data
      */
     void fill_set_tool(data_stream & stream) const
     {
-        stream.write_type(packet_type::set_tool);
-        stream.write_byte(m_id);
-        stream.write_type(m_tool);
+        stream.write_packet(packets::set_tool { m_id, m_tool });
     }
 
     /**
@@ -322,9 +311,7 @@ class connection : public peer, public player_data
      */
     void fill_set_color(data_stream & stream) const
     {
-        stream.write_type(packet_type::set_color);
-        stream.write_byte(m_id);
-        stream.write_color3b(m_color);
+        stream.write_packet(packets::set_color { m_id, m_color });
     }
 
     /**
@@ -334,9 +321,7 @@ class connection : public peer, public player_data
      */
     void fill_input_data(data_stream & stream) const
     {
-        stream.write_type(packet_type::input_data);
-        stream.write_byte(m_id);
-        stream.write_byte(input_to_byte());
+        stream.write_packet(packets::input_data { m_id, input_to_byte() });
     }
 
     /**
@@ -346,9 +331,7 @@ class connection : public peer, public player_data
      */
     void fill_weapon_input(data_stream & stream) const
     {
-        stream.write_type(packet_type::weapon_input);
-        stream.write_byte(m_id);
-        stream.write_byte(weapon_input_to_byte());
+        stream.write_packet(packets::weapon_input { m_id, weapon_input_to_byte() });
     }
 
     /**
@@ -361,11 +344,7 @@ class connection : public peer, public player_data
      */
     void fill_grenade_packet(data_stream & stream, const glm::vec3 & position, const glm::vec3 & velocity, float fuse) const
     {
-        stream.write_type(packet_type::grenade_packet);
-        stream.write_byte(m_id);
-        stream.write_float(fuse);
-        stream.write_vec3(position);
-        stream.write_vec3(velocity);
+        stream.write_packet(packets::grenade_packet { m_id, fuse, position, velocity });
     }
 
     /**
@@ -379,12 +358,7 @@ class connection : public peer, public player_data
      */
     void fill_block_action(data_stream & stream, std::uint32_t x, std::uint32_t y, std::uint32_t z, block_action_type action) const
     {
-        stream.write_type(packet_type::block_action);
-        stream.write_byte(m_id);
-        stream.write_type(action);
-        stream.write_int(x);
-        stream.write_int(y);
-        stream.write_int(z);
+        stream.write_packet(packets::block_action { m_id, action, { x, y, z } });
     }
 
     /**
@@ -396,10 +370,7 @@ class connection : public peer, public player_data
      */
     void fill_block_line(data_stream & stream, const glm::uvec3 & start, const glm::uvec3 & end) const
     {
-        stream.write_type(packet_type::block_line);
-        stream.write_byte(m_id);
-        stream.write_uvec3(start);
-        stream.write_uvec3(end);
+        stream.write_packet(packets::block_line { m_id, start, end });
     }
 
     /**
@@ -409,10 +380,7 @@ class connection : public peer, public player_data
      */
     void fill_weapon_reload(data_stream & stream) const
     {
-        stream.write_type(packet_type::weapon_reload);
-        stream.write_byte(m_id);
-        stream.write_byte(m_clip_ammo);
-        stream.write_byte(m_reserve_ammo);
+        stream.write_packet(packets::weapon_reload { m_id, m_clip_ammo, m_reserve_ammo });
     }
 
     /**
@@ -424,12 +392,7 @@ class connection : public peer, public player_data
      */
     std::size_t fill_chat_message(data_stream & stream, chat_type type, std::string_view message) const
     {
-        auto size = std::min(message.size(), std::size_t(256));
-        stream.write_type(packet_type::chat_message);
-        stream.write_byte(m_id);
-        stream.write_type(type);
-        stream.write_array(message.data(), size);
-        return size + 3;
+        return stream.write_packet(packets::chat_message { m_id, type, { message } });
     }
 
     /**
@@ -439,8 +402,7 @@ class connection : public peer, public player_data
      */
     void fill_restock(data_stream & stream) const
     {
-        stream.write_type(packet_type::restock);
-        stream.write_byte(m_id);
+        stream.write_packet(packets::restock { m_id });
     }
 
     /**
@@ -451,9 +413,7 @@ class connection : public peer, public player_data
      */
     void fill_intel_capture(data_stream & stream, bool winning) const
     {
-        stream.write_type(packet_type::intel_capture);
-        stream.write_byte(m_id);
-        stream.write_byte(winning ? 1 : 0);
+        stream.write_packet(packets::intel_capture { m_id, winning });
     }
 
     /**
@@ -463,8 +423,7 @@ class connection : public peer, public player_data
      */
     void fill_intel_pickup(data_stream & stream) const
     {
-        stream.write_type(packet_type::intel_pickup);
-        stream.write_byte(m_id);
+        stream.write_packet(packets::intel_pickup { m_id });
     }
 
     /**
@@ -475,14 +434,13 @@ class connection : public peer, public player_data
      */
     void fill_intel_drop(data_stream & stream, const glm::uvec3 & position) const
     {
-        stream.write_type(packet_type::intel_drop);
-        stream.write_byte(m_id);
-        stream.write_uvec3(position);
+        stream.write_packet(packets::intel_drop { m_id, position });
     }
 
   protected:
 
     state_type m_state { state_type::disconnected }; //!< Connection state (used by protocol)
+    map_pacer  m_map_pacer;                          //!< Map download pacing
 };
 
 } // namespace spadesx
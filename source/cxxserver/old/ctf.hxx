@@ -113,6 +113,7 @@ class ctf_protocol : public protocol
         get_spawn_location(team_type::b, m_teams[1].base());
         get_spawn_location(team_type::a, m_teams[0].intel());
         get_spawn_location(team_type::b, m_teams[1].intel());
+        update_triggers();
     }
 
     void on_kill(connection & killer, connection & victim, kill_type type, std::uint8_t respawn_time) override
@@ -149,6 +150,7 @@ class ctf_protocol : public protocol
     void pickup_intel(ctf_team_data & team, const connection & enemy)
     {
         team.intel().pick(enemy);
+        update_triggers();
         broadcast_intel_pickup(enemy);
     }
 
@@ -163,7 +165,7 @@ class ctf_protocol : public protocol
     {
         if (!enemy_team.intel().is_taken())
         {
-            if (enemy_team.intel().distance(source) <= m_intel_pickup_distance)
+            if (m_spatial.is_inside(source.id(), enemy_team.intel().id()))
             {
                 pickup_intel(enemy_team, source);
                 return true;
@@ -191,6 +193,7 @@ class ctf_protocol : public protocol
         {
             enemy_team.intel().drop(position);
         }
+        update_triggers();
         broadcast_intel_drop(source, enemy_team.intel().m_position);
     }
 
@@ -224,6 +227,7 @@ class ctf_protocol : public protocol
     {
         source.score().increase();
         enemy_team.intel().drop(position);
+        update_triggers();
         broadcast_intel_capture(source, team.score().increase().has_reached(m_score_limit));
         broadcast_move_object(enemy_team.intel().id(), enemy_team.team(), position);
     }
@@ -240,7 +244,7 @@ class ctf_protocol : public protocol
     {
         if (enemy_team.intel().is_held_by(source))
         {
-            if (team.base().distance(source) <= m_base_trigger_distance)
+            if (m_spatial.is_inside(source.id(), team.base().id()))
             {
                 get_spawn_location(enemy_team.team(), enemy_team.intel());
                 capture_intel(source, team, enemy_team, enemy_team.intel().m_position);
@@ -276,11 +280,6 @@ class ctf_protocol : public protocol
 
                 auto & enemy_team = get_enemy_team(connection.team());
 
-                if (check_and_pickup_intel(connection, enemy_team))
-                {
-                    std::cout << "[  LOG  ]: intel taken by " << connection.name() << std::endl;
-                }
-
                 if (check_and_capture_intel(connection, team, enemy_team))
                 {
                     std::cout << "[  LOG  ]: intel captured by " << connection.name() << std::endl;
@@ -293,6 +292,25 @@ class ctf_protocol : public protocol
         }
     }
 
+    /**
+     * @brief On trigger enter or exit (intel pickup)
+     *
+     * @param connection Connection
+     * @param trigger Trigger (object ID)
+     * @param enter Entered (true) or left (false)
+     */
+    void on_trigger(connection & connection, std::uint8_t trigger, bool enter) override
+    {
+        if (enter && connection.m_alive && connection.team() != team_type::spectator)
+        {
+            auto & enemy_team = get_enemy_team(connection.team());
+            if (trigger == enemy_team.intel().id() && check_and_pickup_intel(connection, enemy_team))
+            {
+                std::cout << "[  LOG  ]: intel taken by " << connection.name() << std::endl;
+            }
+        }
+    }
+
     /**
      * @brief Send state data
      *
@@ -411,6 +429,26 @@ class ctf_protocol : public protocol
         return flags;
     }
 
+    /**
+     * @brief Place intel and base triggers (taken intel has no trigger)
+     *
+     */
+    void update_triggers()
+    {
+        for (auto & team : m_teams)
+        {
+            if (team.intel().is_taken())
+            {
+                m_spatial.disable_trigger(team.intel().id());
+            }
+            else
+            {
+                m_spatial.set_trigger(team.intel().id(), team.intel().m_position, m_intel_pickup_distance);
+            }
+            m_spatial.set_trigger(team.base().id(), team.base().m_position, m_base_trigger_distance);
+        }
+    }
+
   private:
 
     std::uint8_t                 m_score_limit { 10 };
@@ -7,6 +7,7 @@
 
 #include "../map.hxx"
 #include "player.hxx"
+#include "ray.hxx"
 
 namespace spadesx {
 
@@ -27,15 +28,37 @@ class grenade : public entity
      * @param fuse Initial fuse time
      */
     grenade(const player_data & source, const glm::vec3 & position, const glm::vec3 & velocity, float fuse)
-        : entity { entity_type::grenade, source.id(), source.team(), position }
+        : grenade { source.id(), source.team(), position, velocity, fuse }
+    {
+    }
+
+    /**
+     * @brief Construct a new grenade object
+     *
+     * @param owner Source player ID
+     * @param team Source player team
+     * @param position Initial position
+     * @param velocity Initial velocity
+     * @param fuse Initial fuse time
+     */
+    grenade(std::uint8_t owner, team_type team, const glm::vec3 & position, const glm::vec3 & velocity, float fuse)
+        : entity { entity_type::grenade, owner, team, position }
         , m_velocity { velocity }
         , m_fuse { fuse }
     {
     }
 
+    static constexpr const int   max_bounces = 4;      //!< Max bounces in a single update
+    static constexpr const float restitution = 0.36F;  //!< Velocity kept after a bounce
+    static constexpr const float separation  = 0.001F; //!< Distance kept from the hit face
+
     /**
      * @brief Update grenade position
      *
+     * The path is swept through the voxel grid, so grenades neither tunnel through thin walls nor
+     * bounce back a whole step. A bounce happens at the exact time of impact, reflects velocity on
+     * the normal of the hit face and the rest of the step continues with the reflected velocity.
+     *
      * @param map Map
      * @param delta Delta time
      */
@@ -44,37 +67,42 @@ class grenade : public entity
         // Update fuse time
         m_fuse -= delta;
 
-        // Update postion
-
-        glm::vec3 prev = m_position;
-        float     dt   = delta * 32.F;
+        float     dt       = delta * 32.F;
+        glm::vec3 velocity = m_velocity;
 
-        m_velocity.z   += delta;
-        m_position     += m_velocity * dt;
+        // constant gravity, average velocity gives the exact displacement at any delta
+        m_velocity.z += delta;
+        move(map, m_position, m_velocity, (velocity + m_velocity) * (0.5F * dt), dt);
+    }
 
-        glm::ivec3 b   = glm::floor(m_position);
-        if (map.is_clip_world(b.x, b.y, b.z))
+    /**
+     * @brief Move along displacement and bounce off the blocks on the way
+     *
+     * @param map Map
+     * @param position Position
+     * @param velocity Velocity (after gravity)
+     * @param displacement Displacement of the whole step
+     * @param dt Step length (delta * 32)
+     */
+    static void move(const map & map, glm::vec3 & position, glm::vec3 & velocity, glm::vec3 displacement, float dt)
+    {
+        ray::sweep_hit hit {};
+        float          remaining = 1.F; // fraction of the step left
+        for (int bounce = 0; bounce <= max_bounces; ++bounce)
         {
-            glm::ivec3 a = glm::floor(prev);
-
-            if (b.z != a.z && ((b.x == a.x && b.y == a.y) || !map.is_clip_world(b.x, b.y, a.z)))
-            {
-                m_velocity.z = -m_velocity.z;
-            }
-            else if (b.x != a.x && ((b.y == a.y && b.z == a.z) || !map.is_clip_world(a.x, b.y, b.z)))
+            glm::vec3 target = position + displacement;
+            if (!ray::sweep(map, position, target, hit))
             {
-                m_velocity.x = -m_velocity.x;
+                position = target;
+                return;
             }
-            else if (b.y != a.y && ((b.x == a.x && b.z == a.z) || !map.is_clip_world(b.x, a.y, b.z)))
-            {
-                m_velocity.y = -m_velocity.y;
-            }
-
-            // FIXME: Does not work with low TPS
-            // if TPS is too low, grenade bounces back too far
 
-            m_position = prev;
-            m_velocity *= 0.36F;
+            auto axis      = hit.normal.x != 0 ? 0 : (hit.normal.y != 0 ? 1 : 2);
+            position       += displacement * hit.time + glm::vec3 { hit.normal } * separation;
+            velocity[axis] = -velocity[axis];
+            velocity       *= restitution;
+            remaining      *= 1.F - hit.time;
+            displacement   = velocity * (dt * remaining);
         }
     }
 
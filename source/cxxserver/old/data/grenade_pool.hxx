@@ -0,0 +1,245 @@
+/**
+ * @file grenade_pool.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include "grenade.hxx"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <smmintrin.h>
+#include <vector>
+
+namespace spadesx {
+
+/**
+ * @brief Fixed capacity pool of active grenades (structure of arrays)
+ *
+ * Grenades are stored contiguously and removed by swapping with the last one, so throwing and
+ * exploding never allocates. Gravity and fuse are integrated four grenades per SSE register,
+ * only grenades leaving their block are swept through the map one by one. Expired grenades are
+ * moved into an explosion buffer which is processed after the step.
+ *
+ */
+class grenade_pool
+{
+  public:
+
+    static constexpr const std::size_t capacity = 256; //!< Max active grenades
+
+    /**
+     * @brief Construct a new grenade_pool object
+     *
+     */
+    grenade_pool()
+    {
+        m_explosions.reserve(capacity);
+    }
+
+    /**
+     * @brief Add grenade
+     *
+     * @param owner Source player ID
+     * @param team Source player team
+     * @param position Initial position
+     * @param velocity Initial velocity
+     * @param fuse Initial fuse time
+     * @return false If the pool is full
+     */
+    bool add(std::uint8_t owner, team_type team, const glm::vec3 & position, const glm::vec3 & velocity, float fuse) noexcept
+    {
+        if (m_count == capacity)
+        {
+            return false;
+        }
+        auto index     = m_count++;
+        m_px[index]    = position.x;
+        m_py[index]    = position.y;
+        m_pz[index]    = position.z;
+        m_vx[index]    = velocity.x;
+        m_vy[index]    = velocity.y;
+        m_vz[index]    = velocity.z;
+        m_fuse[index]  = fuse;
+        m_owner[index] = owner;
+        m_team[index]  = team;
+        return true;
+    }
+
+    /**
+     * @brief Move all grenades and emit the expired ones into the explosion buffer
+     *
+     * @param map Map
+     * @param delta Delta time
+     */
+    void update(const map & map, float delta)
+    {
+        const float dt = delta * 32.F;
+
+        std::array<std::uint32_t, capacity / 32> crossing {};
+        for (std::size_t group = 0; group < m_count; group += 4)
+        {
+            crossing[group / 32] |= integrate(group, delta, dt) << (group % 32);
+        }
+
+        // grenades leaving their block may bounce
+        for (std::size_t word = 0; word < crossing.size(); ++word)
+        {
+            for (auto bits = crossing[word]; bits != 0; bits &= bits - 1)
+            {
+                auto      index = word * 32 + std::size_t(std::countr_zero(bits));
+                glm::vec3 position { m_px[index], m_py[index], m_pz[index] };
+                glm::vec3 velocity { m_vx[index], m_vy[index], m_vz[index] };
+                grenade::move(map, position, velocity, { m_dx[index], m_dy[index], m_dz[index] }, dt);
+                m_px[index] = position.x;
+                m_py[index] = position.y;
+                m_pz[index] = position.z;
+                m_vx[index] = velocity.x;
+                m_vy[index] = velocity.y;
+                m_vz[index] = velocity.z;
+            }
+        }
+
+        for (std::size_t index = 0; index < m_count;)
+        {
+            if (m_fuse[index] <= 0.F)
+            {
+                m_explosions.emplace_back(at(index));
+                remove(index);
+            }
+            else
+            {
+                ++index;
+            }
+        }
+    }
+
+    /**
+     * @brief Get grenades which exploded since the last clear_explosions
+     *
+     * @return Explosions
+     */
+    [[nodiscard]] const std::vector<grenade> & explosions() const noexcept
+    {
+        return m_explosions;
+    }
+
+    /**
+     * @brief Clear explosion buffer
+     *
+     */
+    void clear_explosions() noexcept
+    {
+        m_explosions.clear();
+    }
+
+    /**
+     * @brief Get grenade at index
+     *
+     * @param index Index
+     * @return Grenade
+     */
+    [[nodiscard]] grenade at(std::size_t index) const
+    {
+        return { m_owner[index], m_team[index], { m_px[index], m_py[index], m_pz[index] }, { m_vx[index], m_vy[index], m_vz[index] }, m_fuse[index] };
+    }
+
+    /**
+     * @brief Get number of active grenades
+     *
+     * @return Number of active grenades
+     */
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return m_count;
+    }
+
+  private:
+
+    using float_array = std::array<float, capacity>;
+
+    /**
+     * @brief Integrate fuse and gravity of four grenades
+     *
+     * Grenades staying in their block are moved, the others keep their position and get their
+     * displacement stored for the sweep.
+     *
+     * @param group First grenade index
+     * @param delta Delta time
+     * @param dt Step length (delta * 32)
+     * @return Grenades leaving their block (bit per lane)
+     */
+    std::uint32_t integrate(std::size_t group, float delta, float dt) noexcept
+    {
+        const __m128 half = _mm_set1_ps(0.5F * dt);
+
+        _mm_store_ps(&m_fuse[group], _mm_sub_ps(_mm_load_ps(&m_fuse[group]), _mm_set1_ps(delta)));
+
+        // constant gravity, average velocity gives the exact displacement at any delta
+        __m128 vx = _mm_load_ps(&m_vx[group]);
+        __m128 vy = _mm_load_ps(&m_vy[group]);
+        __m128 vz = _mm_load_ps(&m_vz[group]);
+        __m128 nz = _mm_add_ps(vz, _mm_set1_ps(delta));
+        __m128 dx = _mm_mul_ps(_mm_add_ps(vx, vx), half);
+        __m128 dy = _mm_mul_ps(_mm_add_ps(vy, vy), half);
+        __m128 dz = _mm_mul_ps(_mm_add_ps(vz, nz), half);
+        _mm_store_ps(&m_vz[group], nz);
+
+        __m128 px    = _mm_load_ps(&m_px[group]);
+        __m128 py    = _mm_load_ps(&m_py[group]);
+        __m128 pz    = _mm_load_ps(&m_pz[group]);
+        __m128 tx    = _mm_add_ps(px, dx);
+        __m128 ty    = _mm_add_ps(py, dy);
+        __m128 tz    = _mm_add_ps(pz, dz);
+        __m128 stays = _mm_and_ps(_mm_cmpeq_ps(_mm_floor_ps(px), _mm_floor_ps(tx)),
+                                  _mm_and_ps(_mm_cmpeq_ps(_mm_floor_ps(py), _mm_floor_ps(ty)), _mm_cmpeq_ps(_mm_floor_ps(pz), _mm_floor_ps(tz))));
+
+        _mm_store_ps(&m_px[group], _mm_blendv_ps(px, tx, stays));
+        _mm_store_ps(&m_py[group], _mm_blendv_ps(py, ty, stays));
+        _mm_store_ps(&m_pz[group], _mm_blendv_ps(pz, tz, stays));
+        _mm_store_ps(&m_dx[group], dx);
+        _mm_store_ps(&m_dy[group], dy);
+        _mm_store_ps(&m_dz[group], dz);
+
+        auto valid = m_count - group >= 4 ? 0x0FU : (1U << (m_count - group)) - 1U;
+        return ~static_cast<std::uint32_t>(_mm_movemask_ps(stays)) & valid;
+    }
+
+    /**
+     * @brief Remove grenade (the last grenade takes its place)
+     *
+     * @param index Index
+     */
+    void remove(std::size_t index) noexcept
+    {
+        auto last      = --m_count;
+        m_px[index]    = m_px[last];
+        m_py[index]    = m_py[last];
+        m_pz[index]    = m_pz[last];
+        m_vx[index]    = m_vx[last];
+        m_vy[index]    = m_vy[last];
+        m_vz[index]    = m_vz[last];
+        m_fuse[index]  = m_fuse[last];
+        m_owner[index] = m_owner[last];
+        m_team[index]  = m_team[last];
+    }
+
+    alignas(16) float_array            m_px {};       //!< Positions (x)
+    alignas(16) float_array            m_py {};       //!< Positions (y)
+    alignas(16) float_array            m_pz {};       //!< Positions (z)
+    alignas(16) float_array            m_vx {};       //!< Velocities (x)
+    alignas(16) float_array            m_vy {};       //!< Velocities (y)
+    alignas(16) float_array            m_vz {};       //!< Velocities (z)
+    alignas(16) float_array            m_dx {};       //!< Displacements of the current step (x)
+    alignas(16) float_array            m_dy {};       //!< Displacements of the current step (y)
+    alignas(16) float_array            m_dz {};       //!< Displacements of the current step (z)
+    alignas(16) float_array            m_fuse {};     //!< Fuse times
+    std::array<std::uint8_t, capacity> m_owner {};    //!< Source player IDs
+    std::array<team_type, capacity>    m_team {};     //!< Source player teams
+    std::size_t                        m_count { 0 }; //!< Number of active grenades
+    std::vector<grenade>               m_explosions;  //!< Explosions not processed yet
+};
+
+} // namespace spadesx
@@ -0,0 +1,151 @@
+/**
+ * @file hitbox.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include "enums.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <limits>
+
+namespace spadesx {
+
+/**
+ * @brief Player hitboxes
+ *
+ * Boxes are given in the local frame of the player: x points forward (horizontal orientation),
+ * y to the right and z down (same as the map), the origin is the player position (eye). The
+ * boxes approximate the voxel model of the client.
+ *
+ */
+class hitbox
+{
+  public:
+
+    static constexpr const std::size_t count = 4; //!< Boxes per player
+
+    /**
+     * @brief Axis aligned box in the local frame
+     *
+     */
+    struct box
+    {
+        hit_type  type; //!< Hit type
+        glm::vec3 min;  //!< Minimum corner
+        glm::vec3 max;  //!< Maximum corner
+    };
+
+    using box_array = std::array<box, count>;
+
+    /**
+     * @brief Ray cast result
+     *
+     */
+    struct result
+    {
+        std::uint8_t mask { 0 };                                     //!< Hit boxes (bit per hit_type)
+        hit_type     type { hit_type::torso };                       //!< Nearest hit box
+        float        distance { std::numeric_limits<float>::max() }; //!< Distance to the nearest hit box
+    };
+
+    static constexpr const box_array standing {
+        box { hit_type::head, { -0.4F, -0.4F, -0.45F }, { 0.4F, 0.4F, 0.35F } },
+        box { hit_type::torso, { -0.35F, -0.45F, 0.35F }, { 0.35F, 0.45F, 1.4F } },
+        box { hit_type::arms, { 0.35F, -0.6F, 0.35F }, { 1.F, 0.6F, 0.9F } },
+        box { hit_type::legs, { -0.35F, -0.45F, 1.4F }, { 0.35F, 0.45F, 2.7F } },
+    }; //!< Standing player
+
+    static constexpr const box_array crouching {
+        box { hit_type::head, { -0.4F, -0.4F, -0.45F }, { 0.4F, 0.4F, 0.35F } },
+        box { hit_type::torso, { -0.35F, -0.45F, 0.35F }, { 0.35F, 0.45F, 1.F } },
+        box { hit_type::arms, { 0.35F, -0.6F, 0.35F }, { 1.F, 0.6F, 0.9F } },
+        box { hit_type::legs, { -0.35F, -0.45F, 1.F }, { 0.35F, 0.45F, 1.8F } },
+    }; //!< Crouching player
+
+    /**
+     * @brief Get horizontal forward axis of orientation
+     *
+     * @param orientation Orientation
+     * @return Normalized forward axis (x, y)
+     */
+    static glm::vec2 forward(const glm::vec3 & orientation) noexcept
+    {
+        float length = std::sqrt(orientation.x * orientation.x + orientation.y * orientation.y);
+        if (length < 1e-6F)
+        {
+            return { 1.F, 0.F };
+        }
+        return { orientation.x / length, orientation.y / length };
+    }
+
+    /**
+     * @brief Intersect ray with box (slab test)
+     *
+     * @param origin Ray origin (local frame)
+     * @param inverse Inverse ray direction (local frame)
+     * @param min Minimum corner
+     * @param max Maximum corner
+     * @param distance Entry distance (along the ray)
+     * @return true If the ray hits the box in front of the origin
+     */
+    static bool intersect(const glm::vec3 & origin, const glm::vec3 & inverse, const glm::vec3 & min, const glm::vec3 & max, float & distance) noexcept
+    {
+        glm::vec3 t0    = (min - origin) * inverse;
+        glm::vec3 t1    = (max - origin) * inverse;
+        glm::vec3 tmin  = glm::min(t0, t1);
+        glm::vec3 tmax  = glm::max(t0, t1);
+        float     enter = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.F));
+        float     exit  = std::min(std::min(tmax.x, tmax.y), tmax.z);
+        distance        = enter;
+        return enter <= exit;
+    }
+
+    /**
+     * @brief Cast ray against the boxes of a player
+     *
+     * @param origin Ray origin
+     * @param direction Normalized ray direction
+     * @param position Player position
+     * @param orientation Player orientation
+     * @param crouch Player is crouching
+     * @param tolerance Boxes are grown by tolerance on every side
+     * @return Result
+     */
+    static result cast(const glm::vec3 & origin,
+                       const glm::vec3 & direction,
+                       const glm::vec3 & position,
+                       const glm::vec3 & orientation,
+                       bool              crouch,
+                       float             tolerance) noexcept
+    {
+        auto      axis = forward(orientation);
+        glm::vec3 offset { origin - position };
+        glm::vec3 local_origin { offset.x * axis.x + offset.y * axis.y, offset.y * axis.x - offset.x * axis.y, offset.z };
+        glm::vec3 local_direction { direction.x * axis.x + direction.y * axis.y, direction.y * axis.x - direction.x * axis.y, direction.z };
+        glm::vec3 inverse = 1.F / local_direction;
+
+        result hits;
+        for (const auto & box : crouch ? crouching : standing)
+        {
+            float distance;
+            if (intersect(local_origin, inverse, box.min - tolerance, box.max + tolerance, distance))
+            {
+                hits.mask |= std::uint8_t(1U << static_cast<std::uint8_t>(box.type));
+                if (distance < hits.distance)
+                {
+                    hits.distance = distance;
+                    hits.type     = box.type;
+                }
+            }
+        }
+        return hits;
+    }
+};
+
+} // namespace spadesx
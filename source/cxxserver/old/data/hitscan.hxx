@@ -0,0 +1,305 @@
+/**
+ * @file hitscan.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include "hitbox.hxx"
+#include "position_history.hxx"
+#include "ray.hxx"
+#include "weapon.hxx"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <smmintrin.h>
+#include <span>
+
+namespace spadesx {
+
+/**
+ * @brief Authoritative hitscan against the hitboxes of all players
+ *
+ * Player frames and boxes are stored as structure of arrays, a ray is tested against four players
+ * per SSE register (all boxes of a lane at once), so one ray costs eight groups instead of 32
+ * scalar casts. Only the nearest hit is then checked for occlusion by walking the map up to it.
+ *
+ */
+class hitscan
+{
+  public:
+
+    static constexpr const std::size_t max_players = 32; //!< Number of slots
+
+    /**
+     * @brief Nearest player hit by a ray
+     *
+     */
+    struct hit
+    {
+        std::uint8_t player;   //!< Player ID
+        hit_type     type;     //!< Hit box
+        float        distance; //!< Distance along the ray
+    };
+
+    /**
+     * @brief Remove all players
+     *
+     */
+    void clear() noexcept
+    {
+        m_active = 0;
+    }
+
+    /**
+     * @brief Place player
+     *
+     * @param id Player ID
+     * @param position Position
+     * @param orientation Orientation
+     * @param crouch Crouching state
+     */
+    void set(std::uint8_t id, const glm::vec3 & position, const glm::vec3 & orientation, bool crouch) noexcept
+    {
+        auto forward = hitbox::forward(orientation);
+        m_px[id]     = position.x;
+        m_py[id]     = position.y;
+        m_pz[id]     = position.z;
+        m_fx[id]     = forward.x;
+        m_fy[id]     = forward.y;
+
+        const auto & boxes = crouch ? hitbox::crouching : hitbox::standing;
+        for (std::size_t index = 0; index < hitbox::count; ++index)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                m_min[index][axis][id] = boxes[index].min[axis];
+                m_max[index][axis][id] = boxes[index].max[axis];
+            }
+        }
+        m_active |= 1U << id;
+    }
+
+    /**
+     * @brief Place all players alive some time ago
+     *
+     * @param history Position history
+     * @param seconds Time to go back
+     */
+    void load(const position_history & history, float seconds) noexcept
+    {
+        clear();
+        for (std::size_t id = 0; id < max_players; ++id)
+        {
+            const auto * sample = history.rewind(static_cast<std::uint8_t>(id), seconds);
+            if (sample != nullptr && sample->alive)
+            {
+                set(static_cast<std::uint8_t>(id), sample->position, sample->orientation, sample->crouching);
+            }
+        }
+    }
+
+    /**
+     * @brief Cast ray against all players and the map
+     *
+     * @param map Map
+     * @param origin Ray origin
+     * @param direction Normalized ray direction
+     * @param ignore Players not tested (bit per ID)
+     * @param tolerance Boxes are grown by tolerance on every side
+     * @return Nearest visible hit (nothing if no player was hit or the hit is occluded)
+     */
+    [[nodiscard]] std::optional<hit>
+    cast(const map & map, const glm::vec3 & origin, const glm::vec3 & direction, std::uint32_t ignore, float tolerance) const
+    {
+        std::array<std::optional<hit>, 1> hits;
+        cast_batch(map, origin, std::span { &direction, 1 }, ignore, tolerance, hits);
+        return hits[0];
+    }
+
+    /**
+     * @brief Cast rays sharing one origin (shotgun pellets)
+     *
+     * The origin is transformed into the frame of every player once for the whole batch.
+     *
+     * @param map Map
+     * @param origin Ray origin
+     * @param directions Normalized ray directions
+     * @param ignore Players not tested (bit per ID)
+     * @param tolerance Boxes are grown by tolerance on every side
+     * @param hits Nearest visible hit of every ray (same size as directions)
+     */
+    void cast_batch(const map &                   map,
+                    const glm::vec3 &             origin,
+                    std::span<const glm::vec3>    directions,
+                    std::uint32_t                 ignore,
+                    float                         tolerance,
+                    std::span<std::optional<hit>> hits) const
+    {
+        const std::uint32_t active = m_active & ~ignore;
+
+        alignas(16) float_array ox;
+        alignas(16) float_array oy;
+        alignas(16) float_array oz;
+        for (std::size_t group = 0; group < max_players; group += 4)
+        {
+            if (((active >> group) & 0x0FU) != 0)
+            {
+                local_origin(group, origin, ox, oy, oz);
+            }
+        }
+
+        for (std::size_t index = 0; index < directions.size(); ++index)
+        {
+            auto nearest = cast_players(active, directions[index], ox, oy, oz, tolerance);
+            if (nearest)
+            {
+                ray::sweep_hit block {};
+                if (ray::sweep(map, origin, origin + directions[index] * nearest->distance, block))
+                {
+                    nearest.reset(); // occluded
+                }
+            }
+            hits[index] = nearest;
+        }
+    }
+
+    /**
+     * @brief Sum damage of hits per player
+     *
+     * @param weapon Weapon
+     * @param hits Hits
+     * @return Damage per player ID
+     */
+    [[nodiscard]] static std::array<std::uint16_t, max_players> damage(weapon_type weapon, std::span<const std::optional<hit>> hits) noexcept
+    {
+        std::array<std::uint16_t, max_players> result {};
+        for (const auto & hit : hits)
+        {
+            if (hit)
+            {
+                result[hit->player] += weapons::get(weapon).get_damage(hit->type);
+            }
+        }
+        return result;
+    }
+
+  private:
+
+    using float_array = std::array<float, max_players>;
+    using box_array   = std::array<std::array<float_array, 3>, hitbox::count>;
+
+    /**
+     * @brief Transform origin into the local frames of four players
+     *
+     * @param group First player ID
+     * @param origin Origin
+     * @param ox Local origins (x)
+     * @param oy Local origins (y)
+     * @param oz Local origins (z)
+     */
+    void local_origin(std::size_t group, const glm::vec3 & origin, float_array & ox, float_array & oy, float_array & oz) const noexcept
+    {
+        __m128 x  = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_load_ps(&m_px[group]));
+        __m128 y  = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_load_ps(&m_py[group]));
+        __m128 z  = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_load_ps(&m_pz[group]));
+        __m128 fx = _mm_load_ps(&m_fx[group]);
+        __m128 fy = _mm_load_ps(&m_fy[group]);
+        _mm_store_ps(&ox[group], _mm_add_ps(_mm_mul_ps(x, fx), _mm_mul_ps(y, fy)));
+        _mm_store_ps(&oy[group], _mm_sub_ps(_mm_mul_ps(y, fx), _mm_mul_ps(x, fy)));
+        _mm_store_ps(&oz[group], z);
+    }
+
+    /**
+     * @brief Find the nearest box hit by a ray (same as hitbox::cast for every player)
+     *
+     * @param active Tested players (bit per ID)
+     * @param direction Normalized ray direction
+     * @param ox Local origins (x)
+     * @param oy Local origins (y)
+     * @param oz Local origins (z)
+     * @param tolerance Box growth
+     * @return Nearest hit (ties go to the lower ID)
+     */
+    [[nodiscard]] std::optional<hit> cast_players(std::uint32_t       active,
+                                                  const glm::vec3 &   direction,
+                                                  const float_array & ox,
+                                                  const float_array & oy,
+                                                  const float_array & oz,
+                                                  float               tolerance) const noexcept
+    {
+        const __m128 grow = _mm_set1_ps(tolerance);
+        const __m128 zero = _mm_setzero_ps();
+
+        std::optional<hit> nearest;
+        for (std::size_t group = 0; group < max_players; group += 4)
+        {
+            auto lanes = (active >> group) & 0x0FU;
+            if (lanes == 0)
+            {
+                continue;
+            }
+
+            __m128 fx = _mm_load_ps(&m_fx[group]);
+            __m128 fy = _mm_load_ps(&m_fy[group]);
+            __m128 dx = _mm_set1_ps(direction.x);
+            __m128 dy = _mm_set1_ps(direction.y);
+            __m128 ix = _mm_div_ps(_mm_set1_ps(1.F), _mm_add_ps(_mm_mul_ps(dx, fx), _mm_mul_ps(dy, fy)));
+            __m128 iy = _mm_div_ps(_mm_set1_ps(1.F), _mm_sub_ps(_mm_mul_ps(dy, fx), _mm_mul_ps(dx, fy)));
+            __m128 iz = _mm_set1_ps(1.F / direction.z);
+            __m128 lx = _mm_load_ps(&ox[group]);
+            __m128 ly = _mm_load_ps(&oy[group]);
+            __m128 lz = _mm_load_ps(&oz[group]);
+
+            __m128 best = _mm_set1_ps(std::numeric_limits<float>::max());
+            __m128 type = _mm_setzero_ps();
+            for (std::size_t index = 0; index < hitbox::count; ++index)
+            {
+                const auto & min = m_min[index];
+                const auto & max = m_max[index];
+                __m128       x0  = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_load_ps(&min[0][group]), grow), lx), ix);
+                __m128       x1  = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_load_ps(&max[0][group]), grow), lx), ix);
+                __m128       y0  = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_load_ps(&min[1][group]), grow), ly), iy);
+                __m128       y1  = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_load_ps(&max[1][group]), grow), ly), iy);
+                __m128       z0  = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_load_ps(&min[2][group]), grow), lz), iz);
+                __m128       z1  = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_load_ps(&max[2][group]), grow), lz), iz);
+
+                __m128 enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(x0, x1), _mm_min_ps(y0, y1)), _mm_max_ps(_mm_min_ps(z0, z1), zero));
+                __m128 exit  = _mm_min_ps(_mm_min_ps(_mm_max_ps(x0, x1), _mm_max_ps(y0, y1)), _mm_max_ps(z0, z1));
+                __m128 win   = _mm_and_ps(_mm_cmple_ps(enter, exit), _mm_cmplt_ps(enter, best));
+
+                auto box_type = static_cast<int>(hitbox::standing[index].type);
+                best          = _mm_blendv_ps(best, enter, win);
+                type          = _mm_blendv_ps(type, _mm_castsi128_ps(_mm_set1_epi32(box_type)), win);
+            }
+
+            alignas(16) std::array<float, 4>        distances;
+            alignas(16) std::array<std::int32_t, 4> types;
+            _mm_store_ps(distances.data(), best);
+            _mm_store_si128(reinterpret_cast<__m128i *>(types.data()), _mm_castps_si128(type));
+            for (; lanes != 0; lanes &= lanes - 1)
+            {
+                auto lane = std::size_t(std::countr_zero(lanes));
+                if (distances[lane] < (nearest ? nearest->distance : std::numeric_limits<float>::max()))
+                {
+                    nearest = hit { static_cast<std::uint8_t>(group + lane), static_cast<hit_type>(types[lane]), distances[lane] };
+                }
+            }
+        }
+        return nearest;
+    }
+
+    alignas(16) float_array m_px {};        //!< Positions (x)
+    alignas(16) float_array m_py {};        //!< Positions (y)
+    alignas(16) float_array m_pz {};        //!< Positions (z)
+    alignas(16) float_array m_fx {};        //!< Forward axes (x)
+    alignas(16) float_array m_fy {};        //!< Forward axes (y)
+    alignas(16) box_array   m_min {};       //!< Box minimum corners (box, axis, player)
+    alignas(16) box_array   m_max {};       //!< Box maximum corners (box, axis, player)
+    std::uint32_t           m_active { 0 }; //!< Placed players (bit per ID)
+};
+
+} // namespace spadesx
@@ -0,0 +1,325 @@
+/**
+ * @file movement.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include "../map.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace spadesx {
+
+/**
+ * @brief Clip columns around a player box, cached for a single clip move
+ *
+ * Holds the clip masks of the 4x4 columns the box can touch during one step (3x3 are enough
+ * unless the box crosses a column boundary), so every clip test is a bit test on 128 bytes instead
+ * of a scattered map load. Tests outside the window fall back to the map.
+ *
+ */
+class collision_window
+{
+  public:
+
+    static constexpr const int size = 4; //!< Columns per side
+
+    /**
+     * @brief Construct a new collision_window object
+     *
+     * @param map Map
+     * @param x The x-coordinate of the first column
+     * @param y The y-coordinate of the first column
+     */
+    collision_window(const map & map, int x, int y)
+        : m_map { map }
+        , m_x { x }
+        , m_y { y }
+    {
+        for (int row = 0; row < size; ++row)
+        {
+            for (int column = 0; column < size; ++column)
+            {
+                auto index       = std::size_t(row * size + column);
+                m_columns[index] = map.clip_column(x + column, y + row);
+                if (x + column < 0 || x + column >= 512 || y + row < 0 || y + row >= 512)
+                {
+                    m_outside |= 1U << index;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Create window covering a player box moved by velocity
+     *
+     * @param map Map
+     * @param position Position
+     * @param velocity Velocity
+     * @param delta Delta time
+     * @return Window
+     */
+    static collision_window around(const map & map, const glm::vec3 & position, const glm::vec3 & velocity, float delta)
+    {
+        float modifier = delta * 32.F;
+        float next_x   = position.x + velocity.x * modifier;
+        float next_y   = position.y + velocity.y * modifier;
+        return { map, int(std::floor(std::min(position.x, next_x) - 0.45F)), int(std::floor(std::min(position.y, next_y) - 0.45F)) };
+    }
+
+    /**
+     * @brief Same as map::is_clip_box
+     *
+     * @param x The x-coordinate
+     * @param y The y-coordinate
+     * @param z The z-coordinate
+     * @return true If the block is solid or out of bounds
+     */
+    [[nodiscard]] bool is_clip_box(float x, float y, float z) const
+    {
+        auto column = int(std::floor(x)) - m_x;
+        auto row    = int(std::floor(y)) - m_y;
+        if (static_cast<unsigned>(column) >= size || static_cast<unsigned>(row) >= size)
+        {
+            return m_map.is_clip_box(x, y, z);
+        }
+        auto height = int(std::floor(z));
+        if (height >= 64)
+        {
+            return true;
+        }
+        auto index = std::size_t(row * size + column);
+        if (height < 0)
+        {
+            return ((m_outside >> index) & 1U) != 0;
+        }
+        return ((m_columns[index] >> height) & 1U) != 0;
+    }
+
+  private:
+
+    const map &                            m_map;           //!< Map (outside of the window)
+    int                                    m_x;             //!< First column (x)
+    int                                    m_y;             //!< First column (y)
+    std::array<std::uint64_t, size * size> m_columns {};    //!< Clip masks (row major)
+    std::uint32_t                          m_outside { 0 }; //!< Columns out of bounds (bit per column)
+};
+
+/**
+ * @brief Calculate clip move of a player box (shared by player_data and player_store)
+ *
+ * @param window Collision window around the box
+ * @param position Position
+ * @param velocity Velocity
+ * @param orientation_z Vertical orientation
+ * @param crouching Crouching state
+ * @param sprint Sprint input
+ * @param wade Is player in water
+ * @param gliding Is player in the air
+ * @param delta Delta time
+ */
+inline void box_clip_move(const collision_window & window,
+                          glm::vec3 &              position,
+                          glm::vec3 &              velocity,
+                          float                    orientation_z,
+                          bool                     crouching,
+                          bool                     sprint,
+                          bool &                   wade,
+                          bool &                   gliding,
+                          float                    delta)
+{
+    bool  climb    = false;
+    float modifier = delta * 32.F;
+    float offset;
+    float m;
+    float z;
+
+    if (crouching)
+    {
+        offset = 0.45F;
+        m      = 0.9F;
+    }
+    else
+    {
+        offset = 0.9F;
+        m      = 1.35F;
+    }
+
+    glm::vec3 next;
+    next.x = position.x + velocity.x * modifier;
+    next.y = position.y + velocity.y * modifier;
+    next.z = position.z + offset;
+
+    //
+    // check for X
+    //
+
+    z = m;
+
+    if (velocity.x < 0.F)
+    {
+        modifier = -0.45F;
+    }
+    else
+    {
+        modifier = 0.45F;
+    }
+
+    while (z >= -1.36F && //
+           !window.is_clip_box(next.x + modifier, position.y - 0.45F, next.z + z) && !window.is_clip_box(next.x + modifier, position.y + 0.45F, next.z + z))
+    {
+        z -= 0.9F;
+    }
+
+    if (z < -1.36F)
+    {
+        position.x = next.x;
+    }
+    else if (!crouching && orientation_z < 0.5F && !sprint)
+    {
+        z = 0.35F;
+        while (z >= -2.36F && //
+               !window.is_clip_box(next.x + modifier, position.y - 0.45F, next.z + z)
+               && !window.is_clip_box(next.x + modifier, position.y + 0.45F, next.z + z))
+        {
+            z -= 0.9F;
+        }
+        if (z < -2.36F)
+        {
+            position.x = next.x;
+            climb      = true;
+        }
+        else
+        {
+            velocity.x = 0.F;
+        }
+    }
+    else
+    {
+        velocity.x = 0.F;
+    }
+
+    //
+    // check for Y
+    //
+
+    z = m;
+
+    if (velocity.y < 0.F)
+    {
+        modifier = -0.45F;
+    }
+    else
+    {
+        modifier = 0.45F;
+    }
+
+    while (z >= -1.36F && //
+           !window.is_clip_box(position.x - 0.45F, next.y + modifier, next.z + z) && !window.is_clip_box(position.x + 0.45F, next.y + modifier, next.z + z))
+    {
+        z -= 0.9F;
+    }
+
+    if (z < -1.36F)
+    {
+        position.y = next.y;
+    }
+    else if (!crouching && orientation_z < 0.5F && !sprint && !climb)
+    {
+        z = 0.35F;
+        while (z >= -2.36F && //
+               !window.is_clip_box(position.x - 0.45F, next.y + modifier, next.z + z)
+               && !window.is_clip_box(position.x + 0.45F, next.y + modifier, next.z + z))
+        {
+            z -= 0.9F;
+        }
+        if (z < -2.36F)
+        {
+            position.y = next.y;
+            climb      = true;
+        }
+        else
+        {
+            velocity.y = 0.F;
+        }
+    }
+    else if (!climb)
+    {
+        velocity.y = 0.F;
+    }
+
+    //
+    // move z
+    //
+
+    if (climb)
+    {
+        velocity.x *= 0.5F;
+        velocity.y *= 0.5F;
+        next.z     -= 1.F;
+        m          = -1.35F;
+    }
+    else
+    {
+        if (velocity.z < 0.F)
+        {
+            m = -m;
+        }
+        next.z += velocity.z * delta * 32.F;
+    }
+
+    //
+    // check ground
+    //
+
+    gliding = true;
+
+    if (window.is_clip_box(position.x - 0.45F, position.y - 0.45F, next.z + m) || window.is_clip_box(position.x - 0.45F, position.y + 0.45F, next.z + m)
+        || window.is_clip_box(position.x + 0.45F, position.y - 0.45F, next.z + m)
+        || window.is_clip_box(position.x + 0.45F, position.y + 0.45F, next.z + m))
+    {
+        if (velocity.z >= 0.F)
+        {
+            wade    = position.z > 61.F;
+            gliding = false;
+        }
+        velocity.z = 0.F;
+    }
+    else
+    {
+        position.z = next.z - offset;
+    }
+}
+
+/**
+ * @brief Calculate clip move of a player box
+ *
+ * @param map Map
+ * @param position Position
+ * @param velocity Velocity
+ * @param orientation_z Vertical orientation
+ * @param crouching Crouching state
+ * @param sprint Sprint input
+ * @param wade Is player in water
+ * @param gliding Is player in the air
+ * @param delta Delta time
+ */
+inline void box_clip_move(const map & map,
+                          glm::vec3 & position,
+                          glm::vec3 & velocity,
+                          float       orientation_z,
+                          bool        crouching,
+                          bool        sprint,
+                          bool &      wade,
+                          bool &      gliding,
+                          float       delta)
+{
+    box_clip_move(collision_window::around(map, position, velocity, delta), position, velocity, orientation_z, crouching, sprint, wade, gliding, delta);
+}
+
+} // namespace spadesx
@@ -0,0 +1,132 @@
+/**
+ * @file movement_reconciler.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include "player.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace spadesx {
+
+/**
+ * @brief Compares reported positions with the server simulation
+ *
+ * Reported positions are kept until the next physics pass and compared with the simulated
+ * position of the player. Errors within the tolerance (base distance plus the distance covered at
+ * the current speed during the latency) are free, larger errors are charged to a per-player budget
+ * which recovers over time. Reports are accepted until the budget is exceeded, then the player
+ * keeps the simulated position and has to be corrected.
+ *
+ * All state is per player, so players of different ranges can be reconciled in parallel.
+ *
+ */
+class movement_reconciler
+{
+  public:
+
+    static constexpr const std::size_t max_players = 32; //!< Number of slots
+
+    /**
+     * @brief Set tolerance model
+     *
+     * @param tolerance Free error (blocks)
+     * @param budget Accumulated excess error before a correction (blocks)
+     * @param recovery Budget recovered per second (blocks)
+     */
+    void configure(float tolerance, float budget, float recovery) noexcept
+    {
+        m_tolerance = tolerance;
+        m_limit     = budget;
+        m_recovery  = recovery;
+    }
+
+    /**
+     * @brief Store reported position until the next physics pass
+     *
+     * @param id Player ID
+     * @param position Reported position
+     */
+    void report(std::uint8_t id, const glm::vec3 & position) noexcept
+    {
+        m_reported[id] = position;
+        m_pending[id]  = true;
+    }
+
+    /**
+     * @brief Reconcile player after the simulation step
+     *
+     * @param player Simulated player
+     * @param latency Age of the reported position (seconds)
+     * @param delta Step length (seconds)
+     * @return true If the report was rejected and the player has to be corrected
+     */
+    bool reconcile(player_data & player, float latency, float delta) noexcept
+    {
+        auto id        = player.id();
+        m_elapsed[id] += delta;
+        if (!m_pending[id])
+        {
+            return false;
+        }
+        m_pending[id] = false;
+
+        if (!player.m_alive)
+        {
+            m_budget[id] = 0.F;
+            return false;
+        }
+
+        float error   = glm::distance(m_reported[id], player.m_position);
+        float allowed = m_tolerance + glm::length(player.m_velocity) * 32.F * (latency + delta);
+        m_budget[id]  = std::max(m_budget[id] - m_recovery * m_elapsed[id], 0.F) + std::max(error - allowed, 0.F);
+        m_elapsed[id] = 0.F;
+
+        if (m_budget[id] > m_limit)
+        {
+            m_budget[id]    = 0.F;
+            m_error[id]     = error;
+            m_corrected[id] = true;
+            return true;
+        }
+        player.m_position = m_reported[id];
+        return false;
+    }
+
+    /**
+     * @brief Take pending correction of player
+     *
+     * @param id Player ID
+     * @param error Error of the rejected report
+     * @return true If the player has to be corrected
+     */
+    bool take_correction(std::uint8_t id, float & error) noexcept
+    {
+        if (!m_corrected[id])
+        {
+            return false;
+        }
+        m_corrected[id] = false;
+        error           = m_error[id];
+        return true;
+    }
+
+  private:
+
+    std::array<glm::vec3, max_players> m_reported {};       //!< Last reported positions
+    std::array<float, max_players>     m_budget {};         //!< Accumulated excess error
+    std::array<float, max_players>     m_elapsed {};        //!< Time since the last reconciled report
+    std::array<float, max_players>     m_error {};          //!< Error of the last rejected report
+    std::array<bool, max_players>      m_pending {};        //!< Report not reconciled yet
+    std::array<bool, max_players>      m_corrected {};      //!< Correction not sent yet
+    float                              m_tolerance { 1.F }; //!< Free error
+    float                              m_limit { 4.F };     //!< Budget
+    float                              m_recovery { 1.F };  //!< Budget recovery per second
+};
+
+} // namespace spadesx
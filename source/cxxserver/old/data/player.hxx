@@ -5,7 +5,9 @@
 
 #pragma once
 
+#include "color.hxx"
 #include "entity.hxx"
+#include "movement.hxx"
 #include "name.hxx"
 #include "score.hxx"
 #include "weapon.hxx"
@@ -54,171 +56,9 @@ class player_data : public entity, public name_data<16>
      * @param map Map
      * @param delta Delta time
      */
-    void box_clip_move(map & map, float delta)
+    void box_clip_move(const map & map, float delta)
     {
-        bool  climb    = false;
-        float modifier = delta * 32.F;
-        float offset;
-        float m;
-        float z;
-
-        if (m_crouching)
-        {
-            offset = 0.45F;
-            m      = 0.9F;
-        }
-        else
-        {
-            offset = 0.9F;
-            m      = 1.35F;
-        }
-
-        glm::vec3 next;
-        next.x = m_position.x + m_velocity.x * modifier;
-        next.y = m_position.y + m_velocity.y * modifier;
-        next.z = m_position.z + offset;
-
-        //
-        // check for X
-        //
-
-        z = m;
-
-        if (m_velocity.x < 0.F)
-        {
-            modifier = -0.45F;
-        }
-        else
-        {
-            modifier = 0.45F;
-        }
-
-        while (z >= -1.36F && //
-               !map.is_clip_box(next.x + modifier, m_position.y - 0.45F, next.z + z) && !map.is_clip_box(next.x + modifier, m_position.y + 0.45F, next.z + z))
-        {
-            z -= 0.9F;
-        }
-
-        if (z < -1.36F)
-        {
-            m_position.x = next.x;
-        }
-        else if (!m_crouching && m_orientation.z < 0.5F && !m_sprint)
-        {
-            z = 0.35F;
-            while (z >= -2.36F && //
-                   !map.is_clip_box(next.x + modifier, m_position.y - 0.45F, next.z + z)
-                   && !map.is_clip_box(next.x + modifier, m_position.y + 0.45F, next.z + z))
-            {
-                z -= 0.9F;
-            }
-            if (z < -2.36F)
-            {
-                m_position.x = next.x;
-                climb        = true;
-            }
-            else
-            {
-                m_velocity.x = 0.F;
-            }
-        }
-        else
-        {
-            m_velocity.x = 0.F;
-        }
-
-        //
-        // check for Y
-        //
-
-        z = m;
-
-        if (m_velocity.y < 0.F)
-        {
-            modifier = -0.45F;
-        }
-        else
-        {
-            modifier = 0.45F;
-        }
-
-        while (z >= -1.36F && //
-               !map.is_clip_box(m_position.x - 0.45F, next.y + modifier, next.z + z) && !map.is_clip_box(m_position.x + 0.45F, next.y + modifier, next.z + z))
-        {
-            z -= 0.9F;
-        }
-
-        if (z < -1.36F)
-        {
-            m_position.y = next.y;
-        }
-        else if (!m_crouching && m_orientation.z < 0.5F && !m_sprint && !climb)
-        {
-            z = 0.35F;
-            while (z >= -2.36F && //
-                   !map.is_clip_box(m_position.x - 0.45F, next.y + modifier, next.z + z)
-                   && !map.is_clip_box(m_position.x + 0.45F, next.y + modifier, next.z + z))
-            {
-                z -= 0.9F;
-            }
-            if (z < -2.36F)
-            {
-                m_position.y = next.y;
-                climb        = true;
-            }
-            else
-            {
-                m_velocity.y = 0.F;
-            }
-        }
-        else if (!climb)
-        {
-            m_velocity.y = 0.F;
-        }
-
-        //
-        // move z
-        //
-
-        if (climb)
-        {
-            m_velocity.x *= 0.5F;
-            m_velocity.y *= 0.5F;
-            next.z       -= 1.F;
-            m            = -1.35F;
-        }
-        else
-        {
-            if (m_velocity.z < 0.F)
-            {
-                m = -m;
-            }
-            next.z += m_velocity.z * delta * 32.F;
-        }
-
-        //
-        // check ground
-        //
-
-        m_gliding = true;
-
-        if (map.is_clip_box(m_position.x - 0.45F, m_position.y - 0.45F, next.z + m) || map.is_clip_box(m_position.x - 0.45F, m_position.y + 0.45F, next.z + m)
-            || map.is_clip_box(m_position.x + 0.45F, m_position.y - 0.45F, next.z + m)
-            || map.is_clip_box(m_position.x + 0.45F, m_position.y + 0.45F, next.z + m))
-        {
-            if (m_velocity.z >= 0.F)
-            {
-                m_wade    = m_position.z > 61.F;
-                m_gliding = false;
-            }
-            m_velocity.z = 0.F;
-        }
-        else
-        {
-            m_position.z = next.z - offset;
-        }
-
-        // reposition(m_position);
+        spadesx::box_clip_move(map, m_position, m_velocity, m_orientation.z, m_crouching, m_sprint, m_wade, m_gliding, delta);
     }
 
     /**
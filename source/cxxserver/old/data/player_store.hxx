@@ -0,0 +1,365 @@
+/**
+ * @file player_store.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include "movement.hxx"
+#include "player.hxx"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <smmintrin.h>
+
+namespace spadesx {
+
+/**
+ * @brief Structure of arrays with the hot movement state of all players
+ *
+ * Positions, velocities and orientations are kept in aligned arrays and inputs in packed bit
+ * fields, so the acceleration and friction math of move_player runs on four players per SSE
+ * register. Only box_clip_move and the fall check stay per player. Results of awake players are bit
+ * exact with player_data::move_player.
+ *
+ * Players resting on the ground without movement input for a few steps are put to sleep: they are
+ * skipped by load, move and store until their state changes or wake is called (block edits). This
+ * is the exception to the above: the step putting a player to sleep zeroes the residual horizontal
+ * velocity (below rest_speed), which move_player would keep decaying by friction.
+ *
+ */
+class player_store
+{
+  public:
+
+    static constexpr const std::size_t  max_players = 32;     //!< Number of slots
+    static constexpr const std::uint8_t rest_steps  = 16;     //!< Steps at rest before sleeping
+    static constexpr const float        rest_speed  = 0.001F; //!< Horizontal speed considered at rest
+
+    /**
+     * @brief Packed player bits
+     *
+     */
+    enum bits : std::uint32_t
+    {
+        up        = 1U << 0U,  //!< Input forward
+        down      = 1U << 1U,  //!< Input backward
+        left      = 1U << 2U,  //!< Input left
+        right     = 1U << 3U,  //!< Input right
+        sprint    = 1U << 4U,  //!< Input sprint
+        secondary = 1U << 5U,  //!< Secondary action
+        gun       = 1U << 6U,  //!< Gun is held
+        alive     = 1U << 7U,  //!< Is player alive
+        wade      = 1U << 8U,  //!< Is player in water
+        gliding   = 1U << 9U,  //!< In the air
+        crouching = 1U << 10U, //!< Crouching state
+        jumping   = 1U << 11U, //!< Is mid jump
+        sleeping  = 1U << 12U, //!< Resting, not moved
+        moving    = up | down | left | right | jumping, //!< Movement inputs
+    };
+
+    /**
+     * @brief Copy hot state of player into slot
+     *
+     * @param id Player ID
+     * @param player Player
+     */
+    void load(std::size_t id, const player_data & player) noexcept
+    {
+        m_px[id] = player.m_position.x;
+        m_py[id] = player.m_position.y;
+        m_pz[id] = player.m_position.z;
+        m_vx[id] = player.m_velocity.x;
+        m_vy[id] = player.m_velocity.y;
+        m_vz[id] = player.m_velocity.z;
+        m_ox[id] = player.m_orientation.x;
+        m_oy[id] = player.m_orientation.y;
+        m_oz[id] = player.m_orientation.z;
+
+        std::uint32_t flags = 0;
+        flags               |= player.m_up ? up : 0U;
+        flags               |= player.m_down ? down : 0U;
+        flags               |= player.m_left ? left : 0U;
+        flags               |= player.m_right ? right : 0U;
+        flags               |= player.m_sprint ? sprint : 0U;
+        flags               |= player.m_secondary ? secondary : 0U;
+        flags               |= player.m_tool == tool_type::gun ? gun : 0U;
+        flags               |= player.m_alive ? alive : 0U;
+        flags               |= player.m_wade ? wade : 0U;
+        flags               |= player.m_gliding ? gliding : 0U;
+        flags               |= player.m_crouching ? crouching : 0U;
+        flags               |= player.m_jumping ? jumping : 0U;
+        m_flags[id]         = flags;
+    }
+
+    /**
+     * @brief Copy state written by move back into player
+     *
+     * @param id Player ID
+     * @param player Player
+     */
+    void store(std::size_t id, player_data & player) const noexcept
+    {
+        player.m_position = { m_px[id], m_py[id], m_pz[id] };
+        player.m_velocity = { m_vx[id], m_vy[id], m_vz[id] };
+        player.m_wade     = (m_flags[id] & wade) != 0;
+        player.m_gliding  = (m_flags[id] & gliding) != 0;
+        player.m_jumping  = (m_flags[id] & jumping) != 0;
+    }
+
+    /**
+     * @brief Check whether player is still asleep (wakes it if its state changed since)
+     *
+     * @param id Player ID
+     * @param player Player
+     * @return true If load, move and store can be skipped
+     */
+    bool asleep(std::size_t id, const player_data & player) noexcept
+    {
+        if ((m_flags[id] & sleeping) == 0)
+        {
+            return false;
+        }
+        if (!player.m_alive || player.m_up || player.m_down || player.m_left || player.m_right || player.m_jumping
+            || player.m_crouching != ((m_flags[id] & crouching) != 0) || player.m_position != glm::vec3 { m_px[id], m_py[id], m_pz[id] })
+        {
+            wake(id);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Wake player (moved again by the next step)
+     *
+     * @param id Player ID
+     */
+    void wake(std::size_t id) noexcept
+    {
+        m_flags[id] &= ~sleeping;
+        m_rest[id]  = 0;
+    }
+
+    /**
+     * @brief Move range of players (same as player_data::move_player for every alive player)
+     *
+     * @param map Map
+     * @param delta Delta time
+     * @param begin First player ID (ranges moved in parallel must start at multiples of 4)
+     * @param end Last player ID (exclusive)
+     * @param fall_damage Fall damage output (-1 = sound only, 0 = nothing, > 0 = damage)
+     */
+    void move(const map & map, float delta, std::size_t begin, std::size_t end, std::array<int, max_players> & fall_damage) noexcept
+    {
+        for (std::size_t group = begin & ~std::size_t { 3 }; group < end; group += 4)
+        {
+            accelerate(group, begin, end, delta);
+        }
+
+        for (std::size_t id = begin; id < end; ++id)
+        {
+            fall_damage[id] = (m_flags[id] & (alive | sleeping)) == alive ? clip(map, id, delta) : 0;
+        }
+    }
+
+    /**
+     * @brief Get flags
+     *
+     * @param id Player ID
+     * @return Packed bits
+     */
+    [[nodiscard]] std::uint32_t flags(std::size_t id) const noexcept
+    {
+        return m_flags[id];
+    }
+
+  private:
+
+    using float_array = std::array<float, max_players>;
+
+    /**
+     * @brief Build lane mask from packed bits
+     *
+     * @param flags Packed bits of four players
+     * @param bit Bit
+     * @return Lane mask
+     */
+    static __m128 test(__m128i flags, std::uint32_t bit) noexcept
+    {
+        const __m128i value = _mm_set1_epi32(static_cast<int>(bit));
+        return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(flags, value), value));
+    }
+
+    /**
+     * @brief Jump, acceleration and friction of four players
+     *
+     * @param group First player ID of the group
+     * @param begin First player ID of the range
+     * @param end Last player ID of the range (exclusive)
+     * @param delta Delta time
+     */
+    void accelerate(std::size_t group, std::size_t begin, std::size_t end, float delta) noexcept
+    {
+        const __m128  zero  = _mm_setzero_ps();
+        const __m128  one   = _mm_set1_ps(1.F);
+        const __m128  dt    = _mm_set1_ps(delta);
+        const __m128i flags = _mm_load_si128(reinterpret_cast<const __m128i *>(&m_flags[group]));
+
+        const __m128i ids      = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(group)), _mm_setr_epi32(0, 1, 2, 3));
+        const __m128i in_range = _mm_andnot_si128(_mm_cmplt_epi32(ids, _mm_set1_epi32(static_cast<int>(begin))), _mm_cmplt_epi32(ids, _mm_set1_epi32(static_cast<int>(end))));
+
+        const __m128 is_alive   = _mm_andnot_ps(test(flags, sleeping), _mm_and_ps(test(flags, alive), _mm_castsi128_ps(in_range)));
+        const __m128 is_gliding = test(flags, gliding);
+        const __m128 is_wade    = test(flags, wade);
+        const __m128 is_up      = test(flags, up);
+        const __m128 is_down    = test(flags, down);
+        const __m128 is_left    = test(flags, left);
+        const __m128 is_right   = test(flags, right);
+
+        __m128 vx = _mm_load_ps(&m_vx[group]);
+        __m128 vy = _mm_load_ps(&m_vy[group]);
+        __m128 vz = _mm_load_ps(&m_vz[group]);
+
+        // jump (same condition as is_on_ground_or_wade)
+        __m128 ground = _mm_andnot_ps(is_gliding, _mm_and_ps(_mm_cmpge_ps(vz, zero), _mm_cmplt_ps(vz, _mm_set1_ps(0.017F))));
+        __m128 jump   = _mm_and_ps(_mm_and_ps(test(flags, jumping), ground), is_alive);
+        vz            = _mm_blendv_ps(vz, _mm_set1_ps(-0.36F), jump);
+
+        // modifier (first matching state wins, so blend in reverse order)
+        __m128 factor   = one;
+        factor          = _mm_blendv_ps(factor, _mm_set1_ps(1.3F), test(flags, sprint));
+        factor          = _mm_blendv_ps(factor, _mm_set1_ps(0.5F), test(flags, secondary | gun));
+        factor          = _mm_blendv_ps(factor, _mm_set1_ps(0.3F), test(flags, crouching));
+        factor          = _mm_blendv_ps(factor, _mm_set1_ps(0.1F), is_gliding);
+        __m128 modifier = _mm_mul_ps(dt, factor);
+        __m128 diagonal = _mm_and_ps(_mm_or_ps(is_up, is_down), _mm_or_ps(is_left, is_right));
+        modifier        = _mm_blendv_ps(modifier, _mm_mul_ps(modifier, _mm_set1_ps(player_data::diagonal_multiplier)), diagonal);
+
+        // vertical slowdown and normalized orientation in 2D (front and left)
+        const __m128 sign     = _mm_set1_ps(-0.F);
+        __m128       ox       = _mm_load_ps(&m_ox[group]);
+        __m128       oy       = _mm_load_ps(&m_oy[group]);
+        __m128       oz       = _mm_andnot_ps(sign, _mm_load_ps(&m_oz[group]));
+        __m128       slowdown = _mm_max_ps(_mm_sub_ps(oz, _mm_set1_ps(0.65F)), zero);
+        slowdown              = _mm_mul_ps(_mm_div_ps(slowdown, _mm_set1_ps(1.F - 0.65F)), _mm_set1_ps(0.9F));
+        __m128 length         = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy))));
+        __m128 scale          = _mm_sub_ps(one, slowdown);
+        __m128 front_x        = _mm_mul_ps(_mm_mul_ps(ox, length), scale);
+        __m128 front_y        = _mm_mul_ps(_mm_mul_ps(oy, length), scale);
+        length                = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(front_y, front_y), _mm_mul_ps(front_x, front_x))));
+        __m128 left_x         = _mm_mul_ps(front_y, length);
+        __m128 left_y         = _mm_mul_ps(_mm_xor_ps(front_x, sign), length);
+
+        // acceleration (forward wins over backward, left over right)
+        front_x = _mm_mul_ps(front_x, modifier);
+        front_y = _mm_mul_ps(front_y, modifier);
+        left_x  = _mm_mul_ps(left_x, modifier);
+        left_y  = _mm_mul_ps(left_y, modifier);
+        vx      = _mm_blendv_ps(_mm_blendv_ps(vx, _mm_sub_ps(vx, front_x), is_down), _mm_add_ps(vx, front_x), is_up);
+        vy      = _mm_blendv_ps(_mm_blendv_ps(vy, _mm_sub_ps(vy, front_y), is_down), _mm_add_ps(vy, front_y), is_up);
+        vx      = _mm_blendv_ps(_mm_blendv_ps(vx, _mm_sub_ps(vx, left_x), is_right), _mm_add_ps(vx, left_x), is_left);
+        vy      = _mm_blendv_ps(_mm_blendv_ps(vy, _mm_sub_ps(vy, left_y), is_right), _mm_add_ps(vy, left_y), is_left);
+
+        // air friction, ground and water friction
+        __m128 air      = _mm_add_ps(dt, one);
+        vz              = _mm_div_ps(_mm_add_ps(vz, dt), air);
+        __m128 friction = _mm_blendv_ps(_mm_add_ps(_mm_mul_ps(dt, _mm_set1_ps(4.F)), one), air, is_gliding);
+        friction        = _mm_blendv_ps(friction, _mm_add_ps(_mm_mul_ps(dt, _mm_set1_ps(6.F)), one), is_wade);
+        vx              = _mm_div_ps(vx, friction);
+        vy              = _mm_div_ps(vy, friction);
+
+        // dead or sleeping players and players outside of the range keep their state
+        _mm_store_ps(&m_vx[group], _mm_blendv_ps(_mm_load_ps(&m_vx[group]), vx, is_alive));
+        _mm_store_ps(&m_vy[group], _mm_blendv_ps(_mm_load_ps(&m_vy[group]), vy, is_alive));
+        _mm_store_ps(&m_vz[group], _mm_blendv_ps(_mm_load_ps(&m_vz[group]), vz, is_alive));
+
+        auto cleared = _mm_andnot_si128(_mm_and_si128(_mm_castps_si128(jump), _mm_set1_epi32(static_cast<int>(jumping))), flags);
+        _mm_store_si128(reinterpret_cast<__m128i *>(&m_flags[group]), cleared);
+    }
+
+    /**
+     * @brief Clip move and fall check of a single player
+     *
+     * @param map Map
+     * @param id Player ID
+     * @param delta Delta time
+     * @return Fall damage (-1 = sound only, 0 = nothing, > 0 = damage)
+     */
+    int clip(const map & map, std::size_t id, float delta) noexcept
+    {
+        glm::vec3 position { m_px[id], m_py[id], m_pz[id] };
+        glm::vec3 velocity { m_vx[id], m_vy[id], m_vz[id] };
+        bool      is_wade    = (m_flags[id] & wade) != 0;
+        bool      is_gliding = (m_flags[id] & gliding) != 0;
+        float     vel_z      = velocity.z;
+
+        box_clip_move(map, position, velocity, m_oz[id], (m_flags[id] & crouching) != 0, (m_flags[id] & sprint) != 0, is_wade, is_gliding, delta);
+
+        int result = 0;
+
+        // check fall - slow
+        if (velocity.z == 0.F && vel_z > 0.24F)
+        {
+            // Slow down on fall
+            velocity.x *= 0.5F;
+            velocity.y *= 0.5F;
+            result     = -1;
+
+            // check fall - damage
+            if (vel_z > 0.58F)
+            {
+                vel_z  -= 0.58F;
+                result = static_cast<int>(vel_z * vel_z * 4096);
+            }
+        }
+
+        m_px[id]    = position.x;
+        m_py[id]    = position.y;
+        m_pz[id]    = position.z;
+        m_vx[id]    = velocity.x;
+        m_vy[id]    = velocity.y;
+        m_vz[id]    = velocity.z;
+        m_flags[id] = (m_flags[id] & ~(wade | gliding)) | (is_wade ? wade : 0U) | (is_gliding ? gliding : 0U);
+        rest(id);
+        return result;
+    }
+
+    /**
+     * @brief Count steps at rest and put player to sleep
+     *
+     * At rest the step is a fixed point (gravity is cancelled by the ground, position does not
+     * change), the residual horizontal velocity is dropped when falling asleep.
+     *
+     * @param id Player ID
+     */
+    void rest(std::size_t id) noexcept
+    {
+        bool at_rest = (m_flags[id] & (moving | gliding)) == 0 && m_vz[id] == 0.F && std::abs(m_vx[id]) < rest_speed && std::abs(m_vy[id]) < rest_speed;
+        if (!at_rest)
+        {
+            m_rest[id] = 0;
+            return;
+        }
+        if (++m_rest[id] >= rest_steps)
+        {
+            m_vx[id]    = 0.F;
+            m_vy[id]    = 0.F;
+            m_flags[id] |= sleeping;
+        }
+    }
+
+    alignas(16) float_array                            m_px {};    //!< Positions (x)
+    alignas(16) float_array                            m_py {};    //!< Positions (y)
+    alignas(16) float_array                            m_pz {};    //!< Positions (z)
+    alignas(16) float_array                            m_vx {};    //!< Velocities (x)
+    alignas(16) float_array                            m_vy {};    //!< Velocities (y)
+    alignas(16) float_array                            m_vz {};    //!< Velocities (z)
+    alignas(16) float_array                            m_ox {};    //!< Orientations (x)
+    alignas(16) float_array                            m_oy {};    //!< Orientations (y)
+    alignas(16) float_array                            m_oz {};    //!< Orientations (z)
+    alignas(16) std::array<std::uint32_t, max_players> m_flags {}; //!< Packed inputs and states
+    std::array<std::uint8_t, max_players>              m_rest {};  //!< Steps at rest
+};
+
+} // namespace spadesx
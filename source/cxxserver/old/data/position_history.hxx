@@ -0,0 +1,101 @@
+/**
+ * @file position_history.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include "player.hxx"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace spadesx {
+
+/**
+ * @brief Positions and orientations of all players during the last ticks (fixed ring)
+ *
+ */
+class position_history
+{
+  public:
+
+    static constexpr const std::size_t length      = 64; //!< Recorded ticks (about 1 second at 60 Hz)
+    static constexpr const std::size_t max_players = 32; //!< Number of slots
+
+    /**
+     * @brief Player state at a single tick
+     *
+     */
+    struct sample
+    {
+        std::uint64_t tick { 0 };          //!< Tick
+        glm::vec3     position {};         //!< Position
+        glm::vec3     orientation {};      //!< Orientation
+        bool          alive { false };     //!< Is player alive
+        bool          crouching { false }; //!< Crouching state
+    };
+
+    /**
+     * @brief Record state of all players
+     *
+     * @tparam Players Range of player_data
+     * @param tick Tick
+     * @param delta Tick length (seconds)
+     * @param players Players (index = ID)
+     */
+    template <typename Players>
+    void record(std::uint64_t tick, float delta, const Players & players) noexcept
+    {
+        m_latest = tick;
+        m_delta  = delta;
+
+        auto slot = tick % length;
+        for (const player_data & player : players)
+        {
+            auto & sample      = m_samples[player.id()][slot];
+            sample.tick        = tick;
+            sample.position    = player.m_position;
+            sample.orientation = player.m_orientation;
+            sample.alive       = player.m_alive;
+            sample.crouching   = player.m_crouching;
+        }
+    }
+
+    /**
+     * @brief Get state of player as it was some time ago
+     *
+     * Requests older than the ring return the oldest recorded tick.
+     *
+     * @param id Player ID
+     * @param seconds Time to go back
+     * @return Sample (nullptr if nothing was recorded)
+     */
+    [[nodiscard]] const sample * rewind(std::uint8_t id, float seconds) const noexcept
+    {
+        if (m_delta <= 0.F)
+        {
+            return nullptr;
+        }
+        auto ticks = std::min<std::uint64_t>(static_cast<std::uint64_t>(std::lround(std::max(seconds, 0.F) / m_delta)), length - 1);
+        auto tick  = m_latest - std::min(ticks, m_latest);
+        for (; tick <= m_latest; ++tick)
+        {
+            const auto & sample = m_samples[id][tick % length];
+            if (sample.tick == tick)
+            {
+                return &sample;
+            }
+        }
+        return nullptr;
+    }
+
+  private:
+
+    std::array<std::array<sample, length>, max_players> m_samples {};    //!< Samples (ring per player)
+    std::uint64_t                                       m_latest { 0 };  //!< Last recorded tick
+    float                                               m_delta { 0.F }; //!< Tick length
+};
+
+} // namespace spadesx
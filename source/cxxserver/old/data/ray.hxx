@@ -7,6 +7,10 @@
 
 #include "../map.hxx"
 
+#include <cmath>
+#include <glm/glm.hpp>
+#include <limits>
+
 namespace spadesx {
 
 /**
@@ -29,7 +33,7 @@ class ray
     {
         glm::ivec3 v0;
         glm::ivec3 v1;
-        glm::ivec3 v2;
+        glm::ivec3 v2 {};
         glm::vec3  v3;
         glm::vec3  v4;
 
@@ -74,6 +78,76 @@ class ray
         return false;
     }
 
+    /**
+     * @brief First solid block entered by a moving point
+     *
+     */
+    struct sweep_hit
+    {
+        float      time;   //!< Fraction of the segment at the entered face [0, 1]
+        glm::ivec3 normal; //!< Normal of the entered face
+        glm::ivec3 block;  //!< Entered block
+    };
+
+    /**
+     * @brief Walk all blocks crossed by a segment (DDA), blocks are tested with is_clip_world
+     *
+     * The block containing the start point is not tested.
+     *
+     * @param map Map
+     * @param from Start point
+     * @param to End point
+     * @param hit First solid block entered (if any)
+     * @return true If a solid block was entered
+     */
+    static bool sweep(const map & map, const glm::vec3 & from, const glm::vec3 & to, sweep_hit & hit)
+    {
+        const glm::vec3  direction = to - from;
+        const glm::ivec3 last      = glm::floor(to);
+        glm::ivec3       block     = glm::floor(from);
+        glm::ivec3       step { 0 };
+        glm::vec3        next { std::numeric_limits<float>::infinity() };
+        glm::vec3        delta { std::numeric_limits<float>::infinity() };
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (direction[axis] > 0.F)
+            {
+                step[axis]  = 1;
+                next[axis]  = (float(block[axis] + 1) - from[axis]) / direction[axis];
+                delta[axis] = 1.F / direction[axis];
+            }
+            else if (direction[axis] < 0.F)
+            {
+                step[axis]  = -1;
+                next[axis]  = (float(block[axis]) - from[axis]) / direction[axis];
+                delta[axis] = -1.F / direction[axis];
+            }
+        }
+
+        auto count = std::abs(last.x - block.x) + std::abs(last.y - block.y) + std::abs(last.z - block.z);
+        for (; count > 0; --count)
+        {
+            int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+            if (next[axis] > 1.F)
+            {
+                break;
+            }
+
+            block[axis] += step[axis];
+            if (map.is_clip_world(block.x, block.y, block.z))
+            {
+                hit.time         = next[axis];
+                hit.normal       = glm::ivec3 { 0 };
+                hit.normal[axis] = -step[axis];
+                hit.block        = block;
+                return true;
+            }
+            next[axis] += delta[axis];
+        }
+        return false;
+    }
+
   private:
 
     // Helper function
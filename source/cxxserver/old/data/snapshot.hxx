@@ -0,0 +1,123 @@
+/**
+ * @file snapshot.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include "enums.hxx"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace spadesx {
+
+/**
+ * @brief Immutable world state published at the end of every step
+ *
+ */
+struct world_snapshot
+{
+    static constexpr const std::size_t max_players = 32;                      //!< Number of slots
+    static constexpr const std::size_t slot_size   = 24;                      //!< Position and orientation
+    static constexpr const std::size_t body_size   = max_players * slot_size; //!< World update body size
+
+    std::uint64_t                                   tick { 0 };          //!< Step number
+    std::uint64_t                                   broadcast { 0 };     //!< Step of the latest due world update
+    std::uint32_t                                   alive { 0 };         //!< Alive players (bit per player)
+    std::uint32_t                                   connected { 0 };     //!< Connected players (bit per player)
+    std::array<std::uint32_t, max_players>          visible {};          //!< Visibility masks (bit per player)
+    std::array<std::uint32_t, max_players>          session {};          //!< Connection count of each slot
+    std::array<std::uint8_t, max_players>           health {};           //!< Health
+    std::array<tool_type, max_players>              tool {};             //!< Held tool
+    std::array<team_type, max_players>              team {};             //!< Team
+    std::array<glm::vec3, max_players>              position {};         //!< Positions
+    std::array<glm::vec3, max_players>              orientation {};      //!< Orientations
+    alignas(16) std::array<std::uint8_t, body_size> body {};             //!< Positions and orientations (world update layout)
+};
+
+/**
+ * @brief Lock-free triple buffer (single writer, single reader)
+ *
+ * The writer fills back() and publishes it, the reader always gets the most recently published
+ * value. Neither side ever waits for the other.
+ *
+ * @tparam T Value type
+ */
+template <typename T>
+class triple_buffer
+{
+  public:
+
+    /**
+     * @brief Get buffer to be written (writer only)
+     *
+     * @return Back buffer
+     */
+    [[nodiscard]] T & back() noexcept
+    {
+        return m_buffers[m_back];
+    }
+
+    /**
+     * @brief Publish back buffer (writer only)
+     *
+     */
+    void publish() noexcept
+    {
+        m_back = m_middle.exchange(m_back | fresh_bit, std::memory_order_acq_rel) & index_mask;
+        m_published.fetch_add(1, std::memory_order_release);
+        m_published.notify_one();
+    }
+
+    /**
+     * @brief Get most recently published buffer (reader only)
+     *
+     * @return Front buffer (stays valid until the next acquire)
+     */
+    [[nodiscard]] const T & acquire() noexcept
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & fresh_bit) != 0)
+        {
+            m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & index_mask;
+        }
+        return m_buffers[m_front];
+    }
+
+    /**
+     * @brief Block until more than known values were published (reader only)
+     *
+     * @param known Number of publishes already seen
+     * @return Number of publishes
+     */
+    std::uint64_t wait(std::uint64_t known) const noexcept
+    {
+        m_published.wait(known, std::memory_order_acquire);
+        return m_published.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Wake up waiting reader without publishing
+     *
+     */
+    void interrupt() noexcept
+    {
+        m_published.fetch_add(1, std::memory_order_release);
+        m_published.notify_one();
+    }
+
+  private:
+
+    static constexpr const std::uint8_t index_mask = 0x03; //!< Buffer index
+    static constexpr const std::uint8_t fresh_bit  = 0x04; //!< Middle buffer was not read yet
+
+    std::array<T, 3>           m_buffers {};      //!< Buffers
+    std::uint8_t               m_back { 0 };      //!< Writer buffer
+    std::uint8_t               m_front { 1 };     //!< Reader buffer
+    std::atomic<std::uint8_t>  m_middle { 2 };    //!< Exchanged buffer (and fresh bit)
+    std::atomic<std::uint64_t> m_published { 0 }; //!< Number of publishes
+};
+
+} // namespace spadesx
@@ -0,0 +1,355 @@
+/**
+ * @file spatial_hash.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace spadesx {
+
+/**
+ * @brief Uniform grid of entities with radius queries and spherical trigger volumes
+ *
+ * Every cell keeps an intrusive list of its entities and a mask of the triggers overlapping it.
+ * Entities are evaluated against triggers only when they change cell or stay in a cell touched by
+ * a trigger, so entities far from all triggers cost a single cell lookup per update.
+ *
+ */
+class spatial_hash
+{
+  public:
+
+    static constexpr const std::uint32_t cell_size    = 8;                     //!< Cell size (blocks)
+    static constexpr const std::uint32_t grid_size    = 512 / cell_size;       //!< Cells per side
+    static constexpr const std::uint32_t cell_count   = grid_size * grid_size; //!< Number of cells
+    static constexpr const std::size_t   max_entities = 64;                    //!< Number of entity slots
+    static constexpr const std::size_t   max_triggers = 8;                     //!< Number of trigger slots
+    static constexpr const std::uint16_t invalid      = 0xFFFF;                //!< Invalid cell or entity
+
+    /**
+     * @brief Trigger enter or exit
+     *
+     */
+    struct trigger_event
+    {
+        std::uint8_t entity;  //!< Entity
+        std::uint8_t trigger; //!< Trigger
+        bool         enter;   //!< Entered (true) or left (false)
+    };
+
+    /**
+     * @brief Construct a new spatial_hash object
+     *
+     */
+    spatial_hash()
+    {
+        m_heads.fill(invalid);
+        m_cells.fill(invalid);
+        m_events.reserve(max_entities * max_triggers);
+    }
+
+    /**
+     * @brief Insert or move entity
+     *
+     * @param entity Entity
+     * @param position Position
+     * @return true If the entity changed cell
+     */
+    bool update(std::uint8_t entity, const glm::vec3 & position)
+    {
+        m_positions[entity] = position;
+
+        auto cell    = cell_of(position);
+        bool changed = cell != m_cells[entity];
+        if (changed)
+        {
+            unlink(entity);
+            link(entity, cell);
+        }
+        if (changed || (m_cell_triggers[cell] | m_inside[entity]) != 0)
+        {
+            evaluate(entity);
+        }
+        return changed;
+    }
+
+    /**
+     * @brief Remove entity (leaves all triggers)
+     *
+     * @param entity Entity
+     */
+    void remove(std::uint8_t entity)
+    {
+        if (m_cells[entity] == invalid)
+        {
+            return;
+        }
+        unlink(entity);
+        emit(entity, m_inside[entity], false);
+        m_inside[entity] = 0;
+    }
+
+    /**
+     * @brief Place trigger (enables it)
+     *
+     * @param trigger Trigger
+     * @param center Center
+     * @param radius Radius
+     */
+    void set_trigger(std::uint8_t trigger, const glm::vec3 & center, float radius)
+    {
+        mark(trigger, false);
+        m_centers[trigger] = center;
+        m_radii[trigger]   = radius;
+        m_enabled          |= std::uint8_t(1U << trigger);
+        mark(trigger, true);
+        evaluate_all();
+    }
+
+    /**
+     * @brief Disable trigger (entities inside leave it)
+     *
+     * @param trigger Trigger
+     */
+    void disable_trigger(std::uint8_t trigger)
+    {
+        mark(trigger, false);
+        m_enabled &= std::uint8_t(~(1U << trigger));
+        evaluate_all();
+    }
+
+    /**
+     * @brief Check whether entity is inside trigger
+     *
+     * @param entity Entity
+     * @param trigger Trigger
+     * @return true If inside
+     */
+    [[nodiscard]] bool is_inside(std::uint8_t entity, std::uint8_t trigger) const noexcept
+    {
+        return ((m_inside[entity] >> trigger) & 1U) != 0;
+    }
+
+    /**
+     * @brief Call function for every entity within radius
+     *
+     * @param center Center
+     * @param radius Radius
+     * @param function Callable with (std::uint8_t entity, float distance)
+     */
+    template <typename Function>
+    void query_radius(const glm::vec3 & center, float radius, Function && function) const
+    {
+        auto [x0, y0, x1, y1] = cells_of(center, radius);
+        for (auto y = y0; y <= y1; ++y)
+        {
+            for (auto x = x0; x <= x1; ++x)
+            {
+                for (auto entity = m_heads[y * grid_size + x]; entity != invalid; entity = m_next[entity])
+                {
+                    if (auto distance = glm::distance(center, m_positions[entity]); distance <= radius)
+                    {
+                        function(static_cast<std::uint8_t>(entity), distance);
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Get trigger events since the last clear_events
+     *
+     * @return Events
+     */
+    [[nodiscard]] const std::vector<trigger_event> & events() const noexcept
+    {
+        return m_events;
+    }
+
+    /**
+     * @brief Clear trigger events
+     *
+     */
+    void clear_events() noexcept
+    {
+        m_events.clear();
+    }
+
+  private:
+
+    /**
+     * @brief Get cell of position (positions outside of the map are clamped)
+     *
+     * @param position Position
+     * @return Cell index
+     */
+    static std::uint16_t cell_of(const glm::vec3 & position) noexcept
+    {
+        return static_cast<std::uint16_t>(clamp_cell(position.y) * grid_size + clamp_cell(position.x));
+    }
+
+    /**
+     * @brief Get cell coordinate
+     *
+     * @param value Coordinate
+     * @return Cell coordinate
+     */
+    static std::uint32_t clamp_cell(float value) noexcept
+    {
+        return static_cast<std::uint32_t>(std::clamp(int(std::floor(value / float(cell_size))), 0, int(grid_size) - 1));
+    }
+
+    /**
+     * @brief Get cell rectangle covering a circle
+     *
+     * @param center Center
+     * @param radius Radius
+     * @return First and last cell coordinates (x0, y0, x1, y1)
+     */
+    static std::array<std::uint32_t, 4> cells_of(const glm::vec3 & center, float radius) noexcept
+    {
+        return { clamp_cell(center.x - radius), clamp_cell(center.y - radius), clamp_cell(center.x + radius), clamp_cell(center.y + radius) };
+    }
+
+    /**
+     * @brief Insert entity into cell list
+     *
+     * @param entity Entity
+     * @param cell Cell
+     */
+    void link(std::uint8_t entity, std::uint16_t cell) noexcept
+    {
+        m_cells[entity] = cell;
+        m_prev[entity]  = invalid;
+        m_next[entity]  = m_heads[cell];
+        if (m_heads[cell] != invalid)
+        {
+            m_prev[m_heads[cell]] = entity;
+        }
+        m_heads[cell] = entity;
+    }
+
+    /**
+     * @brief Remove entity from its cell list
+     *
+     * @param entity Entity
+     */
+    void unlink(std::uint8_t entity) noexcept
+    {
+        auto cell = m_cells[entity];
+        if (cell == invalid)
+        {
+            return;
+        }
+        if (m_prev[entity] != invalid)
+        {
+            m_next[m_prev[entity]] = m_next[entity];
+        }
+        else
+        {
+            m_heads[cell] = m_next[entity];
+        }
+        if (m_next[entity] != invalid)
+        {
+            m_prev[m_next[entity]] = m_prev[entity];
+        }
+        m_cells[entity] = invalid;
+    }
+
+    /**
+     * @brief Set or clear trigger bit in all cells it overlaps
+     *
+     * @param trigger Trigger
+     * @param value Set (true) or clear (false)
+     */
+    void mark(std::uint8_t trigger, bool value) noexcept
+    {
+        auto bit = std::uint8_t(1U << trigger);
+        if ((m_enabled & bit) == 0)
+        {
+            return;
+        }
+        auto [x0, y0, x1, y1] = cells_of(m_centers[trigger], m_radii[trigger]);
+        for (auto y = y0; y <= y1; ++y)
+        {
+            for (auto x = x0; x <= x1; ++x)
+            {
+                auto & mask = m_cell_triggers[y * grid_size + x];
+                mask        = value ? std::uint8_t(mask | bit) : std::uint8_t(mask & ~bit);
+            }
+        }
+    }
+
+    /**
+     * @brief Test entity against the triggers of its cell and emit changes
+     *
+     * @param entity Entity
+     */
+    void evaluate(std::uint8_t entity)
+    {
+        std::uint8_t inside = 0;
+        for (std::uint32_t candidates = m_cell_triggers[m_cells[entity]] & m_enabled; candidates != 0; candidates &= candidates - 1)
+        {
+            auto trigger = std::countr_zero(candidates);
+            if (glm::distance(m_positions[entity], m_centers[trigger]) <= m_radii[trigger])
+            {
+                inside |= std::uint8_t(1U << trigger);
+            }
+        }
+        emit(entity, inside & ~m_inside[entity], true);
+        emit(entity, m_inside[entity] & ~inside, false);
+        m_inside[entity] = inside;
+    }
+
+    /**
+     * @brief Evaluate all inserted entities (after a trigger changed)
+     *
+     */
+    void evaluate_all()
+    {
+        for (std::size_t entity = 0; entity < max_entities; ++entity)
+        {
+            if (m_cells[entity] != invalid)
+            {
+                evaluate(static_cast<std::uint8_t>(entity));
+            }
+        }
+    }
+
+    /**
+     * @brief Emit event for every trigger in mask
+     *
+     * @param entity Entity
+     * @param triggers Trigger mask
+     * @param enter Entered or left
+     */
+    void emit(std::uint8_t entity, std::uint32_t triggers, bool enter)
+    {
+        for (; triggers != 0; triggers &= triggers - 1)
+        {
+            m_events.push_back({ entity, static_cast<std::uint8_t>(std::countr_zero(triggers)), enter });
+        }
+    }
+
+    std::array<std::uint16_t, cell_count>   m_heads;            //!< First entity of every cell
+    std::array<std::uint8_t, cell_count>    m_cell_triggers {}; //!< Triggers overlapping every cell
+    std::array<std::uint16_t, max_entities> m_cells;            //!< Cell of every entity
+    std::array<std::uint16_t, max_entities> m_next {};          //!< Next entity in cell
+    std::array<std::uint16_t, max_entities> m_prev {};          //!< Previous entity in cell
+    std::array<glm::vec3, max_entities>     m_positions {};     //!< Entity positions
+    std::array<std::uint8_t, max_entities>  m_inside {};        //!< Triggers containing every entity
+    std::array<glm::vec3, max_triggers>     m_centers {};       //!< Trigger centers
+    std::array<float, max_triggers>         m_radii {};         //!< Trigger radii
+    std::uint8_t                            m_enabled { 0 };    //!< Enabled triggers
+    std::vector<trigger_event>              m_events;           //!< Trigger events not processed yet
+};
+
+} // namespace spadesx
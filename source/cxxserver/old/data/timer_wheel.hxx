@@ -0,0 +1,370 @@
+/**
+ * @file timer_wheel.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace spadesx {
+
+/**
+ * @brief Hierarchical timing wheel with millisecond resolution
+ *
+ * Four levels of 64 slots cover 2^24 ms (about 4.6 hours), longer delays are clamped. Timers are
+ * nodes of a pool linked into the slot of their deadline, so schedule and cancel are O(1). Timers
+ * of a higher level are redistributed when the level below wraps around, and advance skips runs of
+ * empty slots, so the work per step is proportional to the expiring timers.
+ *
+ */
+class timer_wheel
+{
+  public:
+
+    using callback = std::function<void()>;
+
+    static constexpr const std::uint32_t slot_bits   = 6;                                                      //!< Bits per level
+    static constexpr const std::uint32_t slot_count  = 1U << slot_bits;                                        //!< Slots per level
+    static constexpr const std::uint32_t level_count = 4;                                                      //!< Number of levels
+    static constexpr const std::uint64_t max_delay   = (std::uint64_t { 1 } << (slot_bits * level_count)) - 1; //!< Max delay (ms)
+
+    /**
+     * @brief Timer handle (stays invalid after the timer fired or was cancelled)
+     *
+     */
+    struct handle
+    {
+        std::uint32_t index { invalid }; //!< Node index
+        std::uint32_t generation { 0 };  //!< Node generation
+    };
+
+    /**
+     * @brief Construct a new timer_wheel object
+     *
+     */
+    timer_wheel()
+    {
+        m_heads.fill(invalid);
+        m_nodes.reserve(256);
+    }
+
+    /**
+     * @brief Schedule callback
+     *
+     * @param delay Delay (ms), fires during the first advance reaching it (at least 1 ms)
+     * @param function Callback (may schedule and cancel timers)
+     * @return Handle
+     */
+    handle schedule(std::uint64_t delay, callback function)
+    {
+        std::uint32_t index;
+        if (m_free != invalid)
+        {
+            index  = m_free;
+            m_free = m_nodes[index].next;
+        }
+        else
+        {
+            index = static_cast<std::uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+
+        auto & node   = m_nodes[index];
+        node.deadline = m_now + std::clamp<std::uint64_t>(delay, 1, max_delay);
+        node.function = std::move(function);
+        node.active   = true;
+        ++m_count;
+        insert(index);
+        return { index, node.generation };
+    }
+
+    /**
+     * @brief Cancel timer
+     *
+     * @param timer Handle (reset to invalid)
+     * @return true If the timer was pending
+     */
+    bool cancel(handle & timer) noexcept
+    {
+        bool pending = is_pending(timer);
+        if (pending)
+        {
+            unlink(timer.index);
+            release(timer.index);
+        }
+        timer = {};
+        return pending;
+    }
+
+    /**
+     * @brief Check whether timer is pending
+     *
+     * @param timer Handle
+     * @return true If the timer did not fire and was not cancelled
+     */
+    [[nodiscard]] bool is_pending(const handle & timer) const noexcept
+    {
+        return timer.index < m_nodes.size() && m_nodes[timer.index].active && m_nodes[timer.index].generation == timer.generation;
+    }
+
+    /**
+     * @brief Cancel all timers
+     *
+     */
+    void clear() noexcept
+    {
+        for (std::uint32_t index = 0; index < m_nodes.size(); ++index)
+        {
+            if (m_nodes[index].active)
+            {
+                unlink(index);
+                release(index);
+            }
+        }
+    }
+
+    /**
+     * @brief Advance time and fire expired timers (in deadline order)
+     *
+     * @param now Current time (ms)
+     */
+    void advance(std::uint64_t now)
+    {
+        while (m_now < now)
+        {
+            if (m_count == 0)
+            {
+                m_now = now;
+                break;
+            }
+            if (m_occupied[0] == 0)
+            {
+                // nothing on the first level until it wraps around
+                auto boundary = m_now | (slot_count - 1);
+                if (boundary >= now)
+                {
+                    m_now = now;
+                    break;
+                }
+                m_now = boundary;
+            }
+
+            ++m_now;
+            if ((m_now & (slot_count - 1)) == 0)
+            {
+                cascade(1);
+            }
+            fire(slot_of(0, m_now));
+        }
+    }
+
+    /**
+     * @brief Get current time
+     *
+     * @return Time of the last advance (ms)
+     */
+    [[nodiscard]] std::uint64_t now() const noexcept
+    {
+        return m_now;
+    }
+
+    /**
+     * @brief Get number of pending timers
+     *
+     * @return Number of pending timers
+     */
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return m_count;
+    }
+
+  private:
+
+    static constexpr const std::uint32_t invalid      = 0xFFFFFFFF;              //!< Invalid node
+    static constexpr const std::uint32_t expired_slot = slot_count * level_count; //!< List of timers being fired
+
+    /**
+     * @brief Timer node
+     *
+     */
+    struct node
+    {
+        std::uint64_t deadline { 0 };   //!< Deadline (ms)
+        std::uint32_t prev { invalid }; //!< Previous node in slot
+        std::uint32_t next { invalid }; //!< Next node in slot (or free list)
+        std::uint32_t slot { invalid }; //!< Slot
+        std::uint32_t generation { 0 }; //!< Incremented on release
+        bool          active { false }; //!< Is pending
+        callback      function;         //!< Callback
+    };
+
+    /**
+     * @brief Get slot of time on level
+     *
+     * @param level Level
+     * @param time Time
+     * @return Slot
+     */
+    static std::uint32_t slot_of(std::uint32_t level, std::uint64_t time) noexcept
+    {
+        return level * slot_count + static_cast<std::uint32_t>((time >> (level * slot_bits)) & (slot_count - 1));
+    }
+
+    /**
+     * @brief Link node into the slot of its deadline
+     *
+     * @param index Node
+     */
+    void insert(std::uint32_t index) noexcept
+    {
+        auto          deadline = std::max(m_nodes[index].deadline, m_now); // m_now only while cascading, fired right after
+        auto          delay    = deadline - m_now;
+        std::uint32_t level    = 0;
+        while (level + 1 < level_count && delay >= (std::uint64_t { 1 } << ((level + 1) * slot_bits)))
+        {
+            ++level;
+        }
+        link(index, slot_of(level, deadline));
+    }
+
+    /**
+     * @brief Link node into slot
+     *
+     * @param index Node
+     * @param slot Slot
+     */
+    void link(std::uint32_t index, std::uint32_t slot) noexcept
+    {
+        auto & node = m_nodes[index];
+        node.slot   = slot;
+        node.prev   = invalid;
+        node.next   = m_heads[slot];
+        if (node.next != invalid)
+        {
+            m_nodes[node.next].prev = index;
+        }
+        m_heads[slot] = index;
+        if (slot < expired_slot)
+        {
+            m_occupied[slot / slot_count] |= std::uint64_t { 1 } << (slot % slot_count);
+        }
+    }
+
+    /**
+     * @brief Unlink node from its slot
+     *
+     * @param index Node
+     */
+    void unlink(std::uint32_t index) noexcept
+    {
+        auto & node = m_nodes[index];
+        if (node.prev != invalid)
+        {
+            m_nodes[node.prev].next = node.next;
+        }
+        else
+        {
+            m_heads[node.slot] = node.next;
+        }
+        if (node.next != invalid)
+        {
+            m_nodes[node.next].prev = node.prev;
+        }
+        if (m_heads[node.slot] == invalid && node.slot < expired_slot)
+        {
+            m_occupied[node.slot / slot_count] &= ~(std::uint64_t { 1 } << (node.slot % slot_count));
+        }
+        node.slot = invalid;
+    }
+
+    /**
+     * @brief Return node to the free list
+     *
+     * @param index Node
+     */
+    void release(std::uint32_t index) noexcept
+    {
+        auto & node   = m_nodes[index];
+        node.active   = false;
+        node.function = nullptr;
+        node.next     = m_free;
+        ++node.generation;
+        m_free = index;
+        --m_count;
+    }
+
+    /**
+     * @brief Move slot into a list
+     *
+     * @param slot Slot
+     * @param target Target slot
+     */
+    void move(std::uint32_t slot, std::uint32_t target) noexcept
+    {
+        while (m_heads[slot] != invalid)
+        {
+            auto index = m_heads[slot];
+            unlink(index);
+            link(index, target);
+        }
+    }
+
+    /**
+     * @brief Redistribute the current slot of level into the levels below
+     *
+     * @param level Level
+     */
+    void cascade(std::uint32_t level) noexcept
+    {
+        if (level >= level_count)
+        {
+            return;
+        }
+        if (((m_now >> (level * slot_bits)) & (slot_count - 1)) == 0)
+        {
+            cascade(level + 1);
+        }
+
+        auto slot = slot_of(level, m_now);
+        while (m_heads[slot] != invalid)
+        {
+            auto index = m_heads[slot];
+            unlink(index);
+            insert(index);
+        }
+    }
+
+    /**
+     * @brief Fire all timers of slot
+     *
+     * Timers are moved into a separate list first, so callbacks can cancel any timer safely.
+     *
+     * @param slot Slot
+     */
+    void fire(std::uint32_t slot)
+    {
+        move(slot, expired_slot);
+        while (m_heads[expired_slot] != invalid)
+        {
+            auto index    = m_heads[expired_slot];
+            auto function = std::move(m_nodes[index].function);
+            unlink(index);
+            release(index);
+            function();
+        }
+    }
+
+    std::vector<node>                                       m_nodes;            //!< Timer pool
+    std::array<std::uint32_t, slot_count * level_count + 1> m_heads;            //!< First node of every slot (and of the fired list)
+    std::array<std::uint64_t, level_count>                  m_occupied {};      //!< Non empty slots (bit per slot)
+    std::uint64_t                                           m_now { 0 };        //!< Current time (ms)
+    std::uint32_t                                           m_free { invalid }; //!< First free node
+    std::size_t                                             m_count { 0 };      //!< Number of pending timers
+};
+
+} // namespace spadesx
@@ -0,0 +1,367 @@
+/**
+ * @file world_update.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include "../map.hxx"
+#include "enums.hxx"
+#include "ray.hxx"
+#include "snapshot.hxx"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <smmintrin.h>
+
+namespace spadesx {
+
+/**
+ * @brief Policy for slots of players that are not visible
+ *
+ */
+enum class hidden_slot_type
+{
+    zero,  //!< Hidden slot is zeroed
+    stale, //!< Hidden slot keeps last data sent to the client
+};
+
+/**
+ * @brief Per-client world update builder (visibility culling)
+ *
+ */
+class world_update_builder
+{
+  public:
+
+    static constexpr const std::size_t max_players = world_snapshot::max_players; //!< Number of slots
+    static constexpr const std::size_t slot_size   = world_snapshot::slot_size;   //!< Position and orientation
+    static constexpr const std::size_t body_size   = world_snapshot::body_size;   //!< Packet size without type
+
+    /**
+     * @brief Player state used by the builder
+     *
+     */
+    struct player_state
+    {
+        glm::vec3 position;    //!< Position
+        glm::vec3 orientation; //!< Orientation
+        team_type team;        //!< Team
+        bool      alive;       //!< Is alive
+        bool      connected;   //!< Is connected
+    };
+
+    /**
+     * @brief Set fog distance (players beyond the fog are hidden)
+     *
+     * @param distance Horizontal distance
+     */
+    void set_fog_distance(float distance) noexcept
+    {
+        m_fog_distance = distance;
+    }
+
+    /**
+     * @brief Set policy for hidden slots
+     *
+     * @param policy Policy
+     */
+    void set_hidden_slot(hidden_slot_type policy) noexcept
+    {
+        m_hidden_slot = policy;
+    }
+
+    /**
+     * @brief Enable or disable culling (disabled = every slot is visible)
+     *
+     * @param enabled Enable culling
+     */
+    void set_culling(bool enabled) noexcept
+    {
+        m_culling = enabled;
+    }
+
+    /**
+     * @brief Set state of a single player (call for every slot before update)
+     *
+     * @param id Player ID
+     * @param state Player state
+     */
+    void set_player(std::size_t id, const player_state & state) noexcept
+    {
+        m_x[id]      = state.position.x;
+        m_y[id]      = state.position.y;
+        m_z[id]      = state.position.z;
+        m_team[id]   = state.team;
+        m_active[id] = state.alive && state.connected && state.team != team_type::spectator;
+        m_viewer[id] = state.connected;
+
+        auto * slot  = m_body.data() + id * slot_size;
+        std::memcpy(slot, &state.position, sizeof(glm::vec3));
+        std::memcpy(slot + sizeof(glm::vec3), &state.orientation, sizeof(glm::vec3));
+    }
+
+    /**
+     * @brief Drop data last sent to viewer (slot taken by a new connection)
+     *
+     * The stale buffer itself is cleared by the next build for the viewer, so the call is safe while
+     * another thread builds from snapshots.
+     *
+     * @param viewer Viewer ID
+     */
+    void reset_viewer(std::size_t viewer) noexcept
+    {
+        ++m_session[viewer];
+    }
+
+    /**
+     * @brief Calculate visibility of all players
+     *
+     * @param map Map (used for occlusion)
+     */
+    void update(const map & map)
+    {
+        for (std::size_t viewer = 0; viewer < max_players; ++viewer)
+        {
+            m_visible[viewer] = ~0U;
+        }
+
+        if (!m_culling)
+        {
+            return;
+        }
+
+        // rays go from the eye of the viewer to the target, so each direction is checked on its own
+        for (std::size_t viewer = 0; viewer < max_players; ++viewer)
+        {
+            if (!m_active[viewer])
+            {
+                continue; // dead players and spectators see everyone
+            }
+
+            std::uint32_t in_range = in_fog_range(viewer);
+            for (std::size_t target = 0; target < max_players; ++target)
+            {
+                if (!m_active[target] || m_team[target] == m_team[viewer])
+                {
+                    continue; // teammates are always visible
+                }
+                if ((in_range & (1U << target)) == 0 || is_occluded(map, viewer, target))
+                {
+                    m_visible[viewer] &= ~(1U << target);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Get mask of players visible to viewer
+     *
+     * @param viewer Viewer ID
+     * @return Mask (bit per player)
+     */
+    [[nodiscard]] std::uint32_t visible(std::size_t viewer) const noexcept
+    {
+        return m_visible[viewer];
+    }
+
+    /**
+     * @brief Check whether viewer receives updates
+     *
+     * @param viewer Viewer ID
+     * @return true If viewer is connected
+     */
+    [[nodiscard]] bool is_viewer(std::size_t viewer) const noexcept
+    {
+        return m_viewer[viewer];
+    }
+
+    /**
+     * @brief Store visibility masks and world update body in snapshot
+     *
+     * @param snapshot Snapshot
+     */
+    void store(world_snapshot & snapshot) const noexcept
+    {
+        snapshot.visible = m_visible;
+        snapshot.session = m_session;
+        snapshot.body    = m_body;
+    }
+
+    /**
+     * @brief Build world update body (without packet type) for viewer
+     *
+     * @param viewer Viewer ID
+     * @param output Output buffer (body_size bytes)
+     */
+    void build(std::size_t viewer, std::uint8_t * output)
+    {
+        blend(m_body.data(), m_visible[viewer], stale_body(viewer, m_session[viewer]), output);
+    }
+
+    /**
+     * @brief Build world update body (without packet type) for viewer from snapshot
+     *
+     * Only the stale buffers of the builder are touched, the call can run on a different thread than
+     * the simulation as long as it is the only thread calling build.
+     *
+     * @param snapshot Snapshot
+     * @param viewer Viewer ID
+     * @param output Output buffer (body_size bytes)
+     */
+    void build(const world_snapshot & snapshot, std::size_t viewer, std::uint8_t * output)
+    {
+        blend(snapshot.body.data(), snapshot.visible[viewer], stale_body(viewer, snapshot.session[viewer]), output);
+    }
+
+  private:
+
+    using body_type = std::array<std::uint8_t, body_size>;
+
+    /**
+     * @brief Get last body sent to viewer, cleared when the viewer is a new connection
+     *
+     * @param viewer Viewer ID
+     * @param session Connection count of the viewer slot
+     * @return Stale buffer
+     */
+    body_type & stale_body(std::size_t viewer, std::uint32_t session) noexcept
+    {
+        if (m_stale_session[viewer] != session)
+        {
+            m_stale_session[viewer] = session;
+            m_stale[viewer].fill(0);
+        }
+        return m_stale[viewer];
+    }
+
+    /**
+     * @brief Blend visible slots of body with hidden slot data
+     *
+     * @param body Full world update body
+     * @param mask Visibility mask
+     * @param stale Last body sent to the viewer
+     * @param output Output buffer (body_size bytes)
+     */
+    void blend(const std::uint8_t * body, std::uint32_t mask, body_type & stale, std::uint8_t * output) const
+    {
+        if (mask == ~0U)
+        {
+            std::memcpy(output, body, body_size);
+            std::memcpy(stale.data(), body, body_size);
+            return;
+        }
+
+        const __m128i zero = _mm_setzero_si128();
+
+        // two slots (48 bytes) per iteration
+        for (std::size_t pair = 0; pair < max_players / 2; ++pair, mask >>= 2U)
+        {
+            const auto * blend  = s_blend_masks[mask & 0x03U].lanes.data();
+            const auto   offset = pair * slot_size * 2;
+
+            for (std::size_t lane = 0; lane < 3; ++lane)
+            {
+                auto *  target   = output + offset + lane * 16;
+                auto *  previous = stale.data() + offset + lane * 16;
+                __m128i current  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(body + offset + lane * 16));
+                __m128i hidden   = m_hidden_slot == hidden_slot_type::zero ? zero : _mm_loadu_si128(reinterpret_cast<const __m128i *>(previous));
+                __m128i select   = _mm_load_si128(reinterpret_cast<const __m128i *>(blend + lane * 4));
+                __m128i result   = _mm_blendv_epi8(hidden, current, select);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(target), result);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(previous), result);
+            }
+        }
+    }
+
+    /**
+     * @brief Calculate players in fog range (horizontal distance)
+     *
+     * @param viewer Viewer ID
+     * @return Mask (bit per player)
+     */
+    [[nodiscard]] std::uint32_t in_fog_range(std::size_t viewer) const noexcept
+    {
+        const __m128 vx    = _mm_set1_ps(m_x[viewer]);
+        const __m128 vy    = _mm_set1_ps(m_y[viewer]);
+        const __m128 range = _mm_set1_ps(m_fog_distance * m_fog_distance);
+
+        std::uint32_t mask = 0;
+        for (std::size_t i = 0; i < max_players; i += 4)
+        {
+            __m128 dx = _mm_sub_ps(_mm_load_ps(&m_x[i]), vx);
+            __m128 dy = _mm_sub_ps(_mm_load_ps(&m_y[i]), vy);
+            __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            auto   in = static_cast<std::uint32_t>(_mm_movemask_ps(_mm_cmple_ps(d2, range)));
+            mask      |= in << i;
+        }
+        return mask;
+    }
+
+    /**
+     * @brief Check whether target is occluded for viewer (both head and body are behind blocks)
+     *
+     * @param map Map
+     * @param viewer Viewer ID
+     * @param target Target ID
+     * @return true If occluded
+     */
+    [[nodiscard]] bool is_occluded(const map & map, std::size_t viewer, std::size_t target) const
+    {
+        glm::vec3 eye { m_x[viewer], m_y[viewer], m_z[viewer] };
+        glm::vec3 head { m_x[target], m_y[target], m_z[target] };
+        glm::vec3 body { m_x[target], m_y[target], m_z[target] + 1.F };
+        return ray::intersects(map, eye, head) && ray::intersects(map, eye, body);
+    }
+
+    /**
+     * @brief Blend mask for a pair of slots (three SSE lanes)
+     *
+     */
+    struct blend_mask
+    {
+        alignas(16) std::array<std::int32_t, 12> lanes; //!< Lanes (loaded with _mm_load_si128)
+    };
+
+    /**
+     * @brief Generate blend masks for a pair of slots (index = visibility bits)
+     *
+     * @return Blend masks
+     */
+    static constexpr std::array<blend_mask, 4> generate_blend_masks() noexcept
+    {
+        static_assert(slot_size % sizeof(std::int32_t) == 0);
+        constexpr std::size_t slot_words = slot_size / sizeof(std::int32_t);
+
+        std::array<blend_mask, 4> result {};
+        for (std::uint32_t bits = 0; bits < 4; ++bits)
+        {
+            for (std::size_t word = 0; word < slot_words * 2; ++word)
+            {
+                auto bit                 = word < slot_words ? 0x01U : 0x02U;
+                result[bits].lanes[word] = (bits & bit) != 0 ? -1 : 0;
+            }
+        }
+        return result;
+    }
+
+    static inline const std::array<blend_mask, 4> s_blend_masks = generate_blend_masks(); //!< Blend masks
+
+    alignas(16) std::array<float, max_players> m_x {};                                   //!< Positions (x)
+    alignas(16) std::array<float, max_players> m_y {};                                   //!< Positions (y)
+    alignas(16) std::array<float, max_players> m_z {};                                   //!< Positions (z)
+    std::array<team_type, max_players>         m_team {};                                //!< Teams
+    std::array<bool, max_players>              m_active {};                              //!< Alive, connected and not spectating
+    std::array<bool, max_players>              m_viewer {};                              //!< Connected
+    std::array<std::uint32_t, max_players>     m_visible {};                             //!< Visibility masks
+    body_type                                  m_body {};                                //!< Full world update body
+    std::array<std::uint32_t, max_players>     m_session {};                             //!< Connection count of each slot
+    std::array<body_type, max_players>         m_stale {};                               //!< Last body sent to each viewer
+    std::array<std::uint32_t, max_players>     m_stale_session {};                       //!< Connection count of each stale body
+    float                                      m_fog_distance { 128.F };                 //!< Fog distance
+    hidden_slot_type                           m_hidden_slot { hidden_slot_type::zero }; //!< Hidden slot policy
+    bool                                       m_culling { true };                       //!< Culling enabled
+};
+
+} // namespace spadesx
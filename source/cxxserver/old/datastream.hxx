@@ -7,7 +7,9 @@
 
 #include "data/color.hxx"
 #include "enet.hxx"
+#include "schema.hxx"
 
+#include <bit>
 #include <cassert>
 #include <cstring>
 #include <string_view>
@@ -196,6 +198,46 @@ class data_stream
         return static_cast<T>(read_byte());
     }
 
+    /**
+     * @brief Get 8-bit word at the current position (convert to type)
+     *
+     * @tparam T The type to convert to
+     * @return Type
+     */
+    template <typename T>
+    [[nodiscard]] T peek_type() const
+    {
+        assert(m_data + 1 <= m_end);
+        return static_cast<T>(*m_data);
+    }
+
+    /**
+     * @brief Check whether the rest of the stream is a packet of valid length
+     *
+     * @param table Length table
+     * @return true If the packet ID is known and the length is within its range
+     */
+    [[nodiscard]] bool has_valid_length(const length_table & table) const noexcept
+    {
+        return is_valid_length(table, m_data, left());
+    }
+
+    /**
+     * @brief Read packet (the rest of the stream, length has to be validated)
+     *
+     * @tparam Packet Packet type
+     * @return Packet (text fields point into the stream)
+     */
+    template <typename Packet>
+    Packet read_packet() noexcept
+    {
+        auto length = left();
+        assert(length >= Packet::layout::min_size && length <= Packet::layout::max_size);
+        auto packet = decode<Packet>(m_data, length);
+        m_data      = m_end;
+        return packet;
+    }
+
     /**
      * @brief Read 32-bit word (bitcast to float)
      *
@@ -204,7 +246,7 @@ class data_stream
     float read_float()
     {
         std::uint32_t value = read_int();
-        return *reinterpret_cast<float *>(&value);
+        return std::bit_cast<float>(value);
     }
 
     /**
@@ -324,7 +366,7 @@ class data_stream
      */
     void write_float(float value)
     {
-        write_int(*reinterpret_cast<std::uint32_t *>(&value));
+        write_int(std::bit_cast<std::uint32_t>(value));
     }
 
     /**
@@ -388,6 +430,22 @@ class data_stream
         m_data += length;
     }
 
+    /**
+     * @brief Write packet
+     *
+     * @tparam Packet Packet type
+     * @param packet Packet
+     * @return Packet length
+     */
+    template <typename Packet>
+    std::size_t write_packet(const Packet & packet) noexcept
+    {
+        auto length = encode(packet, m_data);
+        assert(m_data + length <= m_end);
+        m_data += length;
+        return length;
+    }
+
   private:
 
     std::uint8_t * m_data;
@@ -0,0 +1,106 @@
+/**
+ * @file delivery.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include "data/enums.hxx"
+
+#include <array>
+#include <cstdint>
+#include <enet/enet.h>
+
+namespace spadesx {
+
+/**
+ * @brief ENet channel
+ *
+ * Every channel is sequenced on its own, so the map download does not hold back game events and
+ * lost state updates do not hold back anything.
+ *
+ */
+enum class channel_type : std::uint8_t
+{
+    game  = 0, //!< Reliable game events
+    map   = 1, //!< Map download
+    state = 2  //!< Periodic full state (newer packets replace older ones)
+};
+
+static constexpr const std::uint8_t channel_count = 3; //!< Number of channels of the host
+
+/**
+ * @brief Delivery guarantee
+ *
+ */
+enum class reliability_type : std::uint8_t
+{
+    reliable,   //!< Reliable and ordered within the channel
+    sequenced,  //!< Unreliable, older packets are dropped when a newer one arrived first
+    unsequenced //!< Unreliable and unordered
+};
+
+/**
+ * @brief Delivery policy of a packet type
+ *
+ */
+struct delivery_policy
+{
+    reliability_type reliability { reliability_type::reliable }; //!< Delivery guarantee
+    channel_type     channel { channel_type::game };             //!< Channel
+    bool             compress { true };                          //!< Payload is worth compressing
+
+    /**
+     * @brief Get ENet packet flags
+     *
+     * @return Packet flags
+     */
+    [[nodiscard]] constexpr std::uint32_t flags() const noexcept
+    {
+        std::uint32_t flags = compress ? 0 : ENET_PACKET_FLAG_NO_COMPRESS;
+        switch (reliability)
+        {
+            case reliability_type::reliable:
+                return flags | ENET_PACKET_FLAG_RELIABLE;
+            case reliability_type::unsequenced:
+                return flags | ENET_PACKET_FLAG_UNSEQUENCED;
+            default:
+                return flags;
+        }
+    }
+};
+
+/**
+ * @brief Build delivery table (packets not listed are reliable and compressed on the game channel)
+ *
+ * @return Delivery policy per packet ID
+ */
+consteval std::array<delivery_policy, 256> make_delivery_table() noexcept
+{
+    std::array<delivery_policy, 256> table {};
+
+    auto set = [&table](packet_type type, reliability_type reliability, channel_type channel, bool compress = true) {
+        table[static_cast<std::size_t>(type)] = { reliability, channel, compress };
+    };
+    // only full state may be dropped, input data is sent on change and stays a reliable game event
+    set(packet_type::world_update, reliability_type::sequenced, channel_type::state);
+    set(packet_type::map_start, reliability_type::reliable, channel_type::map);
+    // deflate output, the range coder would only burn CPU on it
+    set(packet_type::map_chunk, reliability_type::reliable, channel_type::map, false);
+    return table;
+}
+
+inline constexpr const std::array<delivery_policy, 256> delivery_table = make_delivery_table(); //!< Delivery policy per packet ID
+
+/**
+ * @brief Get delivery policy of packet type
+ *
+ * @param type Packet type
+ * @return Delivery policy
+ */
+constexpr const delivery_policy & delivery_of(packet_type type) noexcept
+{
+    return delivery_table[static_cast<std::size_t>(type)];
+}
+
+} // namespace spadesx
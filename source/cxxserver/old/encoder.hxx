@@ -0,0 +1,198 @@
+/**
+ * @file encoder.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include "cxxserver/PacketAllocator.hpp"
+#include "cxxserver/SpscRing.hpp"
+#include "data/snapshot.hxx"
+#include "data/world_update.hxx"
+#include "packet.hxx"
+
+#include <stop_token>
+#include <thread>
+
+namespace spadesx {
+
+/**
+ * @brief World update encoder (runs on the simulation thread or its own thread)
+ *
+ * Reads only published snapshots, so encoding overlaps the next step without locking. Encoded
+ * packets are handed back to the simulation thread which queues them for the connections.
+ *
+ */
+class world_update_encoder
+{
+  public:
+
+    /**
+     * @brief Encoded packet for a single viewer
+     *
+     */
+    struct encoded
+    {
+        std::uint8_t viewer; //!< Viewer ID
+        ENetPacket * packet; //!< Packet
+    };
+
+    using ring_type = cxxserver::SpscRing<encoded, 256>;
+
+    /**
+     * @brief Construct a new world_update_encoder object
+     *
+     * @param snapshots Snapshot buffer (encoder is the only reader)
+     * @param builder World update builder (encoder is the only caller of build)
+     */
+    world_update_encoder(triple_buffer<world_snapshot> & snapshots, world_update_builder & builder)
+        : m_snapshots { snapshots }
+        , m_builder { builder }
+    {
+    }
+
+    world_update_encoder(const world_update_encoder &)             = delete;
+    world_update_encoder(world_update_encoder &&)                  = delete;
+    world_update_encoder & operator=(const world_update_encoder &) = delete;
+    world_update_encoder & operator=(world_update_encoder &&)      = delete;
+
+    /**
+     * @brief Destroy the world_update_encoder object
+     *
+     */
+    ~world_update_encoder()
+    {
+        stop();
+        while (auto item = m_ready.try_pop())
+        {
+            enet_packet_destroy(item->packet);
+        }
+    }
+
+    /**
+     * @brief Start encoder thread
+     *
+     */
+    void start()
+    {
+        if (!m_thread.joinable())
+        {
+            m_thread = std::jthread { [this](const std::stop_token & token) { run(token); } };
+        }
+    }
+
+    /**
+     * @brief Stop encoder thread
+     *
+     */
+    void stop()
+    {
+        if (m_thread.joinable())
+        {
+            m_thread.request_stop();
+            m_snapshots.interrupt();
+            m_thread.join();
+        }
+    }
+
+    /**
+     * @brief Check whether encoder thread is running
+     *
+     * @return true If running
+     */
+    [[nodiscard]] bool running() const noexcept
+    {
+        return m_thread.joinable();
+    }
+
+    /**
+     * @brief Encode latest snapshot on the calling thread (encoder thread must not be running)
+     *
+     * @param function Callable with (std::uint8_t viewer, ENetPacket * packet), takes ownership of the packet
+     */
+    template <typename Function>
+    void encode_latest(Function && function)
+    {
+        encode(m_snapshots.acquire(), function);
+    }
+
+    /**
+     * @brief Take packets encoded by the encoder thread (simulation thread only)
+     *
+     * @param function Callable with (std::uint8_t viewer, ENetPacket * packet), takes ownership of the packet
+     */
+    template <typename Function>
+    void drain(Function && function)
+    {
+        while (auto item = m_ready.try_pop())
+        {
+            function(item->viewer, item->packet);
+        }
+    }
+
+  private:
+
+    /**
+     * @brief Encode snapshot if a world update became due since the last encoded one
+     *
+     * Snapshots are overwritten when the encoder falls behind, a later snapshot still carries the
+     * pending world update (with newer state).
+     *
+     * @param snapshot Snapshot
+     * @param function Callable with (std::uint8_t viewer, ENetPacket * packet)
+     */
+    template <typename Function>
+    void encode(const world_snapshot & snapshot, Function && function)
+    {
+        if (snapshot.broadcast == m_last_broadcast)
+        {
+            return;
+        }
+        m_last_broadcast = snapshot.broadcast;
+
+        m_buffer[0] = static_cast<std::uint8_t>(packet_type::world_update);
+        for (std::uint8_t viewer = 0; viewer < world_snapshot::max_players; ++viewer)
+        {
+            if ((snapshot.connected & (1U << viewer)) != 0)
+            {
+                m_builder.build(snapshot, viewer, m_buffer.data() + 1);
+                packet data { m_buffer.data(), m_buffer.size(), packet_type::world_update };
+                function(viewer, data.m_packet);
+            }
+        }
+    }
+
+    /**
+     * @brief Encoder thread
+     *
+     * @param token Stop token
+     */
+    void run(const std::stop_token & token)
+    {
+        cxxserver::PacketAllocator::warm_thread();
+
+        std::uint64_t known = 0;
+        while (!token.stop_requested())
+        {
+            known = m_snapshots.wait(known);
+            encode(
+                m_snapshots.acquire(),
+                [this](std::uint8_t viewer, ENetPacket * packet) {
+                    if (!m_ready.try_push({ viewer, packet }))
+                    {
+                        enet_packet_destroy(packet); // simulation thread fell behind
+                    }
+                }
+            );
+        }
+    }
+
+    triple_buffer<world_snapshot> &                     m_snapshots;            //!< Published snapshots
+    world_update_builder &                              m_builder;              //!< Builder (stale buffers)
+    ring_type                                           m_ready;                //!< Encoded packets
+    std::array<std::uint8_t, packet::world_update_size> m_buffer {};            //!< Encode buffer
+    std::uint64_t                                       m_last_broadcast { 0 }; //!< Last encoded world update
+    std::jthread                                        m_thread;               //!< Encoder thread
+};
+
+} // namespace spadesx
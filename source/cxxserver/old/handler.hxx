@@ -6,12 +6,20 @@
 #pragma once
 
 #include "data/enums.hxx"
-#include "data/grenade.hxx"
+#include "data/grenade_pool.hxx"
+#include "data/hitbox.hxx"
+#include "data/hitscan.hxx"
 #include "data/line.hxx"
+#include "data/movement_reconciler.hxx"
+#include "data/player_store.hxx"
+#include "data/position_history.hxx"
+#include "data/spatial_hash.hxx"
+#include "data/timer_wheel.hxx"
 #include "manager.hxx"
 
 #include <glm/gtx/string_cast.hpp>
-#include <list>
+#include <optional>
+#include <span>
 
 namespace spadesx {
 
@@ -44,9 +52,8 @@ class server_handler : public connection_manager
      */
     void handle_position_data(connection & source, data_stream & stream)
     {
-        glm::vec3 position;
-        stream.read_vec3(position);
-        on_position_data(source, position);
+        auto packet = stream.read_packet<packets::position_data>();
+        on_position_data(source, packet.position);
     }
 
     /**
@@ -57,9 +64,8 @@ class server_handler : public connection_manager
      */
     void handle_orientation_data(connection & source, data_stream & stream)
     {
-        glm::vec3 orientation;
-        stream.read_vec3(orientation);
-        on_orientation_data(source, orientation);
+        auto packet = stream.read_packet<packets::orientation_data>();
+        on_orientation_data(source, packet.orientation);
     }
 
     /**
@@ -70,13 +76,13 @@ class server_handler : public connection_manager
      */
     void handle_input_data(connection & source, data_stream & stream)
     {
-        if (source.id() != stream.read_byte())
+        auto packet = stream.read_packet<packets::input_data>();
+        if (source.id() != packet.player_id)
         {
             std::cout << "[WARNING]: input data - invalid id received" << std::endl;
         }
 
-        auto input = stream.read_byte();
-        on_input_data(source, input);
+        on_input_data(source, packet.input);
     }
 
     /**
@@ -87,13 +93,13 @@ class server_handler : public connection_manager
      */
     void handle_weapon_input(connection & source, data_stream & stream)
     {
-        if (source.id() != stream.read_byte())
+        auto packet = stream.read_packet<packets::weapon_input>();
+        if (source.id() != packet.player_id)
         {
             std::cout << "[WARNING]: weapon input - invalid id received" << std::endl;
         }
 
-        auto input = stream.read_byte();
-        on_weapon_input(source, (input & 0x01) != 0, (input & 0x02) != 0);
+        on_weapon_input(source, (packet.input & 0x01) != 0, (packet.input & 0x02) != 0);
     }
 
     /**
@@ -104,14 +110,13 @@ class server_handler : public connection_manager
      */
     void handle_hit_packet(connection & source, data_stream & stream)
     {
-        auto target = stream.read_byte();
-        auto type   = stream.read_type<hit_type>();
-        if (target < m_num_players)
+        auto packet = stream.read_packet<packets::hit_packet>();
+        if (packet.target < m_num_players)
         {
-            auto & victim = m_connections[target];
+            auto & victim = m_connections[packet.target];
             if (victim.is_connected())
             {
-                on_packet_hit(source, victim, type);
+                on_packet_hit(source, victim, packet.type);
             }
             else
             {
@@ -132,20 +137,13 @@ class server_handler : public connection_manager
      */
     void handle_grenade_packet(connection & source, data_stream & stream)
     {
-        if (source.id() != stream.read_byte())
+        auto packet = stream.read_packet<packets::grenade_packet>();
+        if (source.id() != packet.player_id)
         {
             std::cout << "[WARNING]: grenade packet - invalid id received" << std::endl;
         }
 
-        float     fuse;
-        glm::vec3 position;
-        glm::vec3 velocity;
-
-        fuse = stream.read_float();
-        stream.read_vec3(position);
-        stream.read_vec3(velocity);
-
-        on_grenade_throw(source, position, velocity, fuse);
+        on_grenade_throw(source, packet.position, packet.velocity, packet.fuse);
     }
 
     /**
@@ -156,19 +154,19 @@ class server_handler : public connection_manager
      */
     void handle_set_tool(connection & source, data_stream & stream)
     {
-        if (source.id() != stream.read_byte())
+        auto packet = stream.read_packet<packets::set_tool>();
+        if (source.id() != packet.player_id)
         {
             std::cout << "[WARNING]: set tool - invalid id received" << std::endl;
         }
 
-        auto tool = stream.read_type<tool_type>();
-        switch (tool)
+        switch (packet.tool)
         {
             case tool_type::spade:
             case tool_type::block:
             case tool_type::gun:
             case tool_type::grenade:
-                on_set_tool(source, tool);
+                on_set_tool(source, packet.tool);
                 return;
             default:
                 std::cout << "[WARNING]: set tool - invalid type" << std::endl;
@@ -184,14 +182,13 @@ class server_handler : public connection_manager
      */
     void handle_set_color(connection & source, data_stream & stream)
     {
-        if (source.id() != stream.read_byte())
+        auto packet = stream.read_packet<packets::set_color>();
+        if (source.id() != packet.player_id)
         {
             std::cout << "[WARNING]: set color - invalid id received" << std::endl;
         }
 
-        color3b color;
-        stream.read_color3b(color);
-        on_set_color(source, color);
+        on_set_color(source, packet.color);
     }
 
     /**
@@ -202,22 +199,19 @@ class server_handler : public connection_manager
      */
     void handle_block_action(connection & source, data_stream & stream)
     {
-        if (source.id() != stream.read_byte())
+        auto packet = stream.read_packet<packets::block_action>();
+        if (source.id() != packet.player_id)
         {
             std::cout << "[WARNING]: block action - invalid id received" << std::endl;
         }
 
-        auto action = stream.read_type<block_action_type>();
-        auto x      = stream.read_int();
-        auto y      = stream.read_int();
-        auto z      = stream.read_int();
-
-        if (x >= map::size_x || y >= map::size_y || z >= map::size_z)
+        const auto & position = packet.position;
+        if (position.x >= map::size_x || position.y >= map::size_y || position.z >= map::size_z)
         {
             return;
         }
 
-        on_block_action(source, action, x, y, z);
+        on_block_action(source, packet.action, position.x, position.y, position.z);
     }
 
     /**
@@ -228,17 +222,13 @@ class server_handler : public connection_manager
      */
     void handle_block_line(connection & source, data_stream & stream)
     {
-        if (source.id() != stream.read_byte())
+        auto packet = stream.read_packet<packets::block_line>();
+        if (source.id() != packet.player_id)
         {
             std::cout << "[WARNING]: block line - invalid id received" << std::endl;
         }
 
-        glm::uvec3 start;
-        glm::uvec3 end;
-        stream.read_uvec3(start);
-        stream.read_uvec3(end);
-
-        on_block_line(source, start, end);
+        on_block_line(source, packet.start, packet.end);
     }
 
     /**
@@ -249,25 +239,18 @@ class server_handler : public connection_manager
      */
     void handle_chat_message(connection & source, data_stream & stream)
     {
-        if (source.id() != stream.read_byte())
+        auto packet = stream.read_packet<packets::chat_message>();
+        if (source.id() != packet.player_id)
         {
             std::cout << "[WARNING]: chat message - invalid id received" << std::endl;
         }
 
-        auto         type = stream.read_type<chat_type>();
-        const auto * data = stream.data();
-        auto         left = stream.left();
-        if (data[left - 1] == 0)
-        {
-            left -= 1;
-        }
-
-        switch (type)
+        switch (packet.type)
         {
             case chat_type::all:
             case chat_type::team:
             case chat_type::system:
-                on_message(source, type, { data, left });
+                on_message(source, packet.type, packet.message.value);
                 return;
             default:
                 std::cout << "[WARNING]: chat message - invalid type" << std::endl;
@@ -283,15 +266,13 @@ class server_handler : public connection_manager
      */
     void handle_weapon_reload(connection & source, data_stream & stream)
     {
-        if (source.id() != stream.read_byte())
+        auto packet = stream.read_packet<packets::weapon_reload>();
+        if (source.id() != packet.player_id)
         {
             std::cout << "[WARNING]: weapon reload - invalid id received" << std::endl;
         }
 
-        auto clip    = stream.read_byte();
-        auto reserve = stream.read_byte();
-
-        on_weapon_reload(source, clip, reserve);
+        on_weapon_reload(source, packet.clip_ammo, packet.reserve_ammo);
     }
 
     /**
@@ -302,18 +283,18 @@ class server_handler : public connection_manager
      */
     void handle_team_change(connection & source, data_stream & stream)
     {
-        if (source.id() != stream.read_byte())
+        auto packet = stream.read_packet<packets::change_team>();
+        if (source.id() != packet.player_id)
         {
             std::cout << "[WARNING]: change team - invalid id received" << std::endl;
         }
 
-        auto team = stream.read_type<team_type>();
-        switch (team)
+        switch (packet.team)
         {
             case team_type::a:
             case team_type::b:
             case team_type::spectator:
-                on_team_change(source, team);
+                on_team_change(source, packet.team);
                 return;
             default:
                 std::cout << "[WARNING]: change team - invalid type" << std::endl;
@@ -329,18 +310,18 @@ class server_handler : public connection_manager
      */
     void handle_weapon_change(connection & source, data_stream & stream)
     {
-        if (source.id() != stream.read_byte())
+        auto packet = stream.read_packet<packets::change_weapon>();
+        if (source.id() != packet.player_id)
         {
             std::cout << "[WARNING]: change weapon - invalid id received" << std::endl;
         }
 
-        auto weapon = stream.read_type<weapon_type>();
-        switch (weapon)
+        switch (packet.weapon)
         {
             case weapon_type::rifle:
             case weapon_type::smg:
             case weapon_type::shotgun:
-                on_weapon_change(source, weapon);
+                on_weapon_change(source, packet.weapon);
                 return;
             default:
                 std::cout << "[WARNING]: change weapon - invalid type" << std::endl;
@@ -356,32 +337,16 @@ class server_handler : public connection_manager
      */
     void handle_existing_player(connection & source, data_stream & stream)
     {
-        if (source.id() != stream.read_byte())
+        auto packet = stream.read_packet<packets::existing_player>();
+        if (source.id() != packet.player_id)
         {
             std::cout << "[WARNING]: existing player - invalid id received" << std::endl;
         }
 
-        auto    team   = stream.read_type<team_type>();
-        auto    weapon = stream.read_type<weapon_type>();
-        auto    tool   = stream.read_type<tool_type>();
-        auto    kills  = stream.read_int();
-        color3b color;
-        stream.read_color3b(source.m_color);
-
-        const auto * data = stream.data();
-        auto         left = stream.left();
-        for (auto i = 0; i < left; ++i)
-        {
-            if (data[i] == 0)
-            {
-                left = i;
-                break;
-            }
-        }
-
+        source.m_color      = packet.color;
         source.m_has_joined = true;
 
-        on_existing_player(source, team, weapon, tool, kills, color, { data, left });
+        on_existing_player(source, packet.team, packet.weapon, packet.tool, packet.kills, packet.color, packet.name.value);
     }
 
     /**
@@ -465,7 +430,7 @@ class server_handler : public connection_manager
      */
     virtual void on_kill(connection & killer, connection & victim, kill_type type, std::uint8_t respawn_time)
     {
-        kill_and_broadcast(killer, victim, type, respawn_time);
+        kill(killer, victim, type, respawn_time);
     }
 
     /**
@@ -476,9 +441,27 @@ class server_handler : public connection_manager
      */
     virtual void on_position_data(connection & source, const glm::vec3 & position)
     {
-        // if (glm::distance(source.m_position, position) >= 0.1F) {
-        source.m_position = position;
-        // }
+        if (m_validate_movement)
+        {
+            m_reconciler.report(source.id(), position); // reconciled by move_players
+        }
+        else
+        {
+            source.m_position = position;
+        }
+    }
+
+    /**
+     * @brief Reported position rejected by the movement reconciler
+     *
+     * The player has already been moved back to its server position.
+     *
+     * @param source Source connection
+     * @param error Distance between the reported and the simulated position
+     */
+    virtual void on_movement_violation(connection & source, float error)
+    {
+        std::cout << "[WARNING]: position data - " << source.name() << " corrected (error " << error << ")" << std::endl;
     }
 
     /**
@@ -501,6 +484,7 @@ class server_handler : public connection_manager
     virtual void on_input_data(connection & source, std::uint8_t input)
     {
         source.input_from_byte(input);
+        m_players.wake(source.id());
 
         source.set_jump(source.m_jump);
         source.set_crouch(source.m_crouch);
@@ -552,6 +536,16 @@ class server_handler : public connection_manager
         }
         else
         {
+            if (m_validate_hits)
+            {
+                auto validated = validate_hit(source, target, type);
+                if (!validated)
+                {
+                    std::cout << "[WARNING]: hit packet - impossible hit rejected" << std::endl;
+                    return;
+                }
+                type = *validated;
+            }
             damage = source.get_weapon_damage(type);
         }
 
@@ -582,6 +576,110 @@ class server_handler : public connection_manager
         }
     }
 
+    /**
+     * @brief Validate hit against the target as the shooter saw it
+     *
+     * The target is rewound by half of the shooter's round trip time plus the world update latency,
+     * the view ray of the shooter is tested against its hitboxes and the map up to the hit.
+     *
+     * @param source Shooter
+     * @param target Target
+     * @param type Claimed hit type
+     * @return Hit type to be applied (claimed one if that box was hit, nearest otherwise), nothing if the hit was not possible
+     */
+    [[nodiscard]] std::optional<hit_type> validate_hit(const connection & source, const connection & target, hit_type type) const
+    {
+        const auto * sample = m_history.rewind(target.id(), rewind_time(source));
+        if (sample == nullptr)
+        {
+            return type; // nothing recorded yet
+        }
+        if (!sample->alive || glm::length(source.m_orientation) < 1e-6F)
+        {
+            return std::nullopt;
+        }
+
+        auto direction = glm::normalize(source.m_orientation);
+        auto hits      = hitbox::cast(source.m_position, direction, sample->position, sample->orientation, sample->crouching, m_hit_tolerance);
+        if (hits.mask == 0)
+        {
+            return std::nullopt;
+        }
+
+        ray::sweep_hit block {};
+        if (ray::sweep(*m_map, source.m_position, source.m_position + direction * hits.distance, block))
+        {
+            return std::nullopt; // occluded
+        }
+        return ((hits.mask >> static_cast<std::uint8_t>(type)) & 1U) != 0 ? type : hits.type;
+    }
+
+    /**
+     * @brief Resolve shot on the server (anti-cheat sampling)
+     *
+     * All players are rewound as the shooter saw them, the shooter's team is not tested. Damage of
+     * the result is given by hitscan::damage.
+     *
+     * @param source Shooter
+     * @param directions Normalized ray directions (view ray or shotgun pellets)
+     * @param hits Nearest visible hit of every ray (same size as directions)
+     */
+    void resolve_shot(const connection & source, std::span<const glm::vec3> directions, std::span<std::optional<hitscan::hit>> hits)
+    {
+        std::uint32_t ignore = 0;
+        for (const auto & connection : m_connections)
+        {
+            if (connection.team() == source.team())
+            {
+                ignore |= 1U << connection.id();
+            }
+        }
+        m_hitscan.load(m_history, rewind_time(source));
+        m_hitscan.cast_batch(*m_map, source.m_position, directions, ignore, m_hit_tolerance, hits);
+    }
+
+    /**
+     * @brief Get how far back the shooter saw other players
+     *
+     * @param source Shooter
+     * @return Half of the round trip time plus the world update latency (seconds)
+     */
+    [[nodiscard]] float rewind_time(const connection & source) const noexcept
+    {
+        return float(source.round_trip_time()) / 2000.F + m_hit_latency;
+    }
+
+    /**
+     * @brief Record positions of all players (once per step)
+     *
+     * @param tick Step number
+     * @param delta Step length
+     */
+    void record_history(std::uint64_t tick, float delta)
+    {
+        m_history.record(tick, delta, m_connections);
+    }
+
+    /**
+     * @brief Enable or disable validation of reported positions
+     *
+     * @param enable Enable
+     */
+    void set_movement_validation(bool enable) noexcept
+    {
+        m_validate_movement = enable;
+    }
+
+    /**
+     * @brief Enable or disable server side hit validation
+     *
+     * @param enable Enable
+     */
+    void set_hit_validation(bool enable) noexcept
+    {
+        m_validate_hits = enable;
+    }
+
     /**
      * @brief On fall damage
      *
@@ -598,7 +696,7 @@ class server_handler : public connection_manager
         }
         else
         {
-            kill_and_broadcast(source, source, kill_type::fall, m_respawn_time);
+            kill(source, source, kill_type::fall, m_respawn_time);
         }
     }
 
@@ -614,39 +712,46 @@ class server_handler : public connection_manager
         {
             return;
         }
-        for (auto & connection : m_connections)
-        {
+        m_spatial.query_radius(grenade.m_position, m_grenade_distance, [&](std::uint8_t target, float distance) {
+            auto & connection = m_connections[target];
             if (connection.id() == id || !grenade.is_same_team(connection))
             {
-                if (auto distance = grenade.distance(connection); distance <= m_grenade_distance)
+                if (auto & source = m_connections[id]; source.is_connected())
                 {
-                    if (auto & source = m_connections[id]; source.is_connected())
+                    if (!ray::intersects(*m_map, connection.m_position, grenade.m_position))
                     {
-                        if (!ray::intersects(*m_map, connection.m_position, grenade.m_position))
+                        int dmg = int(4096.F / (distance * distance));
+                        if (connection.m_health < dmg)
+                        {
+                            kill(source, connection, kill_type::grenade, m_respawn_time);
+                        }
+                        else
                         {
-                            int dmg = int(4096.F / (distance * distance));
-                            if (connection.m_health < dmg)
-                            {
-                                kill_and_broadcast(source, connection, kill_type::grenade, m_respawn_time);
-                            }
-                            else
-                            {
-                                connection.m_health -= dmg;
-                                connection.send_set_hp(source.m_position, true);
-                            }
+                            connection.m_health -= dmg;
+                            connection.send_set_hp(source.m_position, true);
                         }
                     }
                 }
             }
-        }
+        });
         if (auto & source = m_connections[id]; source.is_connected())
         {
             glm::ivec3 v = grenade.m_position;
             m_map->destroy_block_grenade(v.x, v.y, v.z);
+            wake_players(v);
             broadcast_block_action(source, v.x, v.y, v.z, block_action_type::grenade);
         }
     }
 
+    /**
+     * @brief On trigger enter or exit (trigger IDs are object IDs)
+     *
+     * @param source Source connection
+     * @param trigger Trigger
+     * @param enter Entered (true) or left (false)
+     */
+    virtual void on_trigger(connection & /*source*/, std::uint8_t /*trigger*/, bool /*enter*/) { }
+
     /**
      * @brief Throw grenade
      *
@@ -657,11 +762,10 @@ class server_handler : public connection_manager
      */
     virtual void on_grenade_throw(connection & source, const glm::vec3 & position, const glm::vec3 & velocity, float fuse)
     {
-        if (source.m_grenades > 0)
+        if (source.m_grenades > 0 && m_grenades.add(source.id(), source.team(), position, velocity, fuse))
         {
             --source.m_grenades;
 
-            m_grenades.emplace_back(source, position, velocity, fuse);
             broadcast_grenade(source, position, velocity, fuse);
         }
     }
@@ -742,6 +846,7 @@ class server_handler : public connection_manager
             default:
                 return;
         }
+        wake_players({ x, y, z });
         broadcast_block_action(source, x, y, z, action);
     }
 
@@ -775,6 +880,7 @@ class server_handler : public connection_manager
         {
             const auto & block = m_line.get(i);
             m_map->modify_block(block.x, block.y, block.z, true, source.m_color.to_uint());
+            wake_players(block);
         }
 
         broadcast_block_line(source, start, end);
@@ -839,9 +945,9 @@ class server_handler : public connection_manager
         connection &     source,
         team_type        team,
         weapon_type      weapon,
-        tool_type        tool,
-        std::uint32_t    kills,
-        const color3b &  color,
+        tool_type        /*tool*/,
+        std::uint32_t    /*kills*/,
+        const color3b &  /*color*/,
         std::string_view name
     )
     {
@@ -879,7 +985,7 @@ class server_handler : public connection_manager
      *
      * @param string File path
      */
-    void load_map(std::string_view string)
+    void load_map(std::string_view /*string*/)
     {
         // m_map->read_from_file(string);
     }
@@ -910,41 +1016,212 @@ class server_handler : public connection_manager
     }
 
     /**
-     * @brief World update
+     * @brief Move range of players (reads map, writes only the moved players)
+     *
+     * Hot state is gathered into the SoA player store, moved four players at a time and scattered
+     * back. Disjoint ranges starting at multiples of 4 can be moved in parallel, fall damage is
+     * applied in apply_fall_damage. Latencies come from sample_latency, the peers are not touched.
      *
      * @param delta Delta time
+     * @param begin First player ID
+     * @param end Last player ID (exclusive)
      */
-    void world_update(float delta)
+    void move_players(float delta, std::size_t begin, std::size_t end)
+    {
+        std::uint32_t asleep = 0;
+        for (auto id = begin; id < end; ++id)
+        {
+            if (m_players.asleep(id, m_connections[id]))
+            {
+                asleep |= 1U << id;
+            }
+            else
+            {
+                m_players.load(id, m_connections[id]);
+            }
+        }
+        m_players.move(*m_map, delta, begin, end, m_fall_damage);
+        for (auto id = begin; id < end; ++id)
+        {
+            auto & connection = m_connections[id];
+            if (connection.m_alive && ((asleep >> id) & 1U) == 0)
+            {
+                m_players.store(id, connection);
+            }
+            m_reconciler.reconcile(connection, m_latency[id], delta);
+        }
+    }
+
+    /**
+     * @brief Sample half round trip times used by move_players
+     *
+     * Reads the link state published by the network worker once per tick, before players are moved
+     * by jobs.
+     *
+     */
+    void sample_latency()
+    {
+        for (std::size_t id = 0; id < m_connections.size(); ++id)
+        {
+            m_latency[id] = float(m_connections[id].round_trip_time()) / 2000.F;
+        }
+    }
+
+    /**
+     * @brief Apply fall damage collected by move_players (in player order)
+     *
+     */
+    void apply_fall_damage()
+    {
+        for (std::size_t id = 0; id < m_connections.size(); ++id)
+        {
+            if (m_fall_damage[id] > 0)
+            {
+                on_fall_damage(m_connections[id], m_fall_damage[id]);
+            }
+            m_fall_damage[id] = 0;
+        }
+    }
+
+    /**
+     * @brief Kill and broadcast, the victim can respawn when its respawn timer fires
+     *
+     * @param killer Killer
+     * @param victim Victim
+     * @param type Kill type
+     * @param respawn_time Respawn time (seconds)
+     */
+    void kill(connection & killer, connection & victim, kill_type type, std::uint8_t respawn_time)
+    {
+        kill_and_broadcast(killer, victim, type, respawn_time);
+        start_countdown(m_respawn_timers[victim.id()], victim.m_respawn_time);
+    }
+
+    /**
+     * @brief Restart timer clearing a countdown when it expires
+     *
+     * @param timer Timer of the countdown
+     * @param seconds Countdown (seconds), set to zero by the timer
+     */
+    void start_countdown(timer_wheel::handle & timer, std::uint8_t & seconds)
+    {
+        m_timers.cancel(timer);
+        if (seconds != 0)
+        {
+            timer = m_timers.schedule(std::uint64_t { seconds } * 1000, [&seconds] { seconds = 0; });
+        }
+    }
+
+    /**
+     * @brief Cancel all timers of a player
+     *
+     * @param source Player
+     */
+    void cancel_timers(const connection & source)
+    {
+        m_timers.cancel(m_respawn_timers[source.id()]);
+        m_timers.cancel(m_restock_timers[source.id()]);
+    }
+
+    /**
+     * @brief Wake sleeping players near an edited block
+     *
+     * @param block Edited block
+     */
+    void wake_players(const glm::ivec3 & block)
+    {
+        m_spatial.query_radius(glm::vec3(block) + 0.5F, m_wake_distance, [this](std::uint8_t id, float) { m_players.wake(id); });
+    }
+
+    /**
+     * @brief Send corrections collected by move_players (in player order)
+     *
+     */
+    void apply_corrections()
     {
         for (auto & connection : m_connections)
         {
-            if (connection.m_alive)
+            float error;
+            if (m_reconciler.take_correction(connection.id(), error))
             {
-                world_update_player(connection, delta);
+                connection.send_position_data();
+                on_movement_violation(connection, error);
             }
         }
     }
 
     /**
-     * @brief Update all active grenades
+     * @brief World update
      *
      * @param delta Delta time
      */
-    void grenades_update(float delta)
+    void world_update(float delta)
     {
-        for (auto it = m_grenades.begin(), end = m_grenades.end(); it != end;)
+        sample_latency();
+        move_players(delta, 0, m_connections.size());
+        apply_fall_damage();
+        apply_corrections();
+    }
+
+    /**
+     * @brief Move alive players in the spatial hash and process trigger events
+     *
+     */
+    void update_spatial()
+    {
+        for (auto & connection : m_connections)
         {
-            it->update(*m_map, delta);
-            if (it->m_fuse <= 0.F)
+            if (connection.m_alive)
             {
-                on_grenade_explosion(*it);
-                it = m_grenades.erase(it);
+                m_spatial.update(connection.id(), connection.m_position);
             }
             else
             {
-                ++it;
+                m_spatial.remove(connection.id());
             }
         }
+
+        // handlers may move triggers and append events
+        for (std::size_t index = 0; index < m_spatial.events().size(); ++index)
+        {
+            auto event = m_spatial.events()[index];
+            on_trigger(m_connections[event.entity], event.trigger, event.enter);
+        }
+        m_spatial.clear_events();
+    }
+
+    /**
+     * @brief Move all active grenades and collect expired ones (reads map, writes only grenades)
+     *
+     * @param delta Delta time
+     */
+    void grenades_move(float delta)
+    {
+        m_grenades.update(*m_map, delta);
+    }
+
+    /**
+     * @brief Explode grenades collected by grenades_move
+     *
+     */
+    void grenades_explode()
+    {
+        for (const auto & grenade : m_grenades.explosions())
+        {
+            on_grenade_explosion(grenade);
+        }
+        m_grenades.clear_explosions();
+    }
+
+    /**
+     * @brief Update all active grenades
+     *
+     * @param delta Delta time
+     */
+    void grenades_update(float delta)
+    {
+        grenades_move(delta);
+        grenades_explode();
     }
 
     /**
@@ -959,14 +1236,29 @@ class server_handler : public connection_manager
 
   protected:
 
-    float                m_melee_distance { 5.F };    //!< Melee distance
-    float                m_grenade_distance { 16.F }; //!< Grenade distance
-    std::uint8_t         m_melee_damage { 50 };       //!< Melee damage
-    block_line           m_line;                      //!< Block line
-    std::uint8_t         m_respawn_time { 0 };        //!< Current respawn time
-    std::unique_ptr<map> m_map;                       //!< Map
-    color3b              m_fog_color;                 //!< Fog color
-    std::list<grenade>   m_grenades;                  //!< List of currently active grenades
+    float                               m_melee_distance { 5.F };     //!< Melee distance
+    float                               m_grenade_distance { 16.F };  //!< Grenade distance
+    std::uint8_t                        m_melee_damage { 50 };        //!< Melee damage
+    block_line                          m_line;                       //!< Block line
+    std::uint8_t                        m_respawn_time { 0 };         //!< Current respawn time
+    std::unique_ptr<map>                m_map;                        //!< Map
+    color3b                             m_fog_color;                  //!< Fog color
+    grenade_pool                        m_grenades;                   //!< Currently active grenades
+    spatial_hash                        m_spatial;                    //!< Alive players and triggers
+    position_history                    m_history;                    //!< Recent player positions (hit validation)
+    hitscan                             m_hitscan;                    //!< Player hitboxes for server side shots
+    bool                                m_validate_hits { true };     //!< Validate hit packets
+    float                               m_hit_tolerance { 0.5F };     //!< Hitbox growth for hit validation
+    float                               m_hit_latency { 0.05F };      //!< Client interpolation latency (seconds)
+    std::array<int, 32>                 m_fall_damage {};             //!< Fall damage collected by move_players
+    std::array<float, 32>               m_latency {};                 //!< Half round trip times (seconds) sampled before moving
+    movement_reconciler                 m_reconciler;                 //!< Reported positions against the simulation
+    bool                                m_validate_movement { true }; //!< Validate position data
+    player_store                        m_players;                    //!< Hot movement state (SoA)
+    float                               m_wake_distance { 4.F };      //!< Block edits wake sleeping players within this distance
+    timer_wheel                         m_timers;                     //!< Game timers (advanced once per step)
+    std::array<timer_wheel::handle, 32> m_respawn_timers {};          //!< Respawn countdowns
+    std::array<timer_wheel::handle, 32> m_restock_timers {};          //!< Restock countdowns
 };
 
 } // namespace spadesx
@@ -6,6 +6,9 @@
 #pragma once
 
 #include "command.hxx"
+#include "data/snapshot.hxx"
+#include "data/world_update.hxx"
+#include "encoder.hxx"
 
 namespace spadesx {
 
@@ -73,9 +76,8 @@ class connection_manager
      *
      * @param source Source connection
      * @param packet Packet to be broadcastted
-     * @param channel Channel
      */
-    void broadcast(const connection & source, packet packet, std::uint8_t channel = 0)
+    void broadcast(const connection & source, packet packet)
     {
         for (auto & connection : m_connections)
         {
@@ -85,7 +87,7 @@ class connection_manager
             }
             if (!connection.is_disconnected())
             {
-                connection.send(packet, channel);
+                connection.send(packet);
             }
         }
     }
@@ -94,15 +96,14 @@ class connection_manager
      * @brief Broadcast same data to multiple connections
      *
      * @param packet Packet to be broadcastted
-     * @param channel Channel
      */
-    void broadcast(packet packet, std::uint8_t channel = 0)
+    void broadcast(packet packet)
     {
         for (auto & connection : m_connections)
         {
             if (!connection.is_disconnected())
             {
-                connection.send(packet, channel);
+                connection.send(packet);
             }
         }
     }
@@ -112,21 +113,19 @@ class connection_manager
      *
      * @param source Source connection
      * @param include_sender If true, include sender
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_input_data(connection & source, bool include_sender = false, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_input_data(connection & source, bool include_sender = false)
     {
-        packet packet(nullptr, packet::input_data_size, unsequenced);
+        packet packet(nullptr, packet::input_data_size, packet_type::input_data);
         auto   stream = packet.stream();
         source.fill_input_data(stream);
         if (!include_sender)
         {
-            broadcast(source, packet, channel);
+            broadcast(source, packet);
         }
         else
         {
-            broadcast(packet, channel);
+            broadcast(packet);
         }
     }
 
@@ -134,67 +133,61 @@ class connection_manager
      * @brief Broadcast weapon input
      *
      * @param source Source connection
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_weapon_input(connection & source, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_weapon_input(connection & source)
     {
-        packet packet(nullptr, packet::weapon_input_size, unsequenced);
+        packet packet(nullptr, packet::weapon_input_size, packet_type::weapon_input);
         auto   stream = packet.stream();
         source.fill_weapon_input(stream);
-        broadcast(source, packet, channel);
+        broadcast(source, packet);
     }
 
     /**
      * @brief Broadcast create player packet
      *
      * @param connection Player to be created
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_create(connection & connection, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_create(connection & connection)
     {
         data_stream stream { m_cache, packet::create_player_size };
         auto        size = connection.fill_create_player(stream);
-        broadcast({ m_cache, size, unsequenced }, channel);
+        broadcast({ m_cache, size, packet_type::create_player });
     }
 
     /**
      * @brief Broadcast player left
      *
      * @param connection Connection
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_leave(connection & connection, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_leave(connection & connection)
     {
-        packet packet(nullptr, packet::player_left_size, unsequenced);
+        packet packet(nullptr, packet::player_left_size, packet_type::player_left);
         auto   stream = packet.stream();
         connection.fill_player_left(stream);
-        broadcast(connection, packet, channel);
+        broadcast(connection, packet);
     }
 
     /**
      * @brief Broadcast kill action
      *
+     * Does not start the respawn countdown, kills go through server_handler::kill.
+     *
      * @param killer Killer
      * @param victim Victim
      * @param type Kill type
      * @param respawn_time Respawn time
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
     void
-    kill_and_broadcast(connection & killer, connection & victim, kill_type type, std::uint8_t respawn_time, bool unsequenced = false, std::uint8_t channel = 0)
+    kill_and_broadcast(connection & killer, connection & victim, kill_type type, std::uint8_t respawn_time)
     {
         victim.set_last_kill(killer.id(), type);
         victim.m_respawn_time = respawn_time;
         victim.reset_death();
 
-        packet packet(nullptr, packet::kill_action_size, unsequenced);
+        packet packet(nullptr, packet::kill_action_size, packet_type::kill_action);
         auto   stream = packet.stream();
         victim.fill_kill_action(stream);
-        broadcast(packet, channel);
+        broadcast(packet);
     }
 
     /**
@@ -204,22 +197,18 @@ class connection_manager
      * @param position Initial position
      * @param velocity Initial velocity
      * @param fuse Fuse time
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
     void broadcast_grenade(
         connection &      source,
         const glm::vec3 & position,
         const glm::vec3 & velocity,
-        float             fuse,
-        bool              unsequenced = false,
-        std::uint8_t      channel     = 0
+        float             fuse
     )
     {
-        packet packet(nullptr, packet::grenade_packet_size, unsequenced);
+        packet packet(nullptr, packet::grenade_packet_size, packet_type::grenade_packet);
         auto   stream = packet.stream();
         source.fill_grenade_packet(stream, position, velocity, fuse);
-        broadcast(source, packet, channel);
+        broadcast(source, packet);
     }
 
     /**
@@ -230,23 +219,19 @@ class connection_manager
      * @param y The y-coordinate of the block (or grenade)
      * @param z The z-coordinate of the block (or grenade)
      * @param action Block action
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
     void broadcast_block_action(
         connection &      source,
         std::uint32_t     x,
         std::uint32_t     y,
         std::uint32_t     z,
-        block_action_type action,
-        bool              unsequenced = false,
-        std::uint8_t      channel     = 0
+        block_action_type action
     )
     {
-        packet packet(nullptr, packet::block_action_size, unsequenced);
+        packet packet(nullptr, packet::block_action_size, packet_type::block_action);
         auto   stream = packet.stream();
         source.fill_block_action(stream, x, y, z, action);
-        broadcast(packet, channel);
+        broadcast(packet);
     }
 
     /**
@@ -255,100 +240,155 @@ class connection_manager
      * @param source Source connection
      * @param start Start position
      * @param end End position
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_block_line(connection & source, const glm::ivec3 & start, const glm::ivec3 & end, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_block_line(connection & source, const glm::ivec3 & start, const glm::ivec3 & end)
     {
-        packet packet(nullptr, packet::block_line_size, unsequenced);
+        packet packet(nullptr, packet::block_line_size, packet_type::block_line);
         auto   stream = packet.stream();
         source.fill_block_line(stream, start, end);
-        broadcast(packet, channel);
+        broadcast(packet);
     }
 
     /**
      * @brief Broadcast set tool
      *
      * @param source Source connection
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_set_tool(connection & source, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_set_tool(connection & source)
     {
-        packet packet(nullptr, packet::set_tool_size, unsequenced);
+        packet packet(nullptr, packet::set_tool_size, packet_type::set_tool);
         auto   stream = packet.stream();
         source.fill_set_tool(stream);
-        broadcast(source, packet, channel);
+        broadcast(source, packet);
     }
 
     /**
      * @brief Broadcast set color
      *
      * @param source Source connection
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_set_color(connection & source, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_set_color(connection & source)
     {
-        packet packet(nullptr, packet::set_color_size, unsequenced);
+        packet packet(nullptr, packet::set_color_size, packet_type::set_color);
         auto   stream = packet.stream();
         source.fill_set_color(stream);
-        broadcast(source, packet, channel);
+        broadcast(source, packet);
     }
 
     /**
      * @brief Broadcast weapon reload
      *
      * @param source Source connection
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_weapon_reload(connection & source, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_weapon_reload(connection & source)
     {
-        packet packet(nullptr, packet::weapon_reload_size, unsequenced);
+        packet packet(nullptr, packet::weapon_reload_size, packet_type::weapon_reload);
         auto   stream = packet.stream();
         source.fill_weapon_reload(stream);
-        broadcast(source, packet, channel);
+        broadcast(source, packet);
     }
 
     /**
-     * @brief Broadcast world update
+     * @brief Publish snapshot of the current step
+     *
+     * Visibility is recalculated only when a world update is due, the map must not be modified by
+     * other threads during the call.
      *
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
+     * @param map Map (used for occlusion)
+     * @param tick Step number
+     * @param broadcast If true world update is due
      */
-    void broadcast_world_update(bool unsequenced = true, std::uint8_t channel = 0)
+    void publish_snapshot(const map & map, std::uint64_t tick, bool broadcast)
     {
-        packet packet(nullptr, packet::world_update_size, unsequenced);
-        auto   stream = packet.stream();
-        stream.write_type(packet_type::world_update);
+        auto & snapshot    = m_snapshots.back();
+        snapshot.tick      = tick;
+        snapshot.alive     = 0;
+        snapshot.connected = 0;
+
         for (auto & connection : m_connections)
         {
-            stream.write_vec3(connection.m_position);
-            stream.write_vec3(connection.m_orientation);
+            auto id = connection.id();
+            m_world_update.set_player(
+                id, { connection.m_position, connection.m_orientation, connection.team(), connection.m_alive, connection.is_connected() }
+            );
+            snapshot.health[id]      = connection.m_health;
+            snapshot.tool[id]        = connection.m_tool;
+            snapshot.team[id]        = connection.team();
+            snapshot.position[id]    = connection.m_position;
+            snapshot.orientation[id] = connection.m_orientation;
+            snapshot.alive           |= connection.m_alive ? (1U << id) : 0U;
+            snapshot.connected       |= connection.is_connected() ? (1U << id) : 0U;
         }
-        for (auto & connection : m_connections)
+
+        if (broadcast)
         {
-            if (connection.is_connected())
+            m_world_update.update(map);
+            m_last_broadcast = tick;
+        }
+
+        snapshot.broadcast = m_last_broadcast;
+        m_world_update.store(snapshot);
+        m_snapshots.publish();
+    }
+
+    /**
+     * @brief Send world updates of the latest snapshot (each connection receives only players it can see)
+     *
+     * Packets are taken from the encoder thread if it is running, otherwise they are encoded on the
+     * calling thread.
+     *
+     */
+    void send_world_updates()
+    {
+        auto send = [this](std::uint8_t viewer, ENetPacket * packet) {
+            auto & connection = m_connections[viewer];
+            if (!connection.is_connected() || !connection.send(packet, delivery_of(packet_type::world_update).channel))
             {
-                connection.send(packet, channel);
+                enet_packet_destroy(packet);
             }
+        };
+
+        if (m_encoder.running())
+        {
+            m_encoder.drain(send);
         }
+        else
+        {
+            m_encoder.encode_latest(send);
+        }
+    }
+
+    /**
+     * @brief Get world update builder
+     *
+     * @return World update builder
+     */
+    world_update_builder & get_world_update() noexcept
+    {
+        return m_world_update;
+    }
+
+    /**
+     * @brief Get world update encoder (start it to encode on a separate thread)
+     *
+     * @return World update encoder
+     */
+    world_update_encoder & get_encoder() noexcept
+    {
+        return m_encoder;
     }
 
     /**
      * @brief Broadcast restock
      *
      * @param target Target to be restocked
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_restock(connection & target, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_restock(connection & target)
     {
-        packet packet(nullptr, packet::restock_size, unsequenced);
+        packet packet(nullptr, packet::restock_size, packet_type::restock);
         auto   stream = packet.stream();
         target.fill_restock(stream);
-        broadcast(packet, channel);
+        broadcast(packet);
     }
 
     /**
@@ -357,14 +397,12 @@ class connection_manager
      * @param source Source connection
      * @param type Chat type
      * @param message Message
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_message(connection & source, chat_type type, std::string_view message, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_message(connection & source, chat_type type, std::string_view message)
     {
         data_stream stream { m_cache, packet::chat_message_size };
         auto        size = source.fill_chat_message(stream, type, message);
-        packet      packet(m_cache, size, unsequenced);
+        packet      packet(m_cache, size, packet_type::chat_message);
 
         switch (type)
         {
@@ -375,7 +413,7 @@ class connection_manager
                     {
                         if (!connection.is_disconnected() && !connection.m_deaf)
                         {
-                            connection.send(packet, channel);
+                            connection.send(packet);
                         }
                     }
                 }
@@ -391,7 +429,7 @@ class connection_manager
                         }
                         if (!connection.is_disconnected() && !connection.m_deaf)
                         {
-                            connection.send(packet, channel);
+                            connection.send(packet);
                         }
                     }
                 }
@@ -404,14 +442,12 @@ class connection_manager
      * @brief Send system message
      *
      * @param message Message
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_system_message(std::string_view message, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_system_message(std::string_view message)
     {
         data_stream stream { m_cache, packet::chat_message_size };
         auto        size = fill_system_message(stream, message);
-        broadcast({ m_cache, size, unsequenced }, channel);
+        broadcast({ m_cache, size, packet_type::chat_message });
     }
 
     /**
@@ -419,14 +455,12 @@ class connection_manager
      *
      * @param target Target connection
      * @param message Message
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void system_message(connection & target, std::string_view message, bool unsequenced = false, std::uint8_t channel = 0)
+    void system_message(connection & target, std::string_view message)
     {
         data_stream stream { m_cache, packet::chat_message_size };
         auto        size = fill_system_message(stream, message);
-        target.send_packet(m_cache, size, unsequenced, channel);
+        target.send_packet(m_cache, size);
     }
 
     /**
@@ -437,12 +471,7 @@ class connection_manager
      */
     static std::size_t fill_system_message(data_stream & stream, std::string_view message)
     {
-        auto size = std::min(message.size(), std::size_t(256));
-        stream.write_type(packet_type::chat_message);
-        stream.write_byte(33);
-        stream.write_type(chat_type::system);
-        stream.write_array(message.data(), size);
-        return size + 3;
+        return stream.write_packet(packets::chat_message { 33, chat_type::system, { message } });
     }
 
     /**
@@ -450,30 +479,26 @@ class connection_manager
      *
      * @param source Source connection
      * @param winning If true, then it's winning capture
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_intel_capture(const connection & source, bool winning, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_intel_capture(const connection & source, bool winning)
     {
-        packet packet(nullptr, packet::intel_capture_size, unsequenced);
+        packet packet(nullptr, packet::intel_capture_size, packet_type::intel_capture);
         auto   stream = packet.stream();
         source.fill_intel_capture(stream, winning);
-        broadcast(packet, channel);
+        broadcast(packet);
     }
 
     /**
      * @brief Broadcast intel pickup
      *
      * @param source Source connection
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_intel_pickup(const connection & source, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_intel_pickup(const connection & source)
     {
-        packet packet(nullptr, packet::intel_pickup_size, unsequenced);
+        packet packet(nullptr, packet::intel_pickup_size, packet_type::intel_pickup);
         auto   stream = packet.stream();
         source.fill_intel_pickup(stream);
-        broadcast(packet, channel);
+        broadcast(packet);
     }
 
     /**
@@ -481,15 +506,13 @@ class connection_manager
      *
      * @param source Source connection
      * @param position New intel position
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_intel_drop(const connection & source, const glm::uvec3 & position, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_intel_drop(const connection & source, const glm::uvec3 & position)
     {
-        packet packet(nullptr, packet::intel_drop_size, unsequenced);
+        packet packet(nullptr, packet::intel_drop_size, packet_type::intel_drop);
         auto   stream = packet.stream();
         source.fill_intel_drop(stream, position);
-        broadcast(packet, channel);
+        broadcast(packet);
     }
 
     /**
@@ -498,31 +521,27 @@ class connection_manager
      * @param object_id Object ID
      * @param team Team
      * @param position Position
-     * @param unsequenced If true sets unsequenced flag
-     * @param channel Channel
      */
-    void broadcast_move_object(std::uint8_t object_id, team_type team, const glm::vec3 & position, bool unsequenced = false, std::uint8_t channel = 0)
+    void broadcast_move_object(std::uint8_t object_id, team_type team, const glm::vec3 & position)
     {
-        packet packet(nullptr, packet::move_object_size, unsequenced);
+        packet packet(nullptr, packet::move_object_size, packet_type::move_object);
         auto   stream = packet.stream();
-        stream.write_type(packet_type::move_object);
-        stream.write_byte(object_id);
-        stream.write_type(team);
-        stream.write_vec3(position);
-        broadcast(packet, channel);
+        stream.write_packet(packets::move_object { object_id, team, position });
+        broadcast(packet);
     }
 
     /**
      * @brief Assign connection to peer
      *
-     * @param peer Peer to be assigned
+     * @param network Network worker group owning the peer
+     * @param event Connect event of the peer
      * @param connection Connection
      */
-    void assign_connection(ENetPeer * peer, connection & connection)
+    void assign_connection(cxxserver::NetworkWorkerGroup & network, const cxxserver::NetworkEvent & event, connection & connection)
     {
-        connection.set_peer(peer);
-        peer->data = &connection;
+        connection.set_peer(network, event);
         connection.set_state(state_type::connecting);
+        m_world_update.reset_viewer(connection.id());
         m_num_players++;
     }
 
@@ -535,19 +554,26 @@ class connection_manager
     {
         connection.reset_values();
         connection.set_state(state_type::disconnected);
-        connection.set_peer(nullptr);
+        connection.release_peer();
         m_num_players--;
     }
 
     /**
-     * @brief Extract connection from peer
+     * @brief Find connection of peer
      *
-     * @param peer Peer
-     * @return Reference to connection
+     * @param peer Peer handle
+     * @return Connection or nullptr if the peer has none
      */
-    static connection & peer_to_connection(ENetPeer * peer)
+    connection * find_connection(const cxxserver::PeerHandle & peer) noexcept
     {
-        return *reinterpret_cast<connection *>(peer->data);
+        for (auto & connection : m_connections)
+        {
+            if (connection.is_peer(peer))
+            {
+                return &connection;
+            }
+        }
+        return nullptr;
     }
 
   protected:
@@ -561,7 +587,7 @@ class connection_manager
     {
         for (auto & connection : m_connections)
         {
-            if (connection.is_disconnected())
+            if (connection.is_disconnected() && !connection.has_peer())
             {
                 return connection;
             }
@@ -569,7 +595,11 @@ class connection_manager
         throw std::runtime_error("failed to get next free connection");
     }
 
-    std::uint8_t m_cache[769]; //!< Packet stream buffer
+    std::uint8_t                  m_cache[769];                              //!< Packet stream buffer
+    world_update_builder          m_world_update;                            //!< Per-client world update builder
+    triple_buffer<world_snapshot> m_snapshots;                               //!< Published snapshots
+    world_update_encoder          m_encoder { m_snapshots, m_world_update }; //!< World update encoder
+    std::uint64_t                 m_last_broadcast { 0 };                    //!< Step of the latest world update
 
     std::uint8_t            m_max_players;       //!< Maximal number of players
     std::uint8_t            m_num_players { 0 }; //!< Current number of players
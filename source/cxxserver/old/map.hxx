@@ -8,8 +8,10 @@
 // #include "boostio.hxx"
 
 #include <array>
-#include <bitset>
+#include <bit>
+#include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
@@ -168,7 +170,7 @@ class map
     [[nodiscard]] bool is_block(std::uint32_t offset) const
     {
         assert(offset < size_xyz);
-        return m_blocks.test(offset);
+        return ((m_columns[offset >> 6U] >> (offset & 0x3FU)) & 1U) != 0;
     }
 
     /**
@@ -180,7 +182,15 @@ class map
     void set_block(std::uint32_t offset, bool value)
     {
         assert(offset < size_xyz);
-        m_blocks.set(offset, value);
+        auto bit = std::uint64_t { 1 } << (offset & 0x3FU);
+        if (value)
+        {
+            m_columns[offset >> 6U] |= bit;
+        }
+        else
+        {
+            m_columns[offset >> 6U] &= ~bit;
+        }
     }
 
     /**
@@ -254,6 +264,38 @@ class map
         return is_block(static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y), static_cast<std::uint32_t>(z));
     }
 
+    /**
+     * @brief Get solid blocks of a column
+     *
+     * @param x The x-coordinate of the column
+     * @param y The y-coordinate of the column
+     * @return Column mask (bit z is set if the block is solid)
+     */
+    [[nodiscard]] std::uint64_t column(std::uint32_t x, std::uint32_t y) const
+    {
+        assert(x < size_x && y < size_y);
+        return m_columns[(y << 9U) + x];
+    }
+
+    /**
+     * @brief Get column mask with is_clip_box semantics
+     *
+     * Out of bounds columns are solid, z = 63 is the same as z = 62.
+     *
+     * @param x The x-coordinate of the column
+     * @param y The y-coordinate of the column
+     * @return Column mask (bit z is set if is_clip_box(x, y, z))
+     */
+    [[nodiscard]] std::uint64_t clip_column(int x, int y) const
+    {
+        if (x < 0 || x >= 512 || y < 0 || y >= 512)
+        {
+            return ~std::uint64_t { 0 };
+        }
+        auto mask = column(static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y));
+        return (mask & ~(std::uint64_t { 1 } << 63U)) | ((mask >> 62U & 1U) << 63U);
+    }
+
     /**
      * @brief Same as is_block, but water is empty and out of bounds returns false
      *
@@ -483,12 +525,7 @@ class map
      */
     [[nodiscard]] std::uint32_t get_height(std::uint32_t x, std::uint32_t y) const
     {
-        auto          offset = get_offset(x, y, 0);
-        std::uint32_t z;
-        for (z = 0; z < 64 && !m_blocks.test(offset + z); ++z)
-        {
-        }
-        return z;
+        return static_cast<std::uint32_t>(std::countr_zero(column(x, y)));
     }
 
     /**
@@ -522,7 +559,7 @@ class map
             // air
             for (; z < top_start; ++z)
             {
-                m_blocks.set(offset + z, false);
+                set_block(offset + z, false);
             }
 
             // number of top blocks
@@ -571,7 +608,7 @@ class map
     {
         std::uint32_t offset = 0;
 
-        m_blocks.set();
+        m_columns.fill(~std::uint64_t { 0 });
         m_colors.fill(default_color);
 
         while (offset < size_xyz)
@@ -742,7 +779,7 @@ class map
 
   private:
 
-    std::bitset<size_xyz>               m_blocks;           //!< Bitset of blocks (solid/not solid)
+    std::array<std::uint64_t, size_xy>  m_columns {};       //!< Block bits of every column (bit z is solid)
     std::array<std::uint32_t, size_xyz> m_colors;           //!< Array of colors
     bool                                m_changed { true }; //!< Has map changed since last compression?
 };
@@ -0,0 +1,162 @@
+/**
+ * @file pacer.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <enet/enet.h>
+
+namespace spadesx {
+
+/**
+ * @brief State of the link to a peer (as seen by ENet)
+ *
+ */
+struct link_state
+{
+    std::uint32_t round_trip_time { ENET_PEER_DEFAULT_ROUND_TRIP_TIME }; //!< Mean round trip time in milliseconds
+    std::uint32_t fragment_length { 0 };                                //!< Largest packet sent without fragmentation
+    std::uint32_t window { 0 };                                         //!< Reliable data ENet puts in transit (throttled)
+    std::uint32_t in_transit { 0 };                                     //!< Reliable data in transit (all channels)
+    std::uint32_t backlog { 0 };                                        //!< Data of the channel not acknowledged yet
+};
+
+/**
+ * @brief Map download pacing
+ *
+ * Keeps just enough map data queued to fill the link: the delivery rate is measured from the
+ * acknowledged data and the pacer allows twice the bandwidth-delay product to be queued or in
+ * transit. Data ENet could not put in transit would only wait in the peer queue, so the target
+ * never exceeds the (throttled) ENet window, a quarter of which is left to other channels.
+ *
+ * Chunks are made of whole fragments. A small window sends single datagram chunks, a large one
+ * sends up to max_chunk_size at once.
+ *
+ */
+class map_pacer
+{
+  public:
+
+    using clock_type = std::chrono::steady_clock;
+
+    static constexpr const std::size_t   max_chunk_size  = 8192; //!< Max size of map chunk (without packet type)
+    static constexpr const std::uint32_t initial_chunks  = 4;    //!< Chunks in flight before the rate is known
+    static constexpr const std::uint32_t min_chunks      = 2;    //!< Chunks in flight at least
+    static constexpr const std::uint32_t chunks_per_size = 4;    //!< Chunks in flight needed to grow the chunk size
+    static constexpr const double        gain            = 2.0;  //!< Target in flight per bandwidth-delay product
+
+    /**
+     * @brief Start new download
+     *
+     * @param now Current time
+     */
+    void start(clock_type::time_point now) noexcept
+    {
+        m_sent        = 0;
+        m_acked       = 0;
+        m_rate        = 0.0;
+        m_sample_time = now;
+    }
+
+    /**
+     * @brief Update link state (once per update, before sending chunks)
+     *
+     * @param link State of the link
+     * @param now Current time
+     */
+    void update(const link_state & link, clock_type::time_point now) noexcept
+    {
+        m_link    = link;
+        m_backlog = link.backlog;
+
+        auto acked   = m_sent - std::min<std::uint64_t>(m_sent, link.backlog);
+        auto elapsed = std::chrono::duration<double>(now - m_sample_time).count();
+        // at least half of the round trip, so a single acknowledgement does not make the sample
+        if (elapsed * 2000.0 >= std::max<std::uint32_t>(link.round_trip_time, 1) && acked > m_acked)
+        {
+            auto sample = static_cast<double>(acked - m_acked) / elapsed;
+            m_rate        = sample > m_rate ? sample : (3.0 * m_rate + sample) / 4.0;
+            m_acked       = acked;
+            m_sample_time = now;
+        }
+    }
+
+    /**
+     * @brief Get size of the next chunk
+     *
+     * @param remaining Map data not sent yet
+     * @return Chunk size (0 if the target is reached)
+     */
+    [[nodiscard]] std::size_t next_chunk(std::size_t remaining) const noexcept
+    {
+        auto size = chunk_size();
+        return m_backlog + size + 1 <= target() ? std::min(remaining, size) : 0;
+    }
+
+    /**
+     * @brief Account sent chunk
+     *
+     * @param size Chunk size
+     */
+    void on_sent(std::size_t size) noexcept
+    {
+        m_sent += size + 1;
+        m_backlog += static_cast<std::uint32_t>(size + 1);
+    }
+
+    /**
+     * @brief Get measured delivery rate
+     *
+     * @return Bytes per second (0 if not known yet)
+     */
+    [[nodiscard]] double rate() const noexcept
+    {
+        return m_rate;
+    }
+
+  private:
+
+    /**
+     * @brief Get data allowed to be queued or in transit
+     *
+     * @return Target in bytes
+     */
+    [[nodiscard]] std::uint32_t target() const noexcept
+    {
+        auto fragment = std::max<std::uint32_t>(m_link.fragment_length, 1);
+        auto window   = std::max(m_link.window - m_link.window / 4, min_chunks * fragment);
+
+        if (m_rate == 0.0)
+        {
+            return std::min(window, initial_chunks * fragment);
+        }
+        auto bdp = m_rate * gain * static_cast<double>(m_link.round_trip_time) / 1000.0;
+        return std::clamp(static_cast<std::uint32_t>(std::min(bdp, double(window))), min_chunks * fragment, window);
+    }
+
+    /**
+     * @brief Get chunk size (whole fragments including the packet type)
+     *
+     * @return Chunk size without packet type
+     */
+    [[nodiscard]] std::size_t chunk_size() const noexcept
+    {
+        std::size_t fragment  = std::max<std::uint32_t>(m_link.fragment_length, 2);
+        std::size_t fragments = std::clamp<std::size_t>(target() / (chunks_per_size * fragment), 1, (max_chunk_size + 1) / fragment);
+        return fragments * fragment - 1;
+    }
+
+    link_state             m_link;              //!< Last link state
+    std::uint32_t          m_backlog { 0 };     //!< Map data queued or in transit
+    std::uint64_t          m_sent { 0 };        //!< Map data sent (including packet types)
+    std::uint64_t          m_acked { 0 };       //!< Map data acknowledged at the last sample
+    double                 m_rate { 0.0 };      //!< Delivery rate in bytes per second
+    clock_type::time_point m_sample_time { };   //!< Time of the last sample
+};
+
+} // namespace spadesx
@@ -6,59 +6,64 @@
 #pragma once
 
 #include "datastream.hxx"
+#include "delivery.hxx"
 
 #include <enet/enet.h>
 
 namespace spadesx {
 
 class peer;
+class world_update_encoder;
 
 /**
- * @brief Packet sizes
+ * @brief Packet sizes (from the packet schema)
  *
  */
 class packet
 {
     friend peer;
+    friend world_update_encoder;
 
   public:
 
-    static constexpr const std::size_t world_update_size    = 769; //!< World update packet size
-    static constexpr const std::size_t input_data_size      = 3;   //!< Input data packet size
-    static constexpr const std::size_t weapon_input_size    = 3;   //!< Weapon input packet size
-    static constexpr const std::size_t set_hp_size          = 15;  //!< Set hp packet size
-    static constexpr const std::size_t grenade_packet_size  = 30;  //!< Grenade packet size
-    static constexpr const std::size_t set_tool_size        = 3;   //!< Set tool packet size
-    static constexpr const std::size_t set_color_size       = 5;   //!< Set color packet size
-    static constexpr const std::size_t existing_player_size = 28;  //!< Existing player packet max size
-    static constexpr const std::size_t short_player_size    = 4;   //!< Short player packet size
-    static constexpr const std::size_t move_object_size     = 15;  //!< Move object packet size
-    static constexpr const std::size_t create_player_size   = 32;  //!< Create player packet size
-    static constexpr const std::size_t block_action_size    = 15;  //!< Block action packet size
-    static constexpr const std::size_t block_line_size      = 26;  //!< Block line packet size
-    static constexpr const std::size_t state_data_size      = 90;  //!< State data packet size
-    static constexpr const std::size_t kill_action_size     = 5;   //!< Kill action packet size
-    static constexpr const std::size_t chat_message_size    = 258; //!< Chat message packet max size
-    static constexpr const std::size_t map_start_size       = 5;   //!< Map start packet size
-    static constexpr const std::size_t player_left_size     = 2;   //!< Player left packet size
-    static constexpr const std::size_t territory_capture    = 5;   //!< Territroy capture packet size
-    static constexpr const std::size_t progress_bar         = 8;   //!< Progress bar packet size
-    static constexpr const std::size_t intel_capture_size   = 3;   //!< Intel capture packet size
-    static constexpr const std::size_t intel_pickup_size    = 2;   //!< Intel pickup packet size
-    static constexpr const std::size_t intel_drop_size      = 14;  //!< Intel drop packet size
-    static constexpr const std::size_t restock_size         = 2;   //!< Restock packet size
-    static constexpr const std::size_t fog_color_size       = 5;   //!< Fog color packet size
-    static constexpr const std::size_t weapon_reload_size   = 4;   //!< Weapon reload packet size
+    static constexpr const std::size_t position_data_size     = packets::position_data::layout::max_size;     //!< Position data packet size
+    static constexpr const std::size_t world_update_size      = packets::world_update::layout::max_size;      //!< World update packet size
+    static constexpr const std::size_t input_data_size        = packets::input_data::layout::max_size;        //!< Input data packet size
+    static constexpr const std::size_t weapon_input_size      = packets::weapon_input::layout::max_size;      //!< Weapon input packet size
+    static constexpr const std::size_t set_hp_size            = packets::set_hp::layout::max_size;            //!< Set hp packet size
+    static constexpr const std::size_t grenade_packet_size    = packets::grenade_packet::layout::max_size;    //!< Grenade packet size
+    static constexpr const std::size_t set_tool_size          = packets::set_tool::layout::max_size;          //!< Set tool packet size
+    static constexpr const std::size_t set_color_size         = packets::set_color::layout::max_size;         //!< Set color packet size
+    static constexpr const std::size_t existing_player_size   = packets::existing_player::layout::max_size;   //!< Existing player packet max size
+    static constexpr const std::size_t short_player_size      = packets::short_player_data::layout::max_size; //!< Short player packet size
+    static constexpr const std::size_t move_object_size       = packets::move_object::layout::max_size;       //!< Move object packet size
+    static constexpr const std::size_t create_player_size     = packets::create_player::layout::max_size;     //!< Create player packet max size
+    static constexpr const std::size_t block_action_size      = packets::block_action::layout::max_size;      //!< Block action packet size
+    static constexpr const std::size_t block_line_size        = packets::block_line::layout::max_size;        //!< Block line packet size
+    static constexpr const std::size_t state_data_size        = packets::state_data::layout::max_size;        //!< State data packet size
+    static constexpr const std::size_t kill_action_size       = packets::kill_action::layout::max_size;       //!< Kill action packet size
+    static constexpr const std::size_t chat_message_size      = packets::chat_message::layout::max_size;      //!< Chat message packet max size
+    static constexpr const std::size_t map_start_size         = packets::map_start::layout::max_size;         //!< Map start packet size
+    static constexpr const std::size_t player_left_size       = packets::player_left::layout::max_size;       //!< Player left packet size
+    static constexpr const std::size_t territory_capture_size = packets::territory_capture::layout::max_size; //!< Territory capture packet size
+    static constexpr const std::size_t progress_bar_size      = packets::progress_bar::layout::max_size;      //!< Progress bar packet size
+    static constexpr const std::size_t intel_capture_size     = packets::intel_capture::layout::max_size;     //!< Intel capture packet size
+    static constexpr const std::size_t intel_pickup_size      = packets::intel_pickup::layout::max_size;      //!< Intel pickup packet size
+    static constexpr const std::size_t intel_drop_size        = packets::intel_drop::layout::max_size;        //!< Intel drop packet size
+    static constexpr const std::size_t restock_size           = packets::restock::layout::max_size;           //!< Restock packet size
+    static constexpr const std::size_t fog_color_size         = packets::fog_color::layout::max_size;         //!< Fog color packet size
+    static constexpr const std::size_t weapon_reload_size     = packets::weapon_reload::layout::max_size;     //!< Weapon reload packet size
 
     /**
-     * @brief Construct a new packet object
+     * @brief Construct a new packet object (delivered according to the policy of its type)
      *
      * @param source Source memory
      * @param capacity Packet capacity
-     * @param unsequenced Unsequenced flag
+     * @param type Packet type
      */
-    packet(const void * source, std::size_t capacity, bool unsequenced = false)
-        : m_packet { enet_packet_create(source, capacity, unsequenced_to_flag(unsequenced)) }
+    packet(const void * source, std::size_t capacity, packet_type type)
+        : m_packet { enet_packet_create(source, capacity, delivery_of(type).flags()) }
+        , m_channel { delivery_of(type).channel }
     {
     }
 
@@ -72,20 +77,20 @@ class packet
         return { m_packet };
     }
 
-  protected:
-
     /**
-     * @brief Convert bool to ENet packet flag
+     * @brief Get channel
      *
-     * @param unsequenced Unsequenced flag
-     * @return ENet packet flag
+     * @return Channel of the packet type
      */
-    static std::uint32_t unsequenced_to_flag(bool unsequenced)
+    [[nodiscard]] channel_type channel() const noexcept
     {
-        return unsequenced ? ENET_PACKET_FLAG_RELIABLE : ENET_PACKET_FLAG_UNSEQUENCED;
+        return m_channel;
     }
 
-    ENetPacket * m_packet; //!< ENet packet
+  protected:
+
+    ENetPacket * m_packet;  //!< ENet packet
+    channel_type m_channel; //!< Channel
 };
 
 } // namespace spadesx
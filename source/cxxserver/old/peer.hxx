@@ -5,13 +5,21 @@
 
 #pragma once
 
+#include "cxxserver/NetworkWorker.hpp"
 #include "datastream.hxx"
 #include "packet.hxx"
+#include "pacer.hxx"
+
+#include <array>
+#include <optional>
 
 namespace spadesx {
 
 /**
- * @brief ENetPeer wrapper
+ * @brief Peer owned by a network worker
+ *
+ * Packets are queued in the worker group and handed to ENet when the tick ends, the link state is
+ * the one last published by the worker plus the data queued since then.
  *
  */
 class peer
@@ -30,30 +38,66 @@ class peer
      */
     ~peer()
     {
-        if (m_peer != nullptr)
+        if (is_valid_peer())
         {
-            enet_peer_disconnect(m_peer, 0);
+            m_network->disconnect(m_handle, cxxserver::DisconnectReason::UNKNOWN);
         }
     }
 
     /**
-     * @brief Check whether peer is valid (not nullptr)
+     * @brief Check whether peer is valid (assigned and not disconnecting)
      *
      * @return true If peer is valid
      */
     [[nodiscard]] bool is_valid_peer() const noexcept
     {
-        return m_peer != nullptr;
+        return m_network != nullptr && !m_disconnecting;
+    }
+
+    /**
+     * @brief Check whether a peer is assigned (until its disconnect event is handled)
+     *
+     * @return true If a peer is assigned
+     */
+    [[nodiscard]] bool has_peer() const noexcept
+    {
+        return m_network != nullptr;
+    }
+
+    /**
+     * @brief Check whether peer is the source of an event
+     *
+     * @param handle Peer handle
+     * @return true If same connection
+     */
+    [[nodiscard]] bool is_peer(const cxxserver::PeerHandle & handle) const noexcept
+    {
+        return has_peer() && m_handle.worker == handle.worker && m_handle.peer == handle.peer && m_handle.connectID == handle.connectID;
     }
 
     /**
-     * @brief Assign ENetPeer pointer
+     * @brief Assign peer of a connect event
      *
-     * @param peer ENetPeer pointer
+     * @param network Network worker group owning the peer
+     * @param event Connect event
      */
-    void set_peer(ENetPeer * peer) noexcept
+    void set_peer(cxxserver::NetworkWorkerGroup & network, const cxxserver::NetworkEvent & event) noexcept
     {
-        m_peer = peer;
+        m_network       = &network;
+        m_handle        = event.source;
+        m_address       = event.address;
+        m_channels      = event.channel;
+        m_queued        = {};
+        m_disconnecting = false;
+    }
+
+    /**
+     * @brief Release peer (the connection is gone)
+     *
+     */
+    void release_peer() noexcept
+    {
+        m_network = nullptr;
     }
 
     /**
@@ -63,24 +107,67 @@ class peer
      */
     std::uint32_t get_address()
     {
-        return m_peer->address.host;
+        return m_address.host;
+    }
+
+    /**
+     * @brief Get mean round trip time
+     *
+     * @return Round trip time in milliseconds (0 if not connected)
+     */
+    [[nodiscard]] std::uint32_t round_trip_time() const
+    {
+        auto link = published_link();
+        return link ? link->roundTripTime : 0;
     }
 
     /**
-     * @brief Reset peer (forcefully disconnect)
+     * @brief Get state of the link
      *
+     * @param channel Channel whose backlog is reported
+     * @return Link state
      */
-    void reset() noexcept
+    [[nodiscard]] link_state link(channel_type channel) const
     {
+        link_state state;
         if (is_valid_peer())
         {
-            enet_peer_reset(m_peer);
-            m_peer = nullptr;
+            auto id   = channel_id(channel);
+            auto link = published_link();
+            if (link)
+            {
+                state.round_trip_time = link->roundTripTime;
+                state.fragment_length = link->fragmentLength;
+                state.window          = link->window;
+                state.in_transit      = link->inTransit;
+            }
+            state.backlog = (link ? link->channels[id].backlog : 0) + not_sent(link, id);
+        }
+        return state;
+    }
+
+    /**
+     * @brief Check whether all reliable packets of channel were acknowledged
+     *
+     * Channels are sequenced independently, a packet which has to follow the packets of another
+     * channel may be sent only when that channel is idle.
+     *
+     * @param channel Channel
+     * @return true If nothing of the channel is queued or in transit
+     */
+    [[nodiscard]] bool is_channel_idle(channel_type channel) const
+    {
+        if (!is_valid_peer() || channel_id(channel) == 0)
+        {
+            return true; // everything is on the first channel
         }
+        auto id   = channel_id(channel);
+        auto link = published_link();
+        return link && link->channels[id].commands == 0 && not_sent(link, id) == 0;
     }
 
     /**
-     * @brief Disconnect peer
+     * @brief Disconnect peer (stays assigned until its disconnect event)
      *
      * @param reason Reason
      */
@@ -88,25 +175,30 @@ class peer
     {
         if (is_valid_peer())
         {
-            enet_peer_disconnect(m_peer, reason);
-            m_peer = nullptr;
+            m_network->disconnect(m_handle, static_cast<cxxserver::DisconnectReason>(reason));
+            m_disconnecting = true;
         }
     }
 
     /**
-     * @brief Send packet
+     * @brief Send packet (queued until the end of the tick)
+     *
+     * Clients which did not open all channels get everything on the first one.
      *
      * @param packet Packet to be sent
      * @param channel Channel to be used
      * @return true Success
      */
-    bool send(ENetPacket * packet, std::uint8_t channel = 0)
+    bool send(ENetPacket * packet, channel_type channel)
     {
         if (is_valid_peer())
         {
             if (packet != nullptr)
             {
-                return enet_peer_send(m_peer, channel, packet) == 0;
+                auto id = channel_id(channel);
+                m_queued[id] += static_cast<std::uint32_t>(packet->dataLength);
+                m_network->send(m_handle, id, packet);
+                return true;
             }
             return false;
         }
@@ -114,20 +206,58 @@ class peer
     }
 
     /**
-     * @brief Send packet
+     * @brief Send packet (on the channel of its type)
      *
      * @param packet Packet to be sent
-     * @param channel Channel to be used
      * @return true Success
      */
-    bool send(packet packet, std::uint8_t channel = 0)
+    bool send(packet packet)
     {
-        return send(packet.m_packet, channel);
+        return send(packet.m_packet, packet.m_channel);
     }
 
   private:
 
-    ENetPeer * m_peer { nullptr }; //!< ENetPeer pointer
+    /**
+     * @brief Get ENet channel ID (clients which did not open the channel use the first one)
+     *
+     * @param channel Channel
+     * @return Channel ID
+     */
+    [[nodiscard]] std::uint8_t channel_id(channel_type channel) const noexcept
+    {
+        auto id = static_cast<std::uint8_t>(channel);
+        return id < m_channels && id < cxxserver::PeerLink::MAX_CHANNELS ? id : 0;
+    }
+
+    /**
+     * @brief Get link state last published by the worker
+     *
+     * @return Link state or nothing
+     */
+    [[nodiscard]] std::optional<cxxserver::PeerLink> published_link() const
+    {
+        return is_valid_peer() ? m_network->link(m_handle) : std::nullopt;
+    }
+
+    /**
+     * @brief Get data queued for channel which the worker did not hand to ENet yet
+     *
+     * @param link Published link state
+     * @param id Channel ID
+     * @return Data size
+     */
+    [[nodiscard]] std::uint32_t not_sent(const std::optional<cxxserver::PeerLink> & link, std::uint8_t id) const noexcept
+    {
+        return m_queued[id] - (link ? link->channels[id].sent : 0);
+    }
+
+    cxxserver::NetworkWorkerGroup *                              m_network { nullptr };     //!< Network worker group owning the peer
+    cxxserver::PeerHandle                                        m_handle {};               //!< Peer handle
+    ENetAddress                                                  m_address {};              //!< Remote address
+    std::uint8_t                                                 m_channels { 0 };          //!< Channels opened by the client
+    std::array<std::uint32_t, cxxserver::PeerLink::MAX_CHANNELS> m_queued {};               //!< Data queued per channel (cumulative, wraps around)
+    bool                                                         m_disconnecting { false }; //!< Disconnect was requested
 };
 
 } // namespace spadesx
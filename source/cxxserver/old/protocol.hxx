@@ -5,13 +5,59 @@
 
 #pragma once
 
+#include "cxxserver/JobSystem.hpp"
+#include "cxxserver/PacketDispatcher.hpp"
+#include "cxxserver/TickGraph.hpp"
+#include "data/base.hxx"
 #include "handler.hxx"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <random>
 
 namespace spadesx {
 
+/**
+ * @brief Resources declared by tick phases
+ *
+ */
+struct tick_resource
+{
+    static constexpr const cxxserver::ResourceSet map      = 1U << 0U; //!< Map blocks
+    static constexpr const cxxserver::ResourceSet players  = 1U << 1U; //!< Player state (connections)
+    static constexpr const cxxserver::ResourceSet grenades = 1U << 2U; //!< Active grenades
+    static constexpr const cxxserver::ResourceSet network  = 1U << 3U; //!< Peers (sending packets)
+    static constexpr const cxxserver::ResourceSet snapshot = 1U << 4U; //!< Published snapshots
+    static constexpr const cxxserver::ResourceSet spatial  = 1U << 5U; //!< Spatial hash and triggers
+    static constexpr const cxxserver::ResourceSet history  = 1U << 6U; //!< Position history
+};
+
+/**
+ * @brief Built-in verify step of received packets
+ *
+ * Accepts the packets default_receive handles in a connection state (existing player while
+ * connecting, every client packet once joined) and checks their length against the packet schema,
+ * so the handlers decode the fields without any further bounds checks.
+ *
+ */
+struct packet_verifier
+{
+    static constexpr bool accepts(cxxserver::ConnectionState state, std::uint8_t type) noexcept
+    {
+        bool known = client_lengths[type].min <= client_lengths[type].max;
+        return known && (state == cxxserver::ConnectionState::JOINED || type == static_cast<std::uint8_t>(packet_type::existing_player));
+    }
+
+    cxxserver::HandlerResult handle(const cxxserver::Packet & packet) const noexcept
+    {
+        auto data = packet.data();
+        return is_valid_length(client_lengths, data.data(), data.size()) ? cxxserver::HandlerResult::VALID : cxxserver::HandlerResult::INVALID_LENGTH;
+    }
+};
+
+using packet_dispatcher = cxxserver::PacketDispatcher<packet_verifier>; //!< Verify pipeline of received packets
+
 /**
  * @brief Protocol base
  *
@@ -39,6 +85,27 @@ class protocol : public server_handler, public command_manager
         , m_generator { std::random_device()() }
         , m_distribution { 0.F, 1.F }
     {
+        build_tick_graph();
+    }
+
+    /**
+     * @brief Set number of worker threads used by the tick graph
+     *
+     * @param workers Number of workers (0 = run everything on the tick thread)
+     */
+    void set_job_workers(std::size_t workers)
+    {
+        m_jobs = std::make_unique<cxxserver::JobSystem>(workers);
+    }
+
+    /**
+     * @brief Get tick graph
+     *
+     * @return Tick graph
+     */
+    [[nodiscard]] const cxxserver::TickGraph & get_tick_graph() const noexcept
+    {
+        return m_tick_graph;
     }
 
     ~protocol() override = default;
@@ -48,11 +115,11 @@ class protocol : public server_handler, public command_manager
      *
      * @param source Source connection
      * @param base Base
-     * @return true If restock is possible (distance and time, not team)
+     * @return true If restock is possible (inside base trigger and time, not team)
      */
     bool check_restock(connection & source, base_data & base) const
     {
-        return source.m_restock_time == 0 && base.distance(source) <= m_base_trigger_distance;
+        return source.m_restock_time == 0 && m_spatial.is_inside(source.id(), base.id());
     }
 
     /**
@@ -67,6 +134,7 @@ class protocol : public server_handler, public command_manager
         source.m_restock_time = restock_time;
         source.m_health       = 100;
         source.m_grenades     = 3;
+        start_countdown(m_restock_timers[source.id()], source.m_restock_time);
         broadcast_restock(source);
     }
 
@@ -74,17 +142,18 @@ class protocol : public server_handler, public command_manager
      * @brief Get spawn location
      *
      */
-    virtual void get_spawn_location(team_type team, entity & entity) { }
+    virtual void get_spawn_location(team_type /*team*/, entity & /*entity*/) { }
 
     /**
      * @brief On connect event
      *
+     * @param event Connect event
      */
-    virtual bool on_connect(ENetPeer * peer)
+    virtual bool on_connect(const cxxserver::NetworkEvent & event)
     {
         // check banned?
         connection & connection = next_free_connection();
-        assign_connection(peer, connection);
+        assign_connection(*m_network, event, connection);
         return true;
     }
 
@@ -93,18 +162,19 @@ class protocol : public server_handler, public command_manager
      *
      * @param connection Connection
      */
-    virtual void on_disconnect(connection & connection) { }
+    virtual void on_disconnect(connection & /*connection*/) { }
 
     /**
      * @brief Handle packets
      *
+     * Only called for packets the dispatcher verified (see get_dispatcher).
+     *
      * @param connection Connection
      * @param stream Packet stream
      */
     virtual void on_receive(connection & connection, data_stream & stream)
     {
-        auto type = stream.read_type<packet_type>();
-        default_receive(connection, type, stream);
+        default_receive(connection, stream.peek_type<packet_type>(), stream);
     }
 
     void on_message(connection & source, chat_type type, std::string_view message) override
@@ -136,14 +206,14 @@ class protocol : public server_handler, public command_manager
      *
      * @param connection Connection
      */
-    virtual void on_update(connection & connection) { }
+    virtual void on_update(connection & /*connection*/) { }
 
     /**
      * @brief Send state
      *
      * @param connection Connection
      */
-    virtual bool on_send_state(connection & connection)
+    virtual bool on_send_state(connection & /*connection*/)
     {
         return false;
     }
@@ -212,26 +282,35 @@ class protocol : public server_handler, public command_manager
                     m_map_used      = true;
                     m_map_ownership = connection.id();
                     m_map_position  = 0;
+                    connection.pacer().start(std::chrono::steady_clock::now());
                     std::cout << "[  LOG  ]: map start packet sent to " << static_cast<std::uint32_t>(connection.id()) << std::endl;
                 }
             }
             else if (m_map_used && m_map_ownership == connection.id())
             {
-                auto diff = m_compressed_map.size() - m_map_position;
-                auto size = std::min(diff, std::size_t(8192));
+                auto & pacer = connection.pacer();
+                pacer.update(connection.link(channel_type::map), std::chrono::steady_clock::now());
 
-                if (size == 0)
+                if (m_map_position == m_compressed_map.size())
                 {
-                    on_map_loading_done(connection);
-                    m_map_used = false;
-                    std::cout << "[  LOG  ]: map loading done, id: " << static_cast<std::uint32_t>(connection.id()) << std::endl;
+                    // the game channel must not overtake the last chunks
+                    if (connection.is_channel_idle(channel_type::map))
+                    {
+                        on_map_loading_done(connection);
+                        m_map_used = false;
+                        std::cout << "[  LOG  ]: map loading done, id: " << static_cast<std::uint32_t>(connection.id()) << std::endl;
+                    }
                 }
-                else if (connection.send_map_chunk(m_compressed_map.data() + m_map_position, size))
+
+                while (m_map_position < m_compressed_map.size())
                 {
+                    auto size = pacer.next_chunk(m_compressed_map.size() - m_map_position);
+                    if (size == 0 || !connection.send_map_chunk(m_compressed_map.data() + m_map_position, static_cast<std::uint32_t>(size)))
+                    {
+                        break;
+                    }
                     m_map_position += size;
-                    // std::cout << "[  LOG  ]: map chunk sent to " << static_cast<std::uint32_t>(connection.id())
-                    //           << "(size " << size << "): " << m_map_position << " of " << m_compressed_map.size()
-                    //           << std::endl;
+                    pacer.on_sent(size);
                 }
             }
         }
@@ -250,6 +329,7 @@ class protocol : public server_handler, public command_manager
         for (auto & connection : m_connections)
         {
             connection.reset_values();
+            cancel_timers(connection);
             // connection.set_state(state_type::disconnected); // or connecting on map change?
         }
 
@@ -257,10 +337,26 @@ class protocol : public server_handler, public command_manager
     }
 
     /**
-     * @brief Update
+     * @brief Update (wall clock driven, runs due fixed steps with bounded catch-up)
      *
      */
     void update()
+    {
+        auto now       = std::chrono::steady_clock::now();
+        m_accumulator  += std::chrono::duration<double>(now - m_update_timer).count();
+        m_update_timer = now;
+
+        auto steps     = static_cast<std::uint32_t>(m_accumulator / m_local_update_delta);
+        m_accumulator -= steps * m_local_update_delta;
+        update(steps);
+    }
+
+    /**
+     * @brief Update (tick scheduler driven)
+     *
+     * @param steps Number of fixed steps to run (0 = only update connections)
+     */
+    void update(std::uint32_t steps)
     {
         for (auto & connection : m_connections)
         {
@@ -270,59 +366,56 @@ class protocol : public server_handler, public command_manager
             }
         }
 
-        auto now = std::chrono::steady_clock::now();
-        if (std::chrono::duration<double>(now - m_one_second_timer).count() >= 1)
+        // bounded catch-up, simulation time is dropped after long stalls
+        for (std::uint32_t i = 0; i < std::min(steps, m_max_catch_up); ++i)
         {
-            m_one_second_timer = now;
-            for (auto & connection : m_connections)
-            {
-                if (connection.m_respawn_time != 0)
-                {
-                    connection.m_respawn_time--;
-                }
-                if (connection.m_restock_time != 0)
-                {
-                    connection.m_restock_time--;
-                }
-            }
+            step();
         }
+    }
 
-        if (double delta = std::chrono::duration<double>(now - m_local_update_timer).count(); delta >= m_local_update_delta)
-        {
-            m_local_update_timer = now;
-            world_update(float(delta));
-            grenades_update(float(delta));
-        }
+    /**
+     * @brief Run single fixed step (timers, physics and world update broadcast)
+     *
+     */
+    void step()
+    {
+        ++m_tick;
+        sample_latency();
+        m_tick_graph.run(*m_jobs);
+    }
 
-        if (double delta = std::chrono::duration<double>(now - m_world_update_timer).count(); delta >= m_world_update_delta)
-        {
-            m_world_update_timer = now;
-            broadcast_world_update();
-        }
+    /**
+     * @brief Set network worker group the peers belong to (before the first event)
+     *
+     * @param network Network worker group
+     */
+    void set_network(cxxserver::NetworkWorkerGroup & network) noexcept
+    {
+        m_network = &network;
     }
 
     /**
      * @brief Try connecting peer
      *
-     * @param peer Peer to be connected
+     * @param event Connect event
      */
-    void try_connect(ENetPeer * peer)
+    void try_connect(const cxxserver::NetworkEvent & event)
     {
-        if (peer->eventData != static_cast<std::uint32_t>(version_type::v75))
+        if (event.data != static_cast<std::uint32_t>(version_type::v75))
         {
-            enet_peer_disconnect(peer, static_cast<std::uint32_t>(reason_type::wrong_protocol_version));
+            m_network->disconnect(event.source, cxxserver::DisconnectReason::WRONG_PROTOCOL_VERSION);
             return;
         }
 
         if (!available())
         {
-            enet_peer_disconnect(peer, static_cast<std::uint32_t>(reason_type::server_full));
+            m_network->disconnect(event.source, cxxserver::DisconnectReason::SERVER_FULL);
             return;
         }
 
-        if (on_connect(peer))
+        if (on_connect(event))
         {
-            std::cout << "[  LOG  ]: connection from " << std::hex << peer->address.host << ':' << std::dec << peer->address.port << std::endl;
+            std::cout << "[  LOG  ]: connection from " << std::hex << event.address.host << ':' << std::dec << event.address.port << std::endl;
             return;
         }
     }
@@ -330,13 +423,13 @@ class protocol : public server_handler, public command_manager
     /**
      * @brief Try disconnecting peer
      *
-     * @param peer Peer to be disconnected
+     * @param event Disconnect event
      */
-    void try_disconnect(ENetPeer * peer)
+    void try_disconnect(const cxxserver::NetworkEvent & event)
     {
-        if (peer->data != nullptr)
+        if (auto * found = find_connection(event.source); found != nullptr)
         {
-            auto & connection = peer_to_connection(peer);
+            auto & connection = *found;
 
             // prevent locking map
             if (m_map_used && m_map_ownership == connection.id())
@@ -348,13 +441,60 @@ class protocol : public server_handler, public command_manager
             {
                 on_disconnect(connection);
             }
+            cancel_timers(connection);
             broadcast_leave(connection);
 
             detach_connection(connection);
-            peer->data = nullptr;
         }
 
-        std::cout << "[  LOG  ]: disconnected: " << std::hex << peer->address.host << ':' << std::dec << peer->address.port << std::endl;
+        std::cout << "[  LOG  ]: disconnected: " << std::hex << event.address.host << ':' << std::dec << event.address.port << std::endl;
+    }
+
+    /**
+     * @brief Try receiving packet
+     *
+     * The packet runs through the dispatcher first, built-in handling follows only if every
+     * handler accepted it.
+     *
+     * @param event Receive event (its packet is owned by the caller)
+     */
+    void try_receive(const cxxserver::NetworkEvent & event)
+    {
+        auto * found = find_connection(event.source);
+        if (found == nullptr)
+        {
+            return;
+        }
+
+        auto & connection = *found;
+        auto   state      = connection.m_has_joined ? cxxserver::ConnectionState::JOINED : cxxserver::ConnectionState::CONNECTING;
+        auto   result     = m_dispatcher.dispatch(state, cxxserver::Packet { event.bytes(), event.channel });
+        if (result == cxxserver::HandlerResult::INVALID_LENGTH)
+        {
+            std::cout << "[WARNING]: invalid packet length" << std::endl;
+        }
+        if (result != cxxserver::HandlerResult::VALID || event.length == 0)
+        {
+            return;
+        }
+
+        // streams take mutable data, inline packets are read from a copy
+        auto        payload = event.payload;
+        data_stream stream  = event.packet != nullptr ? data_stream { event.packet } : data_stream { payload.data(), event.length };
+        on_receive(connection, stream);
+    }
+
+    /**
+     * @brief Get packet dispatcher
+     *
+     * Handlers registered on it run after the built-in verify step and before the built-in
+     * handling, a result other than VALID drops the packet.
+     *
+     * @return Packet dispatcher
+     */
+    packet_dispatcher & get_dispatcher() noexcept
+    {
+        return m_dispatcher;
     }
 
     /**
@@ -364,12 +504,45 @@ class protocol : public server_handler, public command_manager
      */
     void set_world_update_delta(double delta)
     {
-        if (m_world_update_delta >= 0)
+        if (delta >= 0)
         {
             m_world_update_delta = delta;
         }
     }
 
+    /**
+     * @brief Set fixed step delta time (tick period of the scheduler calling update(steps))
+     *
+     * @param delta New delta time in seconds
+     */
+    void set_fixed_step(double delta)
+    {
+        if (delta > 0)
+        {
+            m_local_update_delta = delta;
+        }
+    }
+
+    /**
+     * @brief Set max number of fixed steps run by a single update
+     *
+     * @param steps Max steps
+     */
+    void set_max_catch_up(std::uint32_t steps)
+    {
+        m_max_catch_up = std::max(steps, 1U);
+    }
+
+    /**
+     * @brief Get fixed step number
+     *
+     * @return Number of steps since start
+     */
+    [[nodiscard]] std::uint64_t tick() const noexcept
+    {
+        return m_tick;
+    }
+
     /**
      * @brief Get random float number in range 0 to 1
      *
@@ -382,8 +555,91 @@ class protocol : public server_handler, public command_manager
 
   protected:
 
-    double m_world_update_delta { 0.1 };        //!< Requested world update delta time
-    double m_local_update_delta { 1.0 / 60.0 }; //!< Requested local update delta time
+    /**
+     * @brief Build phases of a single step
+     *
+     */
+    void build_tick_graph()
+    {
+        using resource = tick_resource;
+
+        m_tick_graph.add({ "timers", 0, resource::players, [this](cxxserver::JobSystem &) {
+                              m_timers.advance(elapsed_ms());
+                          } });
+
+        m_tick_graph.add({ "grenades_move", resource::map, resource::grenades, [this](cxxserver::JobSystem &) {
+                              grenades_move(float(m_local_update_delta));
+                          } });
+
+        // players only read the map and write their own state
+        m_tick_graph.add({ "players_move", resource::map, resource::players, [this](cxxserver::JobSystem & jobs) {
+                              jobs.parallel_for(m_connections.size(), m_move_grain, [this](std::size_t begin, std::size_t end) {
+                                  move_players(float(m_local_update_delta), begin, end);
+                              });
+                          } });
+
+        m_tick_graph.add({ "fall_damage", resource::players, resource::players | resource::network, [this](cxxserver::JobSystem &) {
+                              apply_fall_damage();
+                          } });
+
+        // corrections are taken out of the reconciler
+        m_tick_graph.add({ "corrections", resource::players, resource::players | resource::network, [this](cxxserver::JobSystem &) {
+                              apply_corrections();
+                          } });
+
+        // triggers may pick up intel
+        m_tick_graph.add({ "spatial", resource::players, resource::spatial | resource::players | resource::network, [this](cxxserver::JobSystem &) {
+                              update_spatial();
+                          } });
+
+        m_tick_graph.add({ "history", resource::players, resource::history, [this](cxxserver::JobSystem &) {
+                              record_history(m_tick, float(m_local_update_delta));
+                          } });
+
+        m_tick_graph.add({ "grenades_explode",
+                           resource::map | resource::players | resource::grenades | resource::spatial,
+                           resource::map | resource::players | resource::grenades | resource::network,
+                           [this](cxxserver::JobSystem &) { grenades_explode(); } });
+
+        // encoding reads only the snapshot and may run on another thread while the next step simulates
+        m_tick_graph.add({ "snapshot", resource::map | resource::players, resource::snapshot | resource::network, [this](cxxserver::JobSystem &) {
+                              publish_snapshot(*m_map, m_tick, m_tick % ticks_per(m_world_update_delta) == 0);
+                              send_world_updates();
+                          } });
+    }
+
+    /**
+     * @brief Get simulated time
+     *
+     * @return Time of the current step since start (ms)
+     */
+    [[nodiscard]] std::uint64_t elapsed_ms() const noexcept
+    {
+        return static_cast<std::uint64_t>(std::llround(double(m_tick) * m_local_update_delta * 1000.0));
+    }
+
+    /**
+     * @brief Convert interval to number of fixed steps
+     *
+     * @param interval Interval in seconds
+     * @return Number of steps (at least 1)
+     */
+    [[nodiscard]] std::uint64_t ticks_per(double interval) const noexcept
+    {
+        return std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::lround(interval / m_local_update_delta)));
+    }
+
+    double        m_world_update_delta { 0.1 };        //!< Requested world update delta time
+    double        m_local_update_delta { 1.0 / 60.0 }; //!< Fixed step delta time
+    double        m_accumulator { 0.0 };               //!< Wall clock time not yet simulated
+    std::uint64_t m_tick { 0 };                        //!< Fixed step number
+    std::uint32_t m_max_catch_up { 5 };                //!< Max fixed steps per update
+    std::size_t   m_move_grain { 4 };                  //!< Players moved by a single job (multiple of 4)
+
+    std::unique_ptr<cxxserver::JobSystem> m_jobs { std::make_unique<cxxserver::JobSystem>(0) }; //!< Job system
+    cxxserver::TickGraph                  m_tick_graph;                                          //!< Phases of a single step
+    packet_dispatcher                     m_dispatcher { packet_verifier {} };                   //!< Verify pipeline of received packets
+    cxxserver::NetworkWorkerGroup *       m_network { nullptr };                                 //!< Network worker group owning the peers
 
     float        m_base_trigger_distance { 5.F }; //!< Base trigger distance
     std::uint8_t m_restock_time { 15 };           //!< Restock cooldown
@@ -395,9 +651,7 @@ class protocol : public server_handler, public command_manager
 
     std::mt19937                                       m_generator;          //!< Random number generator
     std::uniform_real_distribution<float>              m_distribution;       //!< Real number distribution
-    std::chrono::time_point<std::chrono::steady_clock> m_one_second_timer;   //!< Respawn timer
-    std::chrono::time_point<std::chrono::steady_clock> m_world_update_timer; //!< World update timer
-    std::chrono::time_point<std::chrono::steady_clock> m_local_update_timer; //!< World update timer local
+    std::chrono::time_point<std::chrono::steady_clock> m_update_timer { std::chrono::steady_clock::now() }; //!< Last wall clock update
 };
 
 } // namespace spadesx
@@ -0,0 +1,931 @@
+/**
+ * @file schema.hxx
+ * @brief This file is part of the experimental SpadesX project
+ */
+
+#pragma once
+
+#include "data/color.hxx"
+#include "data/enums.hxx"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace spadesx {
+
+/**
+ * @brief Text at the end of a packet (optionally zero terminated)
+ *
+ * @tparam N Max length
+ */
+template <std::size_t N>
+struct text
+{
+    static constexpr const std::size_t max_size = N; //!< Max length
+
+    std::string_view value; //!< Text (points into the packet when decoded)
+};
+
+/**
+ * @brief Wire format of a field (little endian, packed)
+ *
+ * @tparam T Field type
+ */
+template <typename T>
+struct wire;
+
+/**
+ * @brief Single byte (bytes, flags and enums)
+ *
+ * @tparam T Field type
+ */
+template <typename T>
+    requires(std::is_enum_v<T> || std::is_same_v<T, std::uint8_t> || std::is_same_v<T, std::int8_t> || std::is_same_v<T, bool>)
+struct wire<T>
+{
+    static constexpr const std::size_t size = 1; //!< Size in bytes
+
+    static T read(const std::uint8_t * data) noexcept
+    {
+        return static_cast<T>(data[0]);
+    }
+
+    static void write(std::uint8_t * data, T value) noexcept
+    {
+        data[0] = static_cast<std::uint8_t>(value);
+    }
+};
+
+/**
+ * @brief 32-bit word
+ *
+ */
+template <>
+struct wire<std::uint32_t>
+{
+    static constexpr const std::size_t size = 4; //!< Size in bytes
+
+    static std::uint32_t read(const std::uint8_t * data) noexcept
+    {
+        std::uint32_t value;
+        std::memcpy(&value, data, size);
+        if constexpr (std::endian::native == std::endian::big)
+        {
+            value = std::byteswap(value);
+        }
+        return value;
+    }
+
+    static void write(std::uint8_t * data, std::uint32_t value) noexcept
+    {
+        if constexpr (std::endian::native == std::endian::big)
+        {
+            value = std::byteswap(value);
+        }
+        std::memcpy(data, &value, size);
+    }
+};
+
+/**
+ * @brief Float (bitcast to 32-bit word)
+ *
+ */
+template <>
+struct wire<float>
+{
+    static constexpr const std::size_t size = 4; //!< Size in bytes
+
+    static float read(const std::uint8_t * data) noexcept
+    {
+        return std::bit_cast<float>(wire<std::uint32_t>::read(data));
+    }
+
+    static void write(std::uint8_t * data, float value) noexcept
+    {
+        wire<std::uint32_t>::write(data, std::bit_cast<std::uint32_t>(value));
+    }
+};
+
+/**
+ * @brief 3D-vector (three 32-bit words, copied at once on little endian hosts)
+ *
+ * @tparam T Component type
+ */
+template <typename T>
+    requires(sizeof(T) == 4)
+struct wire<glm::vec<3, T, glm::defaultp>>
+{
+    using vector = glm::vec<3, T, glm::defaultp>;
+
+    static constexpr const std::size_t size = 12; //!< Size in bytes
+
+    static vector read(const std::uint8_t * data) noexcept
+    {
+        vector value;
+        if constexpr (std::endian::native == std::endian::little && sizeof(vector) == size)
+        {
+            std::memcpy(&value, data, size);
+        }
+        else
+        {
+            value.x = std::bit_cast<T>(wire<std::uint32_t>::read(data));
+            value.y = std::bit_cast<T>(wire<std::uint32_t>::read(data + 4));
+            value.z = std::bit_cast<T>(wire<std::uint32_t>::read(data + 8));
+        }
+        return value;
+    }
+
+    static void write(std::uint8_t * data, const vector & value) noexcept
+    {
+        if constexpr (std::endian::native == std::endian::little && sizeof(vector) == size)
+        {
+            std::memcpy(data, &value, size);
+        }
+        else
+        {
+            wire<std::uint32_t>::write(data, std::bit_cast<std::uint32_t>(value.x));
+            wire<std::uint32_t>::write(data + 4, std::bit_cast<std::uint32_t>(value.y));
+            wire<std::uint32_t>::write(data + 8, std::bit_cast<std::uint32_t>(value.z));
+        }
+    }
+};
+
+/**
+ * @brief RGB color (BGR order)
+ *
+ */
+template <>
+struct wire<color3b>
+{
+    static constexpr const std::size_t size = 3; //!< Size in bytes
+
+    static color3b read(const std::uint8_t * data) noexcept
+    {
+        return { data[2], data[1], data[0] };
+    }
+
+    static void write(std::uint8_t * data, const color3b & value) noexcept
+    {
+        data[0] = value.b;
+        data[1] = value.g;
+        data[2] = value.r;
+    }
+};
+
+/**
+ * @brief Text tail (takes the rest of the packet)
+ *
+ * @tparam N Max length
+ */
+template <std::size_t N>
+struct wire<text<N>>
+{
+    static constexpr const std::size_t size = 0; //!< Size of the fixed part
+
+    static text<N> read(const std::uint8_t * data, std::size_t length) noexcept
+    {
+        const auto * begin = reinterpret_cast<const char *>(data);
+        const auto * end   = static_cast<const char *>(std::memchr(begin, 0, length));
+        return { { begin, end != nullptr ? std::size_t(end - begin) : length } };
+    }
+
+    static std::size_t write(std::uint8_t * data, const text<N> & value) noexcept
+    {
+        auto length = std::min(value.value.size(), N);
+        std::memcpy(data, value.value.data(), length);
+        return length;
+    }
+};
+
+namespace detail {
+
+template <typename T>
+struct member_traits;
+
+template <typename C, typename T>
+struct member_traits<T C::*>
+{
+    using type = T;
+};
+
+template <typename T>
+inline constexpr bool is_text = false;
+
+template <std::size_t N>
+inline constexpr bool is_text<text<N>> = true;
+
+template <typename... T>
+consteval bool text_is_last() noexcept
+{
+    constexpr std::array<bool, sizeof...(T)> texts { is_text<T>... };
+    for (std::size_t i = 0; i + 1 < texts.size(); ++i)
+    {
+        if (texts[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+/**
+ * @brief Packet layout
+ *
+ * Fields follow the packet ID in declaration order at offsets fixed at compile time. Only the last
+ * field may be a text, so every other field is read from a constant offset without any bounds
+ * check once the packet length was validated against min_size and max_size.
+ *
+ * @tparam Type Packet ID
+ * @tparam Members Pointers to the fields (wire order)
+ */
+template <packet_type Type, auto... Members>
+struct layout
+{
+    static constexpr const packet_type type  = Type;               //!< Packet ID
+    static constexpr const std::size_t count = sizeof...(Members); //!< Number of fields
+
+    template <std::size_t I>
+    using field_type = typename detail::member_traits<std::tuple_element_t<I, std::tuple<decltype(Members)...>>>::type;
+
+    /**
+     * @brief Get offset of field (the packet ID is at offset 0)
+     *
+     * @param index Field index
+     * @return Offset in bytes
+     */
+    static consteval std::size_t offset(std::size_t index) noexcept
+    {
+        std::size_t result = 1;
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ((result += I < index ? wire<field_type<I>>::size : 0), ...);
+        }(std::make_index_sequence<count> {});
+        return result;
+    }
+
+    /**
+     * @brief Get max text length
+     *
+     * @return Max length (0 if the packet has no text)
+     */
+    static consteval std::size_t text_size() noexcept
+    {
+        std::size_t result = 0;
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ((result += max_text<field_type<I>>()), ...);
+        }(std::make_index_sequence<count> {});
+        return result;
+    }
+
+    static constexpr const std::size_t min_size = offset(count);               //!< Min packet size
+    static constexpr const std::size_t max_size = offset(count) + text_size(); //!< Max packet size
+
+    static_assert(detail::text_is_last<typename detail::member_traits<decltype(Members)>::type...>(), "only the last field may be a text");
+
+    /**
+     * @brief Decode packet
+     *
+     * @tparam Packet Packet type
+     * @param data Packet data (starting with the packet ID)
+     * @param length Packet length (between min_size and max_size)
+     * @return Packet
+     */
+    template <typename Packet>
+    static Packet decode(const std::uint8_t * data, std::size_t length) noexcept
+    {
+        Packet packet {};
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ((packet.*Members = read<field_type<I>>(data + offset(I), length - offset(I))), ...);
+        }(std::make_index_sequence<count> {});
+        return packet;
+    }
+
+    /**
+     * @brief Encode packet
+     *
+     * @tparam Packet Packet type
+     * @param packet Packet
+     * @param data Output (at least max_size bytes)
+     * @return Packet length
+     */
+    template <typename Packet>
+    static std::size_t encode(const Packet & packet, std::uint8_t * data) noexcept
+    {
+        std::size_t length = min_size;
+        data[0]            = static_cast<std::uint8_t>(Type);
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+            ((length += write<field_type<I>>(data + offset(I), packet.*Members)), ...);
+        }(std::make_index_sequence<count> {});
+        return length;
+    }
+
+  private:
+
+    template <typename T>
+    static consteval std::size_t max_text() noexcept
+    {
+        if constexpr (detail::is_text<T>)
+        {
+            return T::max_size;
+        }
+        else
+        {
+            return 0;
+        }
+    }
+
+    template <typename T>
+    static T read(const std::uint8_t * data, [[maybe_unused]] std::size_t length) noexcept
+    {
+        if constexpr (detail::is_text<T>)
+        {
+            return wire<T>::read(data, length);
+        }
+        else
+        {
+            return wire<T>::read(data);
+        }
+    }
+
+    template <typename T>
+    static std::size_t write(std::uint8_t * data, const T & value) noexcept
+    {
+        if constexpr (detail::is_text<T>)
+        {
+            return wire<T>::write(data, value);
+        }
+        else
+        {
+            wire<T>::write(data, value);
+            return 0;
+        }
+    }
+};
+
+/**
+ * @brief Layout of a packet encoded elsewhere (only its size is known here)
+ *
+ * @tparam Type Packet ID
+ * @tparam Min Min packet size
+ * @tparam Max Max packet size
+ */
+template <packet_type Type, std::size_t Min, std::size_t Max = Min>
+struct opaque_layout
+{
+    static constexpr const packet_type type     = Type; //!< Packet ID
+    static constexpr const std::size_t min_size = Min;  //!< Min packet size
+    static constexpr const std::size_t max_size = Max;  //!< Max packet size
+};
+
+namespace packets {
+
+/**
+ * @brief Position data packet
+ *
+ */
+struct position_data
+{
+    glm::vec3 position;
+
+    using layout = spadesx::layout<packet_type::position_data, &position_data::position>;
+};
+
+/**
+ * @brief Orientation data packet
+ *
+ */
+struct orientation_data
+{
+    glm::vec3 orientation;
+
+    using layout = spadesx::layout<packet_type::orientation_data, &orientation_data::orientation>;
+};
+
+/**
+ * @brief World update packet
+ *
+ */
+struct world_update
+{
+    using layout = opaque_layout<packet_type::world_update, 769>;
+};
+
+/**
+ * @brief Input data packet
+ *
+ */
+struct input_data
+{
+    std::uint8_t player_id;
+    std::uint8_t input;
+
+    using layout = spadesx::layout<packet_type::input_data, &input_data::player_id, &input_data::input>;
+};
+
+/**
+ * @brief Weapon input packet
+ *
+ */
+struct weapon_input
+{
+    std::uint8_t player_id;
+    std::uint8_t input;
+
+    using layout = spadesx::layout<packet_type::weapon_input, &weapon_input::player_id, &weapon_input::input>;
+};
+
+/**
+ * @brief Hit packet
+ *
+ */
+struct hit_packet
+{
+    std::uint8_t target;
+    hit_type     type;
+
+    using layout = spadesx::layout<packet_type::hit_packet, &hit_packet::target, &hit_packet::type>;
+};
+
+/**
+ * @brief Set hp packet
+ *
+ */
+struct set_hp
+{
+    std::uint8_t health;
+    bool         weapon;
+    glm::vec3    source;
+
+    using layout = spadesx::layout<packet_type::set_hp, &set_hp::health, &set_hp::weapon, &set_hp::source>;
+};
+
+/**
+ * @brief Grenade packet
+ *
+ */
+struct grenade_packet
+{
+    std::uint8_t player_id;
+    float        fuse;
+    glm::vec3    position;
+    glm::vec3    velocity;
+
+    using layout = spadesx::layout<packet_type::grenade_packet,
+                                   &grenade_packet::player_id,
+                                   &grenade_packet::fuse,
+                                   &grenade_packet::position,
+                                   &grenade_packet::velocity>;
+};
+
+/**
+ * @brief Set tool packet
+ *
+ */
+struct set_tool
+{
+    std::uint8_t player_id;
+    tool_type    tool;
+
+    using layout = spadesx::layout<packet_type::set_tool, &set_tool::player_id, &set_tool::tool>;
+};
+
+/**
+ * @brief Set color packet
+ *
+ */
+struct set_color
+{
+    std::uint8_t player_id;
+    color3b      color;
+
+    using layout = spadesx::layout<packet_type::set_color, &set_color::player_id, &set_color::color>;
+};
+
+/**
+ * @brief Existing player packet
+ *
+ */
+struct existing_player
+{
+    std::uint8_t  player_id;
+    team_type     team;
+    weapon_type   weapon;
+    tool_type     tool;
+    std::uint32_t kills;
+    color3b       color;
+    text<16>      name;
+
+    using layout = spadesx::layout<packet_type::existing_player,
+                                   &existing_player::player_id,
+                                   &existing_player::team,
+                                   &existing_player::weapon,
+                                   &existing_player::tool,
+                                   &existing_player::kills,
+                                   &existing_player::color,
+                                   &existing_player::name>;
+};
+
+/**
+ * @brief Short player data packet
+ *
+ */
+struct short_player_data
+{
+    std::uint8_t player_id;
+    team_type    team;
+    weapon_type  weapon;
+
+    using layout = spadesx::layout<packet_type::short_player_data, &short_player_data::player_id, &short_player_data::team, &short_player_data::weapon>;
+};
+
+/**
+ * @brief Move object packet
+ *
+ */
+struct move_object
+{
+    std::uint8_t object_id;
+    team_type    team;
+    glm::vec3    position;
+
+    using layout = spadesx::layout<packet_type::move_object, &move_object::object_id, &move_object::team, &move_object::position>;
+};
+
+/**
+ * @brief Create player packet
+ *
+ */
+struct create_player
+{
+    std::uint8_t player_id;
+    weapon_type  weapon;
+    team_type    team;
+    glm::vec3    position;
+    text<16>     name;
+
+    using layout = spadesx::layout<packet_type::create_player,
+                                   &create_player::player_id,
+                                   &create_player::weapon,
+                                   &create_player::team,
+                                   &create_player::position,
+                                   &create_player::name>;
+};
+
+/**
+ * @brief Block action packet
+ *
+ */
+struct block_action
+{
+    std::uint8_t      player_id;
+    block_action_type action;
+    glm::uvec3        position;
+
+    using layout = spadesx::layout<packet_type::block_action, &block_action::player_id, &block_action::action, &block_action::position>;
+};
+
+/**
+ * @brief Block line packet
+ *
+ */
+struct block_line
+{
+    std::uint8_t player_id;
+    glm::uvec3   start;
+    glm::uvec3   end;
+
+    using layout = spadesx::layout<packet_type::block_line, &block_line::player_id, &block_line::start, &block_line::end>;
+};
+
+/**
+ * @brief State data packet
+ *
+ */
+struct state_data
+{
+    using layout = opaque_layout<packet_type::state_data, 90>;
+};
+
+/**
+ * @brief Kill action packet
+ *
+ */
+struct kill_action
+{
+    std::uint8_t player_id;
+    std::uint8_t killer_id;
+    kill_type    type;
+    std::uint8_t respawn_time;
+
+    using layout = spadesx::layout<packet_type::kill_action, &kill_action::player_id, &kill_action::killer_id, &kill_action::type, &kill_action::respawn_time>;
+};
+
+/**
+ * @brief Chat message packet
+ *
+ */
+struct chat_message
+{
+    std::uint8_t player_id;
+    chat_type    type;
+    text<255>    message;
+
+    using layout = spadesx::layout<packet_type::chat_message, &chat_message::player_id, &chat_message::type, &chat_message::message>;
+};
+
+/**
+ * @brief Map start packet
+ *
+ */
+struct map_start
+{
+    std::uint32_t size;
+
+    using layout = spadesx::layout<packet_type::map_start, &map_start::size>;
+};
+
+/**
+ * @brief Map chunk packet
+ *
+ */
+struct map_chunk
+{
+    using layout = opaque_layout<packet_type::map_chunk, 1, 8193>;
+};
+
+/**
+ * @brief Player left packet
+ *
+ */
+struct player_left
+{
+    std::uint8_t player_id;
+
+    using layout = spadesx::layout<packet_type::player_left, &player_left::player_id>;
+};
+
+/**
+ * @brief Territory capture packet
+ *
+ */
+struct territory_capture
+{
+    std::uint8_t player_id;
+    std::uint8_t entity_id;
+    bool         winning;
+    team_type    state;
+
+    using layout = spadesx::layout<packet_type::territory_capture,
+                                   &territory_capture::player_id,
+                                   &territory_capture::entity_id,
+                                   &territory_capture::winning,
+                                   &territory_capture::state>;
+};
+
+/**
+ * @brief Progress bar packet
+ *
+ */
+struct progress_bar
+{
+    std::uint8_t entity_id;
+    team_type    capturing_team;
+    std::int8_t  rate;
+    float        progress;
+
+    using layout = spadesx::layout<packet_type::progress_bar, &progress_bar::entity_id, &progress_bar::capturing_team, &progress_bar::rate, &progress_bar::progress>;
+};
+
+/**
+ * @brief Intel capture packet
+ *
+ */
+struct intel_capture
+{
+    std::uint8_t player_id;
+    bool         winning;
+
+    using layout = spadesx::layout<packet_type::intel_capture, &intel_capture::player_id, &intel_capture::winning>;
+};
+
+/**
+ * @brief Intel pickup packet
+ *
+ */
+struct intel_pickup
+{
+    std::uint8_t player_id;
+
+    using layout = spadesx::layout<packet_type::intel_pickup, &intel_pickup::player_id>;
+};
+
+/**
+ * @brief Intel drop packet
+ *
+ */
+struct intel_drop
+{
+    std::uint8_t player_id;
+    glm::uvec3   position;
+
+    using layout = spadesx::layout<packet_type::intel_drop, &intel_drop::player_id, &intel_drop::position>;
+};
+
+/**
+ * @brief Restock packet
+ *
+ */
+struct restock
+{
+    std::uint8_t player_id;
+
+    using layout = spadesx::layout<packet_type::restock, &restock::player_id>;
+};
+
+/**
+ * @brief Fog color packet
+ *
+ */
+struct fog_color
+{
+    std::uint32_t color; //!< ARGB
+
+    using layout = spadesx::layout<packet_type::fog_color, &fog_color::color>;
+};
+
+/**
+ * @brief Weapon reload packet
+ *
+ */
+struct weapon_reload
+{
+    std::uint8_t player_id;
+    std::uint8_t clip_ammo;
+    std::uint8_t reserve_ammo;
+
+    using layout = spadesx::layout<packet_type::weapon_reload, &weapon_reload::player_id, &weapon_reload::clip_ammo, &weapon_reload::reserve_ammo>;
+};
+
+/**
+ * @brief Change team packet
+ *
+ */
+struct change_team
+{
+    std::uint8_t player_id;
+    team_type    team;
+
+    using layout = spadesx::layout<packet_type::change_team, &change_team::player_id, &change_team::team>;
+};
+
+/**
+ * @brief Change weapon packet
+ *
+ */
+struct change_weapon
+{
+    std::uint8_t player_id;
+    weapon_type  weapon;
+
+    using layout = spadesx::layout<packet_type::change_weapon, &change_weapon::player_id, &change_weapon::weapon>;
+};
+
+} // namespace packets
+
+/**
+ * @brief Valid length range of a packet ID
+ *
+ */
+struct length_range
+{
+    std::uint16_t min; //!< Min length
+    std::uint16_t max; //!< Max length (less than min for unknown IDs)
+};
+
+using length_table = std::array<length_range, 256>;
+
+/**
+ * @brief Build length table of packets
+ *
+ * @tparam Packets Packet types (one per ID)
+ * @return Length table
+ */
+template <typename... Packets>
+consteval length_table make_length_table() noexcept
+{
+    length_table table;
+    table.fill({ 1, 0 });
+    ((table[static_cast<std::size_t>(Packets::layout::type)] = { std::uint16_t(Packets::layout::min_size), std::uint16_t(Packets::layout::max_size) }), ...);
+    return table;
+}
+
+/**
+ * @brief Lengths of the packets accepted from clients
+ *
+ */
+inline constexpr const length_table client_lengths = make_length_table<packets::position_data,
+                                                                       packets::orientation_data,
+                                                                       packets::input_data,
+                                                                       packets::weapon_input,
+                                                                       packets::hit_packet,
+                                                                       packets::grenade_packet,
+                                                                       packets::set_tool,
+                                                                       packets::set_color,
+                                                                       packets::existing_player,
+                                                                       packets::block_action,
+                                                                       packets::block_line,
+                                                                       packets::chat_message,
+                                                                       packets::weapon_reload,
+                                                                       packets::change_team,
+                                                                       packets::change_weapon>();
+
+/**
+ * @brief Lengths of the packets sent by the server
+ *
+ */
+inline constexpr const length_table server_lengths = make_length_table<packets::position_data,
+                                                                       packets::orientation_data,
+                                                                       packets::world_update,
+                                                                       packets::input_data,
+                                                                       packets::weapon_input,
+                                                                       packets::set_hp,
+                                                                       packets::grenade_packet,
+                                                                       packets::set_tool,
+                                                                       packets::set_color,
+                                                                       packets::existing_player,
+                                                                       packets::short_player_data,
+                                                                       packets::move_object,
+                                                                       packets::create_player,
+                                                                       packets::block_action,
+                                                                       packets::block_line,
+                                                                       packets::state_data,
+                                                                       packets::kill_action,
+                                                                       packets::chat_message,
+                                                                       packets::map_start,
+                                                                       packets::map_chunk,
+                                                                       packets::player_left,
+                                                                       packets::territory_capture,
+                                                                       packets::progress_bar,
+                                                                       packets::intel_capture,
+                                                                       packets::intel_pickup,
+                                                                       packets::intel_drop,
+                                                                       packets::restock,
+                                                                       packets::fog_color,
+                                                                       packets::weapon_reload>();
+
+/**
+ * @brief Check packet length
+ *
+ * @param table Length table
+ * @param data Packet data
+ * @param length Packet length
+ * @return true If the packet ID is known and the length is within its range
+ */
+inline bool is_valid_length(const length_table & table, const std::uint8_t * data, std::size_t length) noexcept
+{
+    if (length == 0)
+    {
+        return false;
+    }
+    const auto & range = table[data[0]];
+    return length >= range.min && length <= range.max;
+}
+
+/**
+ * @brief Decode packet
+ *
+ * @tparam Packet Packet type
+ * @param data Packet data (starting with the packet ID)
+ * @param length Packet length (validated)
+ * @return Packet
+ */
+template <typename Packet>
+Packet decode(const std::uint8_t * data, std::size_t length) noexcept
+{
+    return Packet::layout::template decode<Packet>(data, length);
+}
+
+/**
+ * @brief Encode packet
+ *
+ * @tparam Packet Packet type
+ * @param packet Packet
+ * @param data Output (at least max_size bytes)
+ * @return Packet length
+ */
+template <typename Packet>
+std::size_t encode(const Packet & packet, std::uint8_t * data) noexcept
+{
+    return Packet::layout::template encode<Packet>(packet, data);
+}
+
+} // namespace spadesx
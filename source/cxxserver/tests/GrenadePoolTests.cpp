@@ -0,0 +1,180 @@
+#include "cxxserver/old/data/grenade_pool.hxx"
+#include "cxxserver/tests/TestMap.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <doctest_fwd.h>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace cxxserver::tests {
+
+namespace {
+
+using spadesx::grenade;
+using spadesx::grenade_pool;
+
+constexpr float DELTA = 1.F / 60.F;
+
+bool same_bits(const glm::vec3& lhs, const glm::vec3& rhs)
+{
+    return std::bit_cast<std::uint32_t>(lhs.x) == std::bit_cast<std::uint32_t>(rhs.x) &&
+           std::bit_cast<std::uint32_t>(lhs.y) == std::bit_cast<std::uint32_t>(rhs.y) &&
+           std::bit_cast<std::uint32_t>(lhs.z) == std::bit_cast<std::uint32_t>(rhs.z);
+}
+
+///
+/// @brief Add grenade at rest, only the fuse matters
+///
+///
+bool add(grenade_pool& pool, std::uint8_t owner, float fuse)
+{
+    return pool.add(owner, spadesx::team_type::a, {100.5F, 100.5F, TestMap::GROUND_Z - 0.5F}, {}, fuse);
+}
+
+std::vector<std::uint8_t> owners(const grenade_pool& pool)
+{
+    std::vector<std::uint8_t> result;
+    for (std::size_t index = 0; index < pool.size(); ++index) {
+        result.push_back(pool.at(index).id());
+    }
+    return result;
+}
+
+std::vector<std::uint8_t> owners(const std::vector<grenade>& grenades)
+{
+    std::vector<std::uint8_t> result;
+    for (const auto& grenade : grenades) {
+        result.push_back(grenade.id());
+    }
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("grenade_pool refuses grenades when full")
+{
+    auto         map = TestMap::create();
+    grenade_pool pool;
+
+    REQUIRE(add(pool, 0, DELTA / 2.F));
+    for (std::size_t owner = 1; owner < grenade_pool::capacity; ++owner) {
+        REQUIRE(add(pool, static_cast<std::uint8_t>(owner), 1.F));
+    }
+    CHECK(pool.size() == grenade_pool::capacity);
+    CHECK_FALSE(add(pool, 0, 1.F));
+    CHECK(pool.size() == grenade_pool::capacity);
+
+    // an explosion frees a slot
+    pool.update(*map, DELTA);
+    CHECK(pool.size() == grenade_pool::capacity - 1);
+    CHECK(add(pool, 0, 1.F));
+    CHECK_FALSE(add(pool, 0, 1.F));
+}
+
+TEST_CASE("grenade_pool moves the last grenade into the slot of an expired one")
+{
+    auto         map = TestMap::create();
+    grenade_pool pool;
+
+    REQUIRE(add(pool, 0, 1.F));
+    REQUIRE(add(pool, 1, DELTA / 2.F));
+    REQUIRE(add(pool, 2, 1.F));
+    REQUIRE(add(pool, 3, DELTA / 2.F));
+    REQUIRE(add(pool, 4, 1.F));
+
+    pool.update(*map, DELTA);
+    CHECK(owners(pool) == std::vector<std::uint8_t>{0, 4, 2});
+    CHECK(owners(pool.explosions()) == std::vector<std::uint8_t>{1, 3});
+
+    // expired grenades moved into a freed slot are checked again
+    REQUIRE(add(pool, 5, DELTA / 2.F));
+    REQUIRE(add(pool, 6, DELTA / 2.F));
+    pool.clear_explosions();
+    CHECK(pool.explosions().empty());
+    pool.update(*map, DELTA);
+    CHECK(owners(pool) == std::vector<std::uint8_t>{0, 4, 2});
+    CHECK(owners(pool.explosions()) == std::vector<std::uint8_t>{5, 6});
+
+    // explosions are kept until cleared
+    REQUIRE(add(pool, 7, DELTA / 2.F));
+    pool.update(*map, DELTA);
+    CHECK(owners(pool.explosions()) == std::vector<std::uint8_t>{5, 6, 7});
+}
+
+TEST_CASE("grenade_pool moves grenades bit exact with grenade::update")
+{
+    constexpr std::size_t STEPS = 240;
+
+    auto         map = TestMap::create();
+    std::mt19937 generator{37};
+
+    std::uniform_real_distribution<float> area{TestMap::CENTER - TestMap::EXTENT, TestMap::CENTER + TestMap::EXTENT};
+    std::uniform_real_distribution<float> height{TestMap::GROUND_Z - 8.F, TestMap::GROUND_Z - 4.5F};
+    std::uniform_real_distribution<float> speed{-1.F, 1.F};
+    std::uniform_real_distribution<float> fuse{0.F, STEPS * DELTA / 4.F};
+    std::bernoulli_distribution           coin;
+
+    grenade_pool                        pool;
+    std::vector<std::optional<grenade>> expected(grenade_pool::capacity); // by grenade ID
+    std::size_t                         next     = 0;
+    std::size_t                         exploded = 0;
+
+    for (std::size_t step = 0; step < STEPS; ++step) {
+        // keep throwing while IDs are left, so slots are refilled after compaction
+        std::size_t throws = step == 0 ? 64 : 1;
+        for (; throws > 0 && next < grenade_pool::capacity; --throws) {
+            grenade thrown{static_cast<std::uint8_t>(next),
+                           coin(generator) ? spadesx::team_type::a : spadesx::team_type::b,
+                           {area(generator), area(generator), height(generator)},
+                           {speed(generator), speed(generator), speed(generator)},
+                           fuse(generator)};
+            REQUIRE(pool.add(thrown.id(), thrown.team(), thrown.m_position, thrown.m_velocity, thrown.m_fuse));
+            expected[next++] = thrown;
+        }
+
+        pool.clear_explosions();
+        pool.update(*map, DELTA);
+        for (auto& grenade : expected) {
+            if (grenade) {
+                grenade->update(*map, DELTA);
+            }
+        }
+        CAPTURE(step);
+
+        for (const auto& explosion : pool.explosions()) {
+            auto& reference = expected[explosion.id()];
+            REQUIRE(reference.has_value());
+            CHECK(reference->m_fuse <= 0.F);
+            CHECK(same_bits(explosion.m_position, reference->m_position));
+            reference.reset();
+            ++exploded;
+        }
+
+        std::size_t alive = 0;
+        for (std::size_t index = 0; index < pool.size(); ++index) {
+            auto  actual    = pool.at(index);
+            auto& reference = expected[actual.id()];
+            CAPTURE(index);
+            REQUIRE(reference.has_value());
+            CHECK(actual.team() == reference->team());
+            CHECK(actual.m_fuse == reference->m_fuse);
+            CHECK(actual.m_fuse > 0.F);
+            CHECK(same_bits(actual.m_position, reference->m_position));
+            CHECK(same_bits(actual.m_velocity, reference->m_velocity));
+            ++alive;
+        }
+
+        // every grenade is either in the pool or exploded, never both
+        std::size_t remaining = 0;
+        for (const auto& grenade : expected) {
+            remaining += grenade.has_value() ? 1 : 0;
+        }
+        CHECK(alive == remaining);
+    }
+    CHECK(exploded > grenade_pool::capacity / 2);
+}
+
+} // namespace cxxserver::tests
@@ -0,0 +1,215 @@
+#include "cxxserver/old/data/grenade.hxx"
+#include "cxxserver/tests/TestMap.hpp"
+
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <doctest_fwd.h>
+#include <random>
+
+namespace cxxserver::tests {
+
+namespace {
+
+using spadesx::grenade;
+
+bool same_bits(const glm::vec3& lhs, const glm::vec3& rhs)
+{
+    return std::bit_cast<std::uint32_t>(lhs.x) == std::bit_cast<std::uint32_t>(rhs.x) &&
+           std::bit_cast<std::uint32_t>(lhs.y) == std::bit_cast<std::uint32_t>(rhs.y) &&
+           std::bit_cast<std::uint32_t>(lhs.z) == std::bit_cast<std::uint32_t>(rhs.z);
+}
+
+///
+/// @brief Per-step integration the sweep replaced
+///
+/// The grenade jumps to the end of the step, if it lands in a solid block it goes back to the start
+/// of the step and the axis of the crossed face is reflected.
+///
+/// @return true If the grenade bounced
+///
+bool legacy_move(const spadesx::map& map, glm::vec3& position, glm::vec3& velocity, float dt)
+{
+    glm::vec3 prev = position;
+    position       += velocity * dt;
+
+    glm::ivec3 b = glm::floor(position);
+    if (!map.is_clip_world(b.x, b.y, b.z)) {
+        return false;
+    }
+
+    glm::ivec3 a = glm::floor(prev);
+    if (b.z != a.z && ((b.x == a.x && b.y == a.y) || !map.is_clip_world(b.x, b.y, a.z))) {
+        velocity.z = -velocity.z;
+    } else if (b.x != a.x && ((b.y == a.y && b.z == a.z) || !map.is_clip_world(a.x, b.y, b.z))) {
+        velocity.x = -velocity.x;
+    } else if (b.y != a.y && ((b.x == a.x && b.z == a.z) || !map.is_clip_world(b.x, a.y, b.z))) {
+        velocity.y = -velocity.y;
+    }
+    position = prev;
+    velocity *= 0.36F;
+    return true;
+}
+
+///
+/// @brief Per-step update the sweep replaced (gravity before the move)
+///
+///
+void legacy_update(const spadesx::map& map, glm::vec3& position, glm::vec3& velocity, float delta)
+{
+    velocity.z += delta;
+    legacy_move(map, position, velocity, delta * 32.F);
+}
+
+} // namespace
+
+TEST_CASE("grenade sweep moves like the per-step integration in free flight")
+{
+    constexpr std::size_t SAMPLES = 20000;
+    constexpr float       DT      = 32.F / 60.F;
+
+    auto         map = TestMap::create();
+    std::mt19937 generator{36};
+
+    std::uniform_real_distribution<float> area{TestMap::CENTER - TestMap::EXTENT, TestMap::CENTER + TestMap::EXTENT};
+    std::uniform_real_distribution<float> height{TestMap::GROUND_Z - 10.F, TestMap::GROUND_Z - 0.01F};
+    std::uniform_real_distribution<float> speed{-1.F, 1.F};
+
+    std::size_t free = 0;
+    for (std::size_t sample = 0; sample < SAMPLES; ++sample) {
+        glm::vec3 position{area(generator), area(generator), height(generator)};
+        glm::vec3 velocity{speed(generator), speed(generator), speed(generator)};
+        glm::ivec3 block = glm::floor(position);
+        if (map->is_clip_world(block.x, block.y, block.z)) {
+            continue;
+        }
+
+        glm::vec3 expected_position = position;
+        glm::vec3 expected_velocity = velocity;
+        glm::vec3 actual_position   = position;
+        glm::vec3 actual_velocity   = velocity;
+
+        spadesx::ray::sweep_hit hit{};
+        if (spadesx::ray::sweep(*map, position, position + velocity * DT, hit)) {
+            continue;
+        }
+        ++free;
+
+        CHECK_FALSE(legacy_move(*map, expected_position, expected_velocity, DT));
+        grenade::move(*map, actual_position, actual_velocity, actual_velocity * DT, DT);
+        CHECK(same_bits(actual_position, expected_position));
+        CHECK(same_bits(actual_velocity, expected_velocity));
+    }
+    CHECK(free > SAMPLES / 2);
+}
+
+TEST_CASE("grenade sweep bounces on the same face as the per-step integration")
+{
+    constexpr std::size_t SAMPLES = 20000;
+    constexpr float       DT      = 32.F / 60.F;
+
+    auto         map = TestMap::create();
+    std::mt19937 generator{36};
+
+    std::uniform_real_distribution<float> area{TestMap::CENTER - TestMap::EXTENT, TestMap::CENTER + TestMap::EXTENT};
+    std::uniform_real_distribution<float> height{TestMap::GROUND_Z - 5.F, TestMap::GROUND_Z - 0.01F};
+    std::uniform_real_distribution<float> speed{-0.8F, 0.8F};
+
+    std::size_t bounces = 0;
+    for (std::size_t sample = 0; sample < SAMPLES; ++sample) {
+        glm::vec3 position{area(generator), area(generator), height(generator)};
+        glm::vec3 velocity{speed(generator), speed(generator), speed(generator)};
+
+        // single face crossed into a solid block: both agree on where the grenade hit
+        glm::ivec3 from = glm::floor(position);
+        glm::ivec3 to   = glm::floor(position + velocity * DT);
+        glm::ivec3 step = glm::abs(to - from);
+        if (step.x + step.y + step.z != 1 || map->is_clip_world(from.x, from.y, from.z) || !map->is_clip_world(to.x, to.y, to.z)) {
+            continue;
+        }
+        ++bounces;
+
+        glm::vec3 expected_position = position;
+        glm::vec3 expected_velocity = velocity;
+        REQUIRE(legacy_move(*map, expected_position, expected_velocity, DT));
+
+        // a single bounce for the comparison, the sweep would continue the rest of the step
+        spadesx::ray::sweep_hit hit{};
+        REQUIRE(spadesx::ray::sweep(*map, position, position + velocity * DT, hit));
+        CHECK(hit.block == to);
+        CHECK(hit.normal == from - to);
+
+        auto      axis            = hit.normal.x != 0 ? 0 : (hit.normal.y != 0 ? 1 : 2);
+        glm::vec3 actual_velocity = velocity;
+        actual_velocity[axis]     = -actual_velocity[axis];
+        actual_velocity           *= grenade::restitution;
+        CHECK(same_bits(actual_velocity, expected_velocity));
+
+        // the bounce happens at the face instead of the start of the step, the rest of the step
+        // may bounce again but never ends inside a block
+        glm::vec3 actual_position = position;
+        glm::vec3 moved_velocity  = velocity;
+        grenade::move(*map, actual_position, moved_velocity, velocity * DT, DT);
+        glm::vec3  after_bounce = position + velocity * DT * hit.time + glm::vec3{hit.normal} * grenade::separation;
+        spadesx::ray::sweep_hit rest{};
+        if (!spadesx::ray::sweep(*map, after_bounce, after_bounce + expected_velocity * (DT * (1.F - hit.time)), rest)) {
+            CHECK(same_bits(moved_velocity, expected_velocity));
+        } else {
+            CHECK(glm::length(moved_velocity) <= glm::length(expected_velocity));
+        }
+        glm::ivec3 end = glm::floor(actual_position);
+        CHECK_FALSE(map->is_clip_world(end.x, end.y, end.z));
+    }
+    CHECK(bounces > SAMPLES / 100);
+}
+
+TEST_CASE("grenade sweep at a coarse step follows the fine per-step integration")
+{
+    constexpr float       COARSE   = 1.F / 20.F;
+    constexpr std::size_t FINENESS = 400;
+    constexpr float       FINE     = COARSE / FINENESS;
+    constexpr std::size_t STEPS    = 40; // two seconds, a few floor bounces
+
+    auto map = TestMap::create();
+
+    // thrown over flat ground, away from the obstacles
+    const glm::vec3 start{100.5F, 100.5F, TestMap::GROUND_Z - 6.F};
+    const glm::vec3 throw_velocity{0.3F, 0.1F, -0.2F};
+
+    grenade   coarse{0, spadesx::team_type::a, start, throw_velocity, 10.F};
+    grenade   fine{0, spadesx::team_type::a, start, throw_velocity, 10.F};
+    glm::vec3 expected_position = start;
+    glm::vec3 expected_velocity = throw_velocity;
+
+    bool bounced = false;
+    for (std::size_t step = 0; step < STEPS; ++step) {
+        float falling = expected_velocity.z;
+        coarse.update(*map, COARSE);
+        for (std::size_t substep = 0; substep < FINENESS; ++substep) {
+            fine.update(*map, FINE);
+            legacy_update(*map, expected_position, expected_velocity, FINE);
+        }
+        CAPTURE(step);
+
+        // at the fine step the sweep follows the per-step integration through every bounce
+        CHECK(glm::distance(fine.m_position, expected_position) < 0.01F);
+        CHECK(glm::distance(fine.m_velocity, expected_velocity) < 0.01F);
+
+        // a coarse step reflects the velocity at the end of the step instead of the one at the
+        // impact, so it follows up to the first bounce and is off by at most a step of gravity then
+        if (!bounced) {
+            bounced = falling > 0.F && expected_velocity.z < 0.F;
+            CHECK(glm::distance(coarse.m_position, expected_position) < 0.05F);
+            CHECK(glm::abs(coarse.m_velocity.z - expected_velocity.z) < COARSE * grenade::restitution);
+        }
+
+        for (const auto& position : {coarse.m_position, fine.m_position}) {
+            glm::ivec3 block = glm::floor(position);
+            CHECK_FALSE(map->is_clip_world(block.x, block.y, block.z));
+        }
+    }
+    CHECK(bounced);
+}
+
+} // namespace cxxserver::tests
@@ -0,0 +1,263 @@
+#include "cxxserver/NetworkWorker.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <doctest_fwd.h>
+#include <enet/enet.h>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace cxxserver::tests {
+
+namespace {
+
+constexpr std::uint16_t PORT          = Host::CreateInfo::DEFAULT_PORT + 100;
+constexpr std::uint32_t PING_INTERVAL = 60000;
+
+///
+/// @brief ENet client connected to the workers over loopback
+///
+///
+class Client {
+public:
+
+    struct Receive {
+        std::vector<std::uint8_t> data;
+        std::uint8_t              channel;
+    };
+
+    Client()
+        : m_host{enet_host_create(nullptr, 1, Host::CreateInfo::DEFAULT_CHANNELS, 0, 0)}
+    {
+        REQUIRE(m_host != nullptr);
+        REQUIRE(enet_host_compress_with_range_coder(m_host) == 0);
+    }
+
+    Client(const Client&)            = delete;
+    Client(Client&&)                 = delete;
+    Client& operator=(const Client&) = delete;
+    Client& operator=(Client&&)      = delete;
+
+    ~Client()
+    {
+        enet_host_destroy(m_host);
+    }
+
+    void connect(std::uint32_t version)
+    {
+        ENetAddress address{};
+        REQUIRE(enet_address_set_host_ip(&address, "127.0.0.1") == 0);
+        address.port = PORT;
+        m_peer       = enet_host_connect(m_host, &address, Host::CreateInfo::DEFAULT_CHANNELS, version);
+        REQUIRE(m_peer != nullptr);
+        enet_peer_ping_interval(m_peer, PING_INTERVAL); // pings would wake the workers
+    }
+
+    void send(std::uint8_t channel, std::size_t length)
+    {
+        std::vector<std::uint8_t> data(length);
+        for (std::size_t i = 0; i < length; ++i) {
+            data[i] = static_cast<std::uint8_t>(i);
+        }
+        REQUIRE(enet_peer_send(m_peer, channel, enet_packet_create(data.data(), length, ENET_PACKET_FLAG_RELIABLE)) == 0);
+    }
+
+    void service()
+    {
+        ENetEvent event;
+        while (enet_host_service(m_host, &event, 0) > 0) {
+            switch (event.type) {
+                case ENET_EVENT_TYPE_CONNECT:
+                    connected = true;
+                    break;
+                case ENET_EVENT_TYPE_DISCONNECT:
+                    disconnected = event.data;
+                    break;
+                case ENET_EVENT_TYPE_RECEIVE:
+                    receives.push_back({{event.packet->data, event.packet->data + event.packet->dataLength}, event.channelID});
+                    enet_packet_destroy(event.packet);
+                    break;
+                case ENET_EVENT_TYPE_NONE:
+                    break;
+            }
+        }
+    }
+
+    [[nodiscard]]
+    std::uint32_t datagrams() const noexcept
+    {
+        return m_host->totalReceivedPackets;
+    }
+
+    bool                         connected{false};
+    std::optional<std::uint32_t> disconnected;
+    std::vector<Receive>         receives;
+
+private:
+
+    ENetHost* m_host;
+    ENetPeer* m_peer{nullptr};
+};
+
+///
+/// @brief Event popped from the workers (packet data copied)
+///
+///
+struct Event {
+    NetworkEvent              event;
+    std::vector<std::uint8_t> data;
+    bool                      inline_payload;
+};
+
+///
+/// @brief Service client and drain the workers until condition holds
+///
+/// @return false on timeout
+///
+template <typename Condition>
+bool wait_for(NetworkWorkerGroup& group, Client& client, std::vector<Event>& events, Condition&& condition)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        client.service();
+        group.drain([&events](const NetworkEvent& event) {
+            auto bytes = event.bytes();
+            events.push_back({event, {bytes.begin(), bytes.end()}, event.packet == nullptr});
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    return true;
+}
+
+std::size_t count(const std::vector<Event>& events, NetworkEvent::Type type)
+{
+    return static_cast<std::size_t>(std::ranges::count_if(events, [type](const Event& event) { return event.event.type == type; }));
+}
+
+} // namespace
+
+TEST_CASE("NetworkWorkerGroup hands peers to the simulation thread as handles")
+{
+    NetworkWorkerGroup::CreateInfo config;
+    config.host.port = PORT;
+    NetworkWorkerGroup group{config};
+    REQUIRE(group.valid());
+
+    Client             client;
+    std::vector<Event> events;
+    client.connect(3);
+    REQUIRE(wait_for(group, client, events, [&] { return client.connected && count(events, NetworkEvent::Type::CONNECT) == 1; }));
+
+    const auto connect = events.front().event;
+    CHECK(connect.data == 3);
+    CHECK(connect.channel == Host::CreateInfo::DEFAULT_CHANNELS);
+    CHECK(connect.address.port != 0);
+
+    // the link state is published before the connect event
+    auto link = group.link(connect.source);
+    REQUIRE(link.has_value());
+    CHECK(link->connectID == connect.source.connectID);
+    CHECK(link->fragmentLength > 0);
+    CHECK_FALSE(group.link({connect.source.worker, connect.source.peer, connect.source.connectID + 1}).has_value());
+
+    SUBCASE("received packets are copied inline or handed over")
+    {
+        client.send(0, NetworkEvent::INLINE_SIZE);
+        client.send(1, NetworkEvent::INLINE_SIZE + 1);
+        REQUIRE(wait_for(group, client, events, [&] { return count(events, NetworkEvent::Type::RECEIVE) == 2; }));
+
+        for (const auto& received : events) {
+            if (received.event.type != NetworkEvent::Type::RECEIVE) {
+                continue;
+            }
+            CHECK(received.event.source.connectID == connect.source.connectID);
+            CHECK(received.event.length == received.data.size());
+            CHECK(received.event.packetType == 0);
+            CHECK(received.inline_payload == (received.data.size() <= NetworkEvent::INLINE_SIZE));
+            CHECK(received.event.channel == (received.inline_payload ? 0 : 1));
+            for (std::size_t i = 0; i < received.data.size(); ++i) {
+                CHECK(received.data[i] == static_cast<std::uint8_t>(i));
+            }
+        }
+    }
+
+    SUBCASE("a packet queued for a live and a gone connection reaches the live one")
+    {
+        const std::uint8_t data[] = {1, 2, 3, 4, 5};
+        auto*              packet = enet_packet_create(data, sizeof(data), ENET_PACKET_FLAG_RELIABLE);
+        group.send({connect.source.worker, connect.source.peer, connect.source.connectID + 1}, 0, packet);
+        group.send(connect.source, 1, packet);
+        group.flush();
+
+        REQUIRE(wait_for(group, client, events, [&] { return client.receives.size() == 1; }));
+        CHECK(client.receives.front().channel == 1);
+        CHECK(client.receives.front().data == std::vector<std::uint8_t>(std::begin(data), std::end(data)));
+
+        // sent data counts for the live connection only
+        REQUIRE(wait_for(group, client, events, [&] {
+            auto current = group.link(connect.source);
+            return current && current->channels[1].sent == sizeof(data) && current->channels[1].commands == 0;
+        }));
+        CHECK(group.link(connect.source)->channels[0].sent == 0);
+    }
+
+    SUBCASE("a disconnected peer is reported with the same handle")
+    {
+        group.disconnect(connect.source, DisconnectReason::KICKED);
+        group.flush();
+
+        REQUIRE(wait_for(group, client, events, [&] { return client.disconnected.has_value() && count(events, NetworkEvent::Type::DISCONNECT) == 1; }));
+        CHECK(*client.disconnected == static_cast<std::uint32_t>(DisconnectReason::KICKED));
+
+        auto disconnect = std::ranges::find_if(events, [](const Event& event) { return event.event.type == NetworkEvent::Type::DISCONNECT; });
+        CHECK(disconnect->event.source.peer == connect.source.peer);
+        CHECK(disconnect->event.source.connectID == connect.source.connectID);
+        CHECK(disconnect->event.address.port == connect.address.port);
+        CHECK_FALSE(group.link(connect.source).has_value());
+    }
+}
+
+TEST_CASE("NetworkWorkerGroup sends a tick in one datagram as soon as the tick ends")
+{
+    NetworkWorkerGroup::CreateInfo config;
+    config.host.port    = PORT;
+    config.host.timeout = 2000; // the worker sleeps, only the flush can wake it up in time
+    NetworkWorkerGroup group{config};
+    REQUIRE(group.valid());
+
+    Client             client;
+    std::vector<Event> events;
+    client.connect(3);
+    REQUIRE(wait_for(group, client, events, [&] { return client.connected && count(events, NetworkEvent::Type::CONNECT) == 1; }));
+    const auto source = events.front().event.source;
+
+    // acknowledgements of the handshake settle
+    auto settled = std::chrono::steady_clock::now() + std::chrono::milliseconds{50};
+    REQUIRE(wait_for(group, client, events, [&] { return std::chrono::steady_clock::now() > settled; }));
+
+    const std::uint8_t data[] = {1, 2, 3};
+    for (std::uint8_t channel = 0; channel < Host::CreateInfo::DEFAULT_CHANNELS; ++channel) {
+        group.send(source, channel, enet_packet_create(data, sizeof(data), ENET_PACKET_FLAG_RELIABLE));
+    }
+
+    // nothing leaves before the tick ends
+    auto staged = std::chrono::steady_clock::now() + std::chrono::milliseconds{20};
+    REQUIRE(wait_for(group, client, events, [&] { return std::chrono::steady_clock::now() > staged; }));
+    CHECK(client.receives.empty());
+
+    auto datagrams = client.datagrams();
+    auto start     = std::chrono::steady_clock::now();
+    group.flush();
+    REQUIRE(wait_for(group, client, events, [&] { return client.receives.size() == Host::CreateInfo::DEFAULT_CHANNELS; }));
+
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::milliseconds{config.host.timeout / 10});
+    CHECK(client.datagrams() - datagrams == 1);
+}
+
+} // namespace cxxserver::tests
@@ -0,0 +1,144 @@
+#include "cxxserver/PacketAllocator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <doctest_fwd.h>
+#include <enet/enet.h>
+#include <thread>
+#include <vector>
+
+namespace cxxserver::tests {
+
+namespace {
+
+static_assert(PacketAllocator::size_class(1) == 0);
+static_assert(PacketAllocator::size_class(PacketAllocator::MIN_BLOCK_SIZE) == 0);
+static_assert(PacketAllocator::size_class(PacketAllocator::MIN_BLOCK_SIZE + 1) == 1);
+static_assert(PacketAllocator::size_class(PacketAllocator::MAX_BLOCK_SIZE) == PacketAllocator::NUM_SIZE_CLASSES - 1);
+static_assert(PacketAllocator::size_class(PacketAllocator::MAX_BLOCK_SIZE + 1) == PacketAllocator::NUM_SIZE_CLASSES);
+
+///
+/// @brief Memory released when the thread exits
+///
+/// Created before the first allocation of the thread, so it is destroyed after the thread cache.
+///
+struct ExitRelease {
+    ExitRelease() = default;
+
+    ExitRelease(const ExitRelease&)            = delete;
+    ExitRelease(ExitRelease&&)                 = delete;
+    ExitRelease& operator=(const ExitRelease&) = delete;
+    ExitRelease& operator=(ExitRelease&&)      = delete;
+
+    ~ExitRelease()
+    {
+        for (auto* memory : blocks) {
+            PacketAllocator::deallocate(memory);
+        }
+        PacketAllocator::deallocate(PacketAllocator::allocate(100));
+    }
+
+    std::vector<void*> blocks;
+};
+
+} // namespace
+
+TEST_CASE("PacketAllocator serves every size class and falls back to the heap")
+{
+    const std::vector<std::size_t> sizes{1,
+                                         PacketAllocator::MIN_BLOCK_SIZE,
+                                         PacketAllocator::MIN_BLOCK_SIZE + 1,
+                                         769,
+                                         PacketAllocator::MAX_BLOCK_SIZE,
+                                         PacketAllocator::MAX_BLOCK_SIZE + 1};
+
+    auto before = PacketAllocator::stats();
+
+    std::vector<void*> blocks;
+    for (auto size : sizes) {
+        auto* memory = PacketAllocator::allocate(size);
+        REQUIRE(memory != nullptr);
+        CHECK(reinterpret_cast<std::uintptr_t>(memory) % alignof(std::max_align_t) == 0);
+        std::memset(memory, 0xA5, size);
+        blocks.push_back(memory);
+    }
+    for (auto* memory : blocks) {
+        PacketAllocator::deallocate(memory);
+    }
+    PacketAllocator::deallocate(nullptr);
+
+    // a released block is handed out again
+    auto* again = PacketAllocator::allocate(PacketAllocator::MIN_BLOCK_SIZE + 1);
+    CHECK(again == blocks[2]);
+    PacketAllocator::deallocate(again);
+
+    auto after = PacketAllocator::stats();
+    CHECK(after.allocations - before.allocations == sizes.size() + 1);
+    CHECK(after.deallocations - before.deallocations == sizes.size() + 1);
+    CHECK(after.heapFallbacks - before.heapFallbacks == 1);
+}
+
+TEST_CASE("PacketAllocator warms the cache of every thread")
+{
+    REQUIRE(PacketAllocator::install());
+
+    // all template packets of a thread are served without carving slabs
+    auto allocate_templates = [] {
+        std::vector<void*> blocks;
+        for (std::size_t i = 0; i < PacketAllocator::TEMPLATE_COUNT; ++i) {
+            for (auto size : PacketAllocator::TEMPLATE_SIZES) {
+                blocks.push_back(PacketAllocator::allocate(sizeof(ENetPacket)));
+                blocks.push_back(PacketAllocator::allocate(size));
+            }
+        }
+        return blocks;
+    };
+
+    std::uint64_t warmed = 0;
+    std::uint64_t cold   = 0;
+    std::thread{[&] {
+        PacketAllocator::warm_thread();
+        auto before = PacketAllocator::stats();
+        auto blocks = allocate_templates();
+        warmed      = PacketAllocator::stats().slabRefills - before.slabRefills;
+        for (auto* memory : blocks) {
+            PacketAllocator::deallocate(memory);
+        }
+    }}.join();
+
+    // without warm_thread the cache is warmed by the first allocation
+    std::thread{[&] {
+        PacketAllocator::deallocate(PacketAllocator::allocate(1));
+        auto before = PacketAllocator::stats();
+        auto blocks = allocate_templates();
+        cold        = PacketAllocator::stats().slabRefills - before.slabRefills;
+        for (auto* memory : blocks) {
+            PacketAllocator::deallocate(memory);
+        }
+    }}.join();
+
+    CHECK(warmed == 0);
+    CHECK(cold == 0);
+}
+
+TEST_CASE("PacketAllocator takes memory released after the thread cache was destroyed")
+{
+    auto before = PacketAllocator::stats();
+    std::thread{[] {
+        thread_local ExitRelease release;
+        release.blocks.push_back(PacketAllocator::allocate(64));
+        release.blocks.push_back(PacketAllocator::allocate(PacketAllocator::MAX_BLOCK_SIZE * 2));
+    }}.join();
+    auto after = PacketAllocator::stats();
+
+    CHECK(after.allocations - before.allocations == 3);
+    CHECK(after.deallocations - before.deallocations == 3);
+
+    // blocks of the shared pool are served to other threads
+    auto* memory = PacketAllocator::allocate(64);
+    CHECK(memory != nullptr);
+    PacketAllocator::deallocate(memory);
+}
+
+} // namespace cxxserver::tests
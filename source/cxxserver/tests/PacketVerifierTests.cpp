@@ -0,0 +1,110 @@
+#include "cxxserver/old/protocol.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <doctest_fwd.h>
+#include <vector>
+
+namespace cxxserver::tests {
+
+namespace {
+
+using spadesx::packet_dispatcher;
+using spadesx::packet_type;
+using spadesx::packet_verifier;
+
+///
+/// @brief Received packet of type and length (zero filled)
+///
+///
+struct TestPacket {
+    TestPacket(std::uint8_t type, std::size_t length)
+        : bytes(length)
+    {
+        if (length != 0) {
+            bytes[0] = type;
+        }
+        packet.data       = bytes.data();
+        packet.dataLength = bytes.size();
+    }
+
+    TestPacket(packet_type type, std::size_t length)
+        : TestPacket{static_cast<std::uint8_t>(type), length}
+    { }
+
+    [[nodiscard]]
+    Packet get() const noexcept
+    {
+        return {nullptr, &packet};
+    }
+
+    std::vector<std::uint8_t> bytes;
+    ENetPacket                packet{};
+};
+
+constexpr std::size_t POSITION_SIZE = spadesx::packets::position_data::layout::min_size;
+constexpr std::size_t EXISTING_SIZE = spadesx::packets::existing_player::layout::min_size;
+
+HandlerResult reject(void* context, const Packet& /*packet*/)
+{
+    ++*static_cast<int*>(context);
+    return HandlerResult::NOT_ALLOWED;
+}
+
+HandlerResult accept(void* context, const Packet& /*packet*/)
+{
+    ++*static_cast<int*>(context);
+    return HandlerResult::VALID;
+}
+
+} // namespace
+
+TEST_CASE("packet_verifier lets only the existing player packet through while connecting")
+{
+    packet_dispatcher dispatcher{packet_verifier{}};
+
+    CHECK(dispatcher.dispatch(ConnectionState::CONNECTING, TestPacket{packet_type::existing_player, EXISTING_SIZE}.get()) == HandlerResult::VALID);
+    CHECK(dispatcher.dispatch(ConnectionState::CONNECTING, TestPacket{packet_type::existing_player, EXISTING_SIZE - 1}.get()) ==
+          HandlerResult::INVALID_LENGTH);
+    CHECK(dispatcher.dispatch(ConnectionState::CONNECTING, TestPacket{packet_type::position_data, POSITION_SIZE}.get()) == HandlerResult::NOT_ALLOWED);
+    CHECK(dispatcher.dispatch(ConnectionState::CONNECTING, TestPacket{0, 0}.get()) == HandlerResult::NOT_ALLOWED);
+
+    CHECK(dispatcher.count(HandlerResult::VALID) == 1);
+    CHECK(dispatcher.count(static_cast<std::uint8_t>(packet_type::existing_player), HandlerResult::INVALID_LENGTH) == 1);
+}
+
+TEST_CASE("packet_verifier checks the length of every client packet once joined")
+{
+    packet_dispatcher dispatcher{packet_verifier{}};
+
+    CHECK(dispatcher.dispatch(ConnectionState::JOINED, TestPacket{packet_type::position_data, POSITION_SIZE}.get()) == HandlerResult::VALID);
+    CHECK(dispatcher.dispatch(ConnectionState::JOINED, TestPacket{packet_type::position_data, POSITION_SIZE + 1}.get()) == HandlerResult::INVALID_LENGTH);
+    CHECK(dispatcher.dispatch(ConnectionState::JOINED, TestPacket{packet_type::existing_player, EXISTING_SIZE}.get()) == HandlerResult::VALID);
+
+    // server packets and unknown types have no built-in handling
+    CHECK(dispatcher.dispatch(ConnectionState::JOINED, TestPacket{packet_type::world_update, 1}.get()) == HandlerResult::NOT_ALLOWED);
+    CHECK(dispatcher.dispatch(ConnectionState::JOINED, TestPacket{0xF0, 4}.get()) == HandlerResult::NOT_ALLOWED);
+}
+
+TEST_CASE("registered handlers run after the length check and can drop packets")
+{
+    packet_dispatcher dispatcher{packet_verifier{}};
+
+    int rejected = 0;
+    int accepted = 0;
+    dispatcher.register_handler(ConnectionState::JOINED, static_cast<std::uint8_t>(packet_type::position_data), {&reject, &rejected});
+    dispatcher.register_handler(ConnectionState::JOINED, 0xF0, {&accept, &accepted});
+
+    CHECK(dispatcher.dispatch(ConnectionState::JOINED, TestPacket{packet_type::position_data, POSITION_SIZE + 1}.get()) == HandlerResult::INVALID_LENGTH);
+    CHECK(rejected == 0);
+    CHECK(dispatcher.dispatch(ConnectionState::JOINED, TestPacket{packet_type::position_data, POSITION_SIZE}.get()) == HandlerResult::NOT_ALLOWED);
+    CHECK(rejected == 1);
+
+    // custom packet types only need a registered handler
+    CHECK(dispatcher.dispatch(ConnectionState::JOINED, TestPacket{0xF0, 4}.get()) == HandlerResult::VALID);
+    CHECK(accepted == 1);
+    CHECK(dispatcher.dispatch(ConnectionState::CONNECTING, TestPacket{0xF0, 4}.get()) == HandlerResult::NOT_ALLOWED);
+    CHECK(accepted == 1);
+}
+
+} // namespace cxxserver::tests
@@ -0,0 +1,169 @@
+#include "cxxserver/old/data/player_store.hxx"
+#include "cxxserver/tests/TestMap.hpp"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <doctest_fwd.h>
+#include <random>
+#include <vector>
+
+namespace cxxserver::tests {
+
+namespace {
+
+using spadesx::player_data;
+using spadesx::player_store;
+
+constexpr float DELTA = 1.F / 60.F;
+
+bool same_bits(const glm::vec3& lhs, const glm::vec3& rhs)
+{
+    return std::bit_cast<std::uint32_t>(lhs.x) == std::bit_cast<std::uint32_t>(rhs.x) &&
+           std::bit_cast<std::uint32_t>(lhs.y) == std::bit_cast<std::uint32_t>(rhs.y) &&
+           std::bit_cast<std::uint32_t>(lhs.z) == std::bit_cast<std::uint32_t>(rhs.z);
+}
+
+///
+/// @brief Random player around the obstacles of the test map
+///
+///
+player_data random_player(std::uint8_t id, std::mt19937& generator)
+{
+    std::uniform_real_distribution<float> area{TestMap::CENTER - TestMap::EXTENT + 2.F, TestMap::CENTER + TestMap::EXTENT - 2.F};
+    std::uniform_real_distribution<float> height{TestMap::GROUND_Z - 8.F, TestMap::GROUND_Z - 1.F};
+    std::uniform_real_distribution<float> speed{-0.5F, 0.5F};
+    std::uniform_real_distribution<float> fall{-0.4F, 0.9F};
+    std::uniform_real_distribution<float> axis{-1.F, 1.F};
+    std::bernoulli_distribution           coin;
+
+    player_data player{id};
+    player.m_position    = {area(generator), area(generator), height(generator)};
+    player.m_velocity    = {speed(generator), speed(generator), fall(generator)};
+    player.m_orientation = {axis(generator), axis(generator), axis(generator)};
+    if (glm::abs(player.m_orientation.x) + glm::abs(player.m_orientation.y) < 0.1F) {
+        player.m_orientation.x = 1.F;
+    }
+    player.m_alive     = coin(generator) || coin(generator);
+    player.m_tool      = coin(generator) ? spadesx::tool_type::gun : spadesx::tool_type::spade;
+    player.m_wade      = coin(generator) && coin(generator);
+    player.m_gliding   = coin(generator);
+    player.m_crouching = coin(generator) && coin(generator);
+    return player;
+}
+
+///
+/// @brief Random inputs of a step
+///
+///
+void random_input(player_data& player, std::mt19937& generator)
+{
+    std::bernoulli_distribution coin;
+    player.m_up        = coin(generator);
+    player.m_down      = coin(generator);
+    player.m_left      = coin(generator);
+    player.m_right     = coin(generator);
+    player.m_sprint    = coin(generator);
+    player.m_secondary = coin(generator);
+    player.m_jumping   = coin(generator) && coin(generator);
+}
+
+} // namespace
+
+TEST_CASE("player_store moves awake players bit exact with player_data::move_player")
+{
+    constexpr std::size_t ROUNDS = 32;
+    constexpr std::size_t STEPS  = player_store::rest_steps - 1; // nobody can fall asleep
+
+    auto         map = TestMap::create();
+    std::mt19937 generator{34};
+
+    for (std::size_t round = 0; round < ROUNDS; ++round) {
+        std::vector<player_data> expected;
+        std::vector<player_data> actual;
+        for (std::size_t id = 0; id < player_store::max_players; ++id) {
+            expected.push_back(random_player(static_cast<std::uint8_t>(id), generator));
+            actual.push_back(expected.back());
+        }
+
+        player_store                               store;
+        std::array<int, player_store::max_players> damage{};
+        for (std::size_t step = 0; step < STEPS; ++step) {
+            for (std::size_t id = 0; id < player_store::max_players; ++id) {
+                random_input(expected[id], generator);
+                actual[id] = expected[id]; // both were checked to be bit exact after the last step
+                store.load(id, actual[id]);
+            }
+
+            store.move(*map, DELTA, 0, player_store::max_players, damage);
+
+            for (std::size_t id = 0; id < player_store::max_players; ++id) {
+                if (!expected[id].m_alive) {
+                    continue;
+                }
+                CAPTURE(round);
+                CAPTURE(step);
+                CAPTURE(id);
+                int reference = expected[id].move_player(*map, DELTA);
+                store.store(id, actual[id]);
+                CHECK(damage[id] == reference);
+                CHECK(same_bits(actual[id].m_position, expected[id].m_position));
+                CHECK(same_bits(actual[id].m_velocity, expected[id].m_velocity));
+                CHECK(actual[id].m_wade == expected[id].m_wade);
+                CHECK(actual[id].m_gliding == expected[id].m_gliding);
+                CHECK(actual[id].m_jumping == expected[id].m_jumping);
+            }
+        }
+    }
+}
+
+TEST_CASE("player_store drops the residual velocity of players falling asleep")
+{
+    constexpr std::size_t MAX_STEPS = 600;
+
+    auto map = TestMap::create();
+
+    player_data expected{0};
+    expected.m_position    = {100.5F, 100.5F, TestMap::GROUND_Z - 4.F};
+    expected.m_velocity    = {player_store::rest_speed / 2.F, 0.F, 0.F};
+    expected.m_orientation = {1.F, 0.F, 0.F};
+    expected.m_alive       = true;
+    player_data actual     = expected;
+
+    player_store                               store;
+    std::array<int, player_store::max_players> damage{};
+
+    std::size_t step = 0;
+    for (; step < MAX_STEPS && !store.asleep(0, actual); ++step) {
+        store.load(0, actual);
+        store.move(*map, DELTA, 0, 1, damage);
+        store.store(0, actual);
+        expected.move_player(*map, DELTA);
+
+        if ((store.flags(0) & player_store::sleeping) == 0) {
+            REQUIRE(same_bits(actual.m_position, expected.m_position));
+            REQUIRE(same_bits(actual.m_velocity, expected.m_velocity));
+        }
+    }
+    REQUIRE(step < MAX_STEPS);
+
+    // the step putting the player to sleep zeroes the horizontal velocity, move_player keeps it
+    CHECK(same_bits(actual.m_position, expected.m_position));
+    CHECK(actual.m_velocity.x == 0.F);
+    CHECK(actual.m_velocity.y == 0.F);
+    CHECK(actual.m_velocity.z == expected.m_velocity.z);
+    CHECK(expected.m_velocity.x != 0.F);
+
+    // asleep players are skipped, store is not called for them
+    auto position = actual.m_position;
+    store.move(*map, DELTA, 0, 1, damage);
+    CHECK(store.asleep(0, actual));
+    CHECK(same_bits(actual.m_position, position));
+
+    // input wakes the player up
+    actual.m_up = true;
+    CHECK_FALSE(store.asleep(0, actual));
+}
+
+} // namespace cxxserver::tests
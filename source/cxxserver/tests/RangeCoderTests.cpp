@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <doctest_fwd.h>
+#include <enet/enet.h>
+#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+extern "C" {
+void*  reference_range_coder_create();
+void   reference_range_coder_destroy(void* context);
+size_t reference_range_coder_compress(void* context, const ENetBuffer* inBuffers, size_t inBufferCount, size_t inLimit, enet_uint8* outData, size_t outLimit);
+size_t reference_range_coder_decompress(void* context, const enet_uint8* inData, size_t inLimit, enet_uint8* outData, size_t outLimit);
+}
+
+namespace cxxserver::tests {
+
+namespace {
+
+using Bytes = std::vector<std::uint8_t>;
+
+///
+/// @brief Range coder of ENet (current or reference)
+///
+///
+class Coder {
+public:
+
+    using Compress   = size_t (*)(void*, const ENetBuffer*, size_t, size_t, enet_uint8*, size_t);
+    using Decompress = size_t (*)(void*, const enet_uint8*, size_t, enet_uint8*, size_t);
+
+    Coder(void* context, void (*destroy)(void*), Compress compress, Decompress decompress)
+        : m_context{context}
+        , m_destroy{destroy}
+        , m_compress{compress}
+        , m_decompress{decompress}
+    { }
+
+    Coder(const Coder&)            = delete;
+    Coder(Coder&&)                 = delete;
+    Coder& operator=(const Coder&) = delete;
+    Coder& operator=(Coder&&)      = delete;
+
+    ~Coder()
+    {
+        m_destroy(m_context);
+    }
+
+    static Coder current()
+    {
+        return {enet_range_coder_create(), &enet_range_coder_destroy, &enet_range_coder_compress, &enet_range_coder_decompress};
+    }
+
+    static Coder reference()
+    {
+        return {reference_range_coder_create(), &reference_range_coder_destroy, &reference_range_coder_compress, &reference_range_coder_decompress};
+    }
+
+    Bytes compress(const std::vector<ENetBuffer>& buffers, std::size_t length, std::size_t limit)
+    {
+        Bytes output(limit);
+        output.resize(m_compress(m_context, buffers.data(), buffers.size(), length, output.data(), limit));
+        return output;
+    }
+
+    Bytes decompress(const Bytes& input, std::size_t limit)
+    {
+        Bytes output(limit);
+        output.resize(m_decompress(m_context, input.data(), input.size(), output.data(), limit));
+        return output;
+    }
+
+private:
+
+    void*      m_context;
+    void       (*m_destroy)(void*);
+    Compress   m_compress;
+    Decompress m_decompress;
+};
+
+enum class Payload { RANDOM, RUNS, TEXT, FLOATS };
+
+///
+/// @brief Generate payload (never empty)
+///
+///
+Bytes make_payload(Payload kind, std::size_t length, std::mt19937& generator)
+{
+    static constexpr std::string_view WORDS[] = {"spades ", "grenade ", "intel ", "base ", "the ", "blue ", "green ", "team ", "captured ", "!", "\n"};
+
+    std::uniform_int_distribution<int> byte{0, 255};
+    Bytes                              payload;
+    payload.reserve(length);
+    switch (kind) {
+        case Payload::RANDOM:
+            while (payload.size() < length) {
+                payload.push_back(static_cast<std::uint8_t>(byte(generator)));
+            }
+            break;
+        case Payload::RUNS:
+            // long runs of few values, like map columns and mostly empty updates
+            while (payload.size() < length) {
+                auto value = static_cast<std::uint8_t>(byte(generator) % 4 == 0 ? byte(generator) : 0);
+                auto run   = std::uniform_int_distribution<std::size_t>{1, 200}(generator);
+                payload.insert(payload.end(), std::min(run, length - payload.size()), value);
+            }
+            break;
+        case Payload::TEXT:
+            while (payload.size() < length) {
+                auto word = WORDS[std::uniform_int_distribution<std::size_t>{0, std::size(WORDS) - 1}(generator)];
+                payload.insert(payload.end(), word.begin(), word.begin() + std::min(word.size(), length - payload.size()));
+            }
+            break;
+        case Payload::FLOATS:
+            // positions of a world update
+            while (payload.size() < length) {
+                auto         value = static_cast<float>(std::uniform_int_distribution<int>{0, 20000}(generator)) / 37.F;
+                std::uint8_t bytes[sizeof(float)];
+                std::memcpy(bytes, &value, sizeof(float));
+                payload.insert(payload.end(), bytes, bytes + std::min(sizeof(float), length - payload.size()));
+            }
+            break;
+    }
+    return payload;
+}
+
+///
+/// @brief Split payload into up to four non-empty buffers
+///
+///
+std::vector<ENetBuffer> split(Bytes& payload, std::mt19937& generator)
+{
+    std::vector<ENetBuffer> buffers;
+    auto                    parts  = std::uniform_int_distribution<std::size_t>{1, 4}(generator);
+    std::size_t             offset = 0;
+    while (offset < payload.size()) {
+        auto left   = payload.size() - offset;
+        auto length = buffers.size() + 1 == parts ? left : std::uniform_int_distribution<std::size_t>{1, left}(generator);
+        buffers.push_back({payload.data() + offset, length});
+        offset += length;
+    }
+    return buffers;
+}
+
+std::size_t random_length(std::mt19937& generator)
+{
+    // mostly datagram sized, sometimes larger than the symbol pool resets
+    return std::bernoulli_distribution{0.2}(generator) ? std::uniform_int_distribution<std::size_t>{1, 20000}(generator)
+                                                       : std::uniform_int_distribution<std::size_t>{1, 1400}(generator);
+}
+
+} // namespace
+
+TEST_CASE("range coder output matches the reference coder")
+{
+    constexpr std::size_t ROUNDS = 500;
+
+    auto         current   = Coder::current();
+    auto         reference = Coder::reference();
+    std::mt19937 generator{49};
+
+    for (auto kind : {Payload::RANDOM, Payload::RUNS, Payload::TEXT, Payload::FLOATS}) {
+        CAPTURE(static_cast<int>(kind));
+        std::size_t mismatches = 0;
+        std::size_t failures   = 0;
+        for (std::size_t round = 0; round < ROUNDS; ++round) {
+            auto payload = make_payload(kind, random_length(generator), generator);
+            auto buffers = split(payload, generator);
+
+            // enough space, or truncated so compression may fail (returns 0) on the same byte
+            auto limit = std::bernoulli_distribution{0.25}(generator) ? std::uniform_int_distribution<std::size_t>{0, payload.size()}(generator)
+                                                                      : payload.size() + payload.size() / 2 + 16;
+            auto expected = reference.compress(buffers, payload.size(), limit);
+            auto actual   = current.compress(buffers, payload.size(), limit);
+            mismatches    += actual != expected ? 1 : 0;
+            if (actual.empty()) {
+                continue;
+            }
+
+            // round trip, also into an output limit cut short
+            auto output = current.decompress(actual, payload.size());
+            failures    += output != payload || reference.decompress(actual, payload.size()) != payload ? 1 : 0;
+
+            auto short_limit = std::uniform_int_distribution<std::size_t>{0, payload.size()}(generator);
+            mismatches       += current.decompress(actual, short_limit) != reference.decompress(actual, short_limit) ? 1 : 0;
+        }
+        CHECK(mismatches == 0);
+        CHECK(failures == 0);
+    }
+}
+
+TEST_CASE("range coder decodes malformed input like the reference coder or rejects it")
+{
+    constexpr std::size_t ROUNDS = 2000;
+
+    auto         current   = Coder::current();
+    auto         reference = Coder::reference();
+    std::mt19937 generator{49};
+
+    std::size_t mismatches = 0;
+    for (std::size_t round = 0; round < ROUNDS; ++round) {
+        auto input  = make_payload(Payload::RANDOM, std::uniform_int_distribution<std::size_t>{1, 1400}(generator), generator);
+        auto actual = current.decompress(input, 1500);
+        mismatches  += !actual.empty() && actual != reference.decompress(input, 1500) ? 1 : 0;
+    }
+    CHECK(mismatches == 0);
+}
+
+// run with --test-case="range coder throughput" --no-skip
+TEST_CASE("range coder throughput" * doctest::skip())
+{
+    constexpr std::size_t      ROUNDS      = 512;
+    constexpr std::size_t      REPETITIONS = 15; // the fastest one is reported
+    constexpr std::size_t      PAYLOADS    = 64; // distinct packets, a repeated one trains the branch predictor like no real traffic does
+    constexpr std::size_t      LENGTH      = 1400;
+    constexpr std::string_view NAMES[]     = {"random", "runs", "text", "floats"};
+
+    auto         current   = Coder::current();
+    auto         reference = Coder::reference();
+    std::mt19937 generator{49};
+
+    // MB/s of the fastest repetition
+    auto rate = [](auto&& function) {
+        double best = 0.;
+        for (std::size_t repetition = 0; repetition < REPETITIONS; ++repetition) {
+            auto start = std::chrono::steady_clock::now();
+            for (std::size_t round = 0; round < ROUNDS; ++round) {
+                function(round % PAYLOADS);
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            best                                  = std::max(best, double(ROUNDS * LENGTH) / 1e6 / elapsed.count());
+        }
+        return best;
+    };
+
+    for (auto kind : {Payload::RANDOM, Payload::RUNS, Payload::TEXT, Payload::FLOATS}) {
+        std::vector<Bytes>                   payloads;
+        std::vector<std::vector<ENetBuffer>> buffers;
+        std::vector<Bytes>                   compressed;
+        std::size_t                          compressedSize = 0;
+        payloads.reserve(PAYLOADS);
+        for (std::size_t i = 0; i < PAYLOADS; ++i) {
+            payloads.push_back(make_payload(kind, LENGTH, generator));
+            buffers.push_back({{payloads.back().data(), payloads.back().size()}});
+            compressed.push_back(current.compress(buffers.back(), LENGTH, 2 * LENGTH));
+            REQUIRE(current.decompress(compressed.back(), LENGTH) == payloads.back());
+            compressedSize += compressed.back().size();
+        }
+
+        std::size_t checksum = 0;
+        auto compress        = [&](Coder& coder) { return rate([&](std::size_t i) { checksum += coder.compress(buffers[i], LENGTH, 2 * LENGTH).size(); }); };
+        auto decompress      = [&](Coder& coder) { return rate([&](std::size_t i) { checksum += coder.decompress(compressed[i], LENGTH).size(); }); };
+
+        auto reference_compress   = compress(reference);
+        auto current_compress     = compress(current);
+        auto reference_decompress = decompress(reference);
+        auto current_decompress   = decompress(current);
+        CHECK(checksum == 2 * REPETITIONS * (ROUNDS / PAYLOADS) * (compressedSize + PAYLOADS * LENGTH));
+
+        MESSAGE(NAMES[static_cast<int>(kind)], ": compress ", current_compress, " MB/s (reference ", reference_compress, "), decompress ",
+                current_decompress, " MB/s (reference ", reference_decompress, ")");
+    }
+}
+
+} // namespace cxxserver::tests
@@ -0,0 +1,176 @@
+#include "cxxserver/old/data/spatial_hash.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <doctest_fwd.h>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace cxxserver::tests {
+
+namespace {
+
+using spadesx::spatial_hash;
+
+using event = std::tuple<std::uint8_t, std::uint8_t, bool>; // entity, trigger, enter
+
+std::vector<event> take_events(spatial_hash& hash)
+{
+    std::vector<event> result;
+    for (const auto& trigger_event : hash.events()) {
+        result.emplace_back(trigger_event.entity, trigger_event.trigger, trigger_event.enter);
+    }
+    hash.clear_events();
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("spatial_hash reports entities walking through a trigger once")
+{
+    spatial_hash hash;
+    hash.set_trigger(0, {100.F, 100.F, 0.F}, 4.F);
+    hash.update(1, {90.F, 100.F, 0.F});
+    CHECK(take_events(hash).empty());
+
+    hash.update(1, {97.F, 100.F, 0.F});
+    CHECK(take_events(hash) == std::vector<event>{{1, 0, true}});
+    CHECK(hash.is_inside(1, 0));
+
+    // staying inside, even across a cell border, emits nothing
+    hash.update(1, {103.F, 100.F, 0.F});
+    CHECK(take_events(hash).empty());
+
+    hash.update(1, {105.F, 100.F, 0.F});
+    CHECK(take_events(hash) == std::vector<event>{{1, 0, false}});
+    CHECK_FALSE(hash.is_inside(1, 0));
+
+    // a removed entity leaves the trigger
+    hash.update(1, {100.F, 100.F, 0.F});
+    CHECK(take_events(hash) == std::vector<event>{{1, 0, true}});
+    hash.remove(1);
+    CHECK(take_events(hash) == std::vector<event>{{1, 0, false}});
+}
+
+TEST_CASE("spatial_hash reports entities entered and left by a moving trigger")
+{
+    spatial_hash hash;
+    hash.update(1, {100.F, 100.F, 0.F});
+    hash.update(2, {200.F, 200.F, 0.F});
+
+    hash.set_trigger(3, {101.F, 100.F, 0.F}, 2.F);
+    CHECK(take_events(hash) == std::vector<event>{{1, 3, true}});
+
+    // moved far away: the old cells no longer carry the trigger
+    hash.set_trigger(3, {200.F, 201.F, 0.F}, 2.F);
+    CHECK(take_events(hash) == std::vector<event>{{1, 3, false}, {2, 3, true}});
+    hash.update(1, {100.F, 100.5F, 0.F});
+    CHECK(take_events(hash).empty());
+
+    // moved within the same cells
+    hash.set_trigger(3, {200.F, 204.F, 0.F}, 2.F);
+    CHECK(take_events(hash) == std::vector<event>{{2, 3, false}});
+    hash.update(2, {200.F, 203.F, 0.F});
+    CHECK(take_events(hash) == std::vector<event>{{2, 3, true}});
+}
+
+TEST_CASE("spatial_hash reports entities leaving a disabled trigger")
+{
+    spatial_hash hash;
+    hash.set_trigger(0, {100.F, 100.F, 0.F}, 4.F);
+    hash.set_trigger(1, {102.F, 100.F, 0.F}, 4.F);
+    hash.update(5, {101.F, 100.F, 0.F});
+    CHECK(take_events(hash) == std::vector<event>{{5, 0, true}, {5, 1, true}});
+
+    hash.disable_trigger(0);
+    CHECK(take_events(hash) == std::vector<event>{{5, 0, false}});
+    CHECK_FALSE(hash.is_inside(5, 0));
+    CHECK(hash.is_inside(5, 1));
+
+    // a disabled trigger is ignored, disabling it again changes nothing
+    hash.update(5, {100.F, 100.F, 0.F});
+    hash.disable_trigger(0);
+    CHECK(take_events(hash).empty());
+
+    // placing it again enables it
+    hash.set_trigger(0, {100.F, 100.F, 0.F}, 4.F);
+    CHECK(take_events(hash) == std::vector<event>{{5, 0, true}});
+}
+
+TEST_CASE("spatial_hash trigger events match a brute force reference")
+{
+    constexpr std::size_t STEPS    = 4000;
+    constexpr std::size_t ENTITIES = 32;
+
+    std::mt19937 generator{38};
+
+    std::uniform_real_distribution<float> area{0.F, 64.F}; // a few cells, so triggers span borders
+    std::uniform_real_distribution<float> radius{1.F, 12.F};
+    std::uniform_real_distribution<float> stride{-3.F, 3.F};
+    std::uniform_int_distribution<int>    action{0, 19};
+    std::uniform_int_distribution<int>    entity_of{0, ENTITIES - 1};
+    std::uniform_int_distribution<int>    trigger_of{0, spatial_hash::max_triggers - 1};
+
+    spatial_hash                                      hash;
+    std::array<glm::vec3, ENTITIES>                   positions{};
+    std::array<bool, ENTITIES>                        present{};
+    std::array<std::uint8_t, ENTITIES>                inside{}; // trigger mask
+    std::array<glm::vec3, spatial_hash::max_triggers> centers{};
+    std::array<float, spatial_hash::max_triggers>     radii{};
+    std::array<bool, spatial_hash::max_triggers>      enabled{};
+
+    for (std::size_t step = 0; step < STEPS; ++step) {
+        auto entity  = static_cast<std::uint8_t>(entity_of(generator));
+        auto trigger = static_cast<std::uint8_t>(trigger_of(generator));
+        switch (action(generator)) {
+            case 0:
+                centers[trigger] = {area(generator), area(generator), 0.F};
+                radii[trigger]   = radius(generator);
+                enabled[trigger] = true;
+                hash.set_trigger(trigger, centers[trigger], radii[trigger]);
+                break;
+            case 1:
+                enabled[trigger] = false;
+                hash.disable_trigger(trigger);
+                break;
+            case 2:
+                present[entity] = false;
+                hash.remove(entity);
+                break;
+            default:
+                if (present[entity]) {
+                    positions[entity] = glm::clamp(positions[entity] + glm::vec3{stride(generator), stride(generator), 0.F}, 0.F, 64.F);
+                } else {
+                    positions[entity] = {area(generator), area(generator), 0.F};
+                    present[entity]   = true;
+                }
+                hash.update(entity, positions[entity]);
+                break;
+        }
+
+        std::vector<event> expected;
+        bool               same_inside = true;
+        for (std::uint8_t e = 0; e < ENTITIES; ++e) {
+            std::uint8_t now = 0;
+            for (std::uint8_t t = 0; t < spatial_hash::max_triggers; ++t) {
+                if (present[e] && enabled[t] && glm::distance(positions[e], centers[t]) <= radii[t]) {
+                    now |= std::uint8_t(1U << t);
+                }
+                if (((now ^ inside[e]) >> t & 1U) != 0) {
+                    expected.emplace_back(e, t, (now >> t & 1U) != 0);
+                }
+                same_inside = same_inside && hash.is_inside(e, t) == ((now >> t & 1U) != 0);
+            }
+            inside[e] = now;
+        }
+        CAPTURE(step);
+        CHECK(same_inside);
+        CHECK(take_events(hash) == expected);
+    }
+}
+
+} // namespace cxxserver::tests
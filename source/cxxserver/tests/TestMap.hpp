@@ -0,0 +1,52 @@
+#pragma once
+
+#include "cxxserver/old/map.hxx"
+
+#include <cstdint>
+#include <memory>
+
+namespace cxxserver::tests {
+
+///
+/// @brief Map used by the tests
+///
+/// Blocks from GROUND_Z down are solid everywhere. Columns around the center carry pillars one to
+/// four blocks high, so moving bodies hit walls, climb steps and land on top of them.
+///
+struct TestMap {
+    static constexpr std::uint32_t GROUND_Z = 60;  //!< Top of the ground
+    static constexpr std::uint32_t CENTER   = 256; //!< Center of the obstacle area
+    static constexpr std::uint32_t EXTENT   = 24;  //!< Half size of the obstacle area
+
+    ///
+    /// @brief Create the map
+    ///
+    /// @return Map
+    ///
+    static std::unique_ptr<spadesx::map> create()
+    {
+        auto map = std::make_unique<spadesx::map>();
+        for (std::uint32_t y = 0; y < spadesx::map::size_y; ++y) {
+            for (std::uint32_t x = 0; x < spadesx::map::size_x; ++x) {
+                for (std::uint32_t z = GROUND_Z; z < spadesx::map::size_z; ++z) {
+                    map->set_block(x, y, z, true);
+                }
+            }
+        }
+
+        for (std::uint32_t y = CENTER - EXTENT; y < CENTER + EXTENT; ++y) {
+            for (std::uint32_t x = CENTER - EXTENT; x < CENTER + EXTENT; ++x) {
+                if ((x * 7 + y * 13) % 11 != 0) {
+                    continue;
+                }
+                auto height = 1 + (x + y) % 4;
+                for (std::uint32_t z = GROUND_Z - height; z < GROUND_Z; ++z) {
+                    map->set_block(x, y, z, true);
+                }
+            }
+        }
+        return map;
+    }
+};
+
+} // namespace cxxserver::tests
@@ -0,0 +1,195 @@
+#include "cxxserver/old/data/timer_wheel.hxx"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <doctest_fwd.h>
+#include <functional>
+#include <optional>
+#include <random>
+#include <vector>
+
+namespace cxxserver::tests {
+
+namespace {
+
+using spadesx::timer_wheel;
+
+///
+/// @brief Fire times of timers scheduled at once
+///
+/// @param start Time of the schedule
+/// @param delays Delays
+/// @param step Advance step (0: a single advance past all deadlines)
+/// @return Delay of every fired timer in firing order
+///
+std::vector<std::uint64_t> fire_times(std::uint64_t start, const std::vector<std::uint64_t>& delays, std::uint64_t step)
+{
+    timer_wheel                wheel;
+    std::vector<std::uint64_t> fired;
+
+    wheel.advance(start);
+    for (auto delay : delays) {
+        wheel.schedule(delay, [&wheel, &fired, start, delay] {
+            CHECK(wheel.now() == start + delay);
+            fired.push_back(delay);
+        });
+    }
+
+    std::uint64_t end = start + timer_wheel::max_delay + 1;
+    if (step == 0) {
+        wheel.advance(end);
+    } else {
+        for (auto now = start; now < end && wheel.size() > 0; now += step) {
+            wheel.advance(now);
+        }
+    }
+    CHECK(wheel.size() == 0);
+    return fired;
+}
+
+} // namespace
+
+TEST_CASE("timer_wheel fires timers at their deadline across level boundaries")
+{
+    const std::vector<std::uint64_t> delays{4096, 63, 1, 4095, 64, 65, 262144, 262143, 4097, 2};
+    const std::vector<std::uint64_t> sorted{1, 2, 63, 64, 65, 4095, 4096, 4097, 262143, 262144};
+
+    // aligned, in the middle of a level 0 rotation and just before a level 1 wrap
+    for (std::uint64_t start : {0ULL, 70ULL, 4095ULL, 262100ULL}) {
+        CAPTURE(start);
+        for (std::uint64_t step : {0ULL, 1ULL, 7ULL, 1000ULL}) {
+            CAPTURE(step);
+            CHECK(fire_times(start, delays, step) == sorted);
+        }
+    }
+}
+
+TEST_CASE("timer_wheel clamps delays to the range of the wheel")
+{
+    timer_wheel wheel;
+    wheel.advance(1000);
+
+    std::vector<std::uint64_t> fired;
+    wheel.schedule(0, [&] { fired.push_back(wheel.now()); });
+    wheel.schedule(timer_wheel::max_delay + 12345, [&] { fired.push_back(wheel.now()); });
+    wheel.schedule(timer_wheel::max_delay, [&] { fired.push_back(wheel.now()); });
+
+    // a zero delay still waits for the next millisecond
+    wheel.advance(1000);
+    CHECK(fired.empty());
+    wheel.advance(1001);
+    CHECK(fired == std::vector<std::uint64_t>{1001});
+
+    wheel.advance(1000 + timer_wheel::max_delay - 1);
+    CHECK(fired.size() == 1);
+    wheel.advance(1000 + timer_wheel::max_delay);
+    CHECK(fired == std::vector<std::uint64_t>{1001, 1000 + timer_wheel::max_delay, 1000 + timer_wheel::max_delay});
+    CHECK(wheel.size() == 0);
+}
+
+TEST_CASE("timer_wheel callbacks cancel timers safely")
+{
+    timer_wheel         wheel;
+    std::vector<int>    fired;
+    timer_wheel::handle first;
+    timer_wheel::handle same_slot;
+    timer_wheel::handle later;
+
+    // both timers of a slot are taken out before either fires, whichever fires first cancels the other
+    first     = wheel.schedule(10, [&] {
+        fired.push_back(1);
+        CHECK_FALSE(wheel.cancel(first)); // already fired
+        wheel.cancel(same_slot);
+        CHECK(wheel.cancel(later));
+    });
+    same_slot = wheel.schedule(10, [&] {
+        fired.push_back(2);
+        wheel.cancel(first);
+        CHECK(wheel.cancel(later));
+    });
+    later     = wheel.schedule(5000, [&] { fired.push_back(3); });
+    CHECK(wheel.size() == 3);
+
+    wheel.advance(10);
+    CHECK(fired.size() == 1);
+    CHECK_FALSE(wheel.is_pending(first));
+    CHECK_FALSE(wheel.is_pending(same_slot));
+    CHECK_FALSE(wheel.is_pending(later));
+    CHECK(wheel.size() == 0);
+
+    wheel.advance(10000);
+    CHECK(fired.size() == 1);
+
+    // a callback rescheduling into its own slot fires on a later advance
+    timer_wheel::handle   again;
+    int                   count = 0;
+    std::function<void()> tick  = [&] {
+        if (++count < 3) {
+            again = wheel.schedule(0, tick);
+        }
+    };
+    again = wheel.schedule(1, tick);
+    wheel.advance(10001);
+    CHECK(count == 1);
+    wheel.advance(10005);
+    CHECK(count == 3);
+    CHECK_FALSE(wheel.is_pending(again));
+
+    // a reused node does not accept the handle of the cancelled timer
+    auto stale = wheel.schedule(100, [] {});
+    auto copy  = stale;
+    CHECK(wheel.cancel(stale));
+    auto fresh = wheel.schedule(100, [] {});
+    CHECK(fresh.index == copy.index);
+    CHECK_FALSE(wheel.cancel(copy));
+    CHECK(wheel.is_pending(fresh));
+}
+
+TEST_CASE("timer_wheel fires like a sorted reference")
+{
+    constexpr std::size_t TIMERS = 2000;
+
+    std::mt19937 generator{43};
+
+    std::uniform_int_distribution<std::uint64_t> small{0, 300};
+    std::uniform_int_distribution<std::uint64_t> large{0, 300000};
+    std::uniform_int_distribution<std::uint64_t> stride{0, 700};
+    std::bernoulli_distribution                  coin;
+    std::bernoulli_distribution                  rarely{0.05};
+
+    timer_wheel                               wheel;
+    std::vector<timer_wheel::handle>          handles;
+    std::vector<std::optional<std::uint64_t>> deadlines; // empty once fired or cancelled
+    std::uint64_t                             last   = 0;
+    std::size_t                               errors = 0;
+
+    while (handles.size() < TIMERS || wheel.size() > 0) {
+        for (int spawn = 0; spawn < 4 && handles.size() < TIMERS; ++spawn) {
+            auto delay = coin(generator) ? small(generator) : large(generator);
+            auto id    = handles.size();
+            deadlines.emplace_back(wheel.now() + std::max<std::uint64_t>(delay, 1));
+            handles.push_back(wheel.schedule(delay, [&, id] {
+                // exactly once, at its deadline, never before an earlier one
+                errors += deadlines[id] != wheel.now() || wheel.now() < last ? 1 : 0;
+                last          = wheel.now();
+                deadlines[id] = std::nullopt;
+            }));
+        }
+        if (rarely(generator) && !handles.empty()) {
+            auto id = std::uniform_int_distribution<std::size_t>{0, handles.size() - 1}(generator);
+            CHECK(wheel.cancel(handles[id]) == deadlines[id].has_value());
+            deadlines[id] = std::nullopt;
+        }
+
+        auto now = wheel.now() + stride(generator);
+        wheel.advance(now);
+        last = now;
+        for (const auto& deadline : deadlines) {
+            errors += deadline && *deadline <= now ? 1 : 0;
+        }
+    }
+    CHECK(errors == 0);
+}
+
+} // namespace cxxserver::tests
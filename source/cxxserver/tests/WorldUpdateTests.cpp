@@ -0,0 +1,153 @@
+#include "cxxserver/old/data/world_update.hxx"
+#include "cxxserver/tests/TestMap.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <doctest_fwd.h>
+#include <random>
+
+namespace cxxserver::tests {
+
+namespace {
+
+using spadesx::team_type;
+using spadesx::world_snapshot;
+using spadesx::world_update_builder;
+
+using Body = std::array<std::uint8_t, world_update_builder::body_size>;
+
+constexpr std::size_t PLAYERS = world_update_builder::max_players;
+
+world_update_builder::player_state standing(float x, float y, team_type team)
+{
+    return {{x, y, float(TestMap::GROUND_Z) - 2.F}, {1.F, 0.F, 0.F}, team, true, true};
+}
+
+bool is_zero(const Body& body, std::size_t slot)
+{
+    auto begin = body.begin() + static_cast<std::ptrdiff_t>(slot * world_update_builder::slot_size);
+    return std::all_of(begin, begin + world_update_builder::slot_size, [](std::uint8_t byte) { return byte == 0; });
+}
+
+} // namespace
+
+TEST_CASE("world_update_builder checks visibility from the eye of each viewer")
+{
+    constexpr std::size_t ROUNDS = 50;
+    constexpr float       FOG    = 40.F;
+
+    auto         map = TestMap::create();
+    std::mt19937 generator{28};
+
+    std::uniform_real_distribution<float> area{TestMap::CENTER - TestMap::EXTENT, TestMap::CENTER + TestMap::EXTENT};
+    std::uniform_real_distribution<float> height{float(TestMap::GROUND_Z) - 6.F, float(TestMap::GROUND_Z) - 1.5F};
+    std::uniform_int_distribution<int>    kind{0, 9};
+
+    world_update_builder builder;
+    builder.set_fog_distance(FOG);
+
+    std::size_t errors  = 0;
+    std::size_t one_way = 0; // enemies seen by only one of the two
+    std::size_t culled  = 0;
+    for (std::size_t round = 0; round < ROUNDS; ++round) {
+        std::array<world_update_builder::player_state, PLAYERS> players{};
+        for (std::size_t id = 0; id < PLAYERS; ++id) {
+            auto roll   = kind(generator);
+            players[id] = {{area(generator), area(generator), height(generator)},
+                           {1.F, 0.F, 0.F},
+                           roll == 0 ? team_type::spectator : (id % 2 == 0 ? team_type::a : team_type::b),
+                           roll != 1,
+                           roll != 2};
+            builder.set_player(id, players[id]);
+        }
+        builder.update(*map);
+
+        auto active = [&](std::size_t id) {
+            return players[id].alive && players[id].connected && players[id].team != team_type::spectator;
+        };
+        auto sees = [&](std::size_t viewer, std::size_t target) {
+            if (!active(viewer) || !active(target) || players[viewer].team == players[target].team) {
+                return true;
+            }
+            auto dx = players[target].position.x - players[viewer].position.x;
+            auto dy = players[target].position.y - players[viewer].position.y;
+            if (dx * dx + dy * dy > FOG * FOG) {
+                return false;
+            }
+            auto eye  = players[viewer].position;
+            auto head = players[target].position;
+            auto body = head + glm::vec3{0.F, 0.F, 1.F};
+            return !spadesx::ray::intersects(*map, eye, head) || !spadesx::ray::intersects(*map, eye, body);
+        };
+
+        for (std::size_t viewer = 0; viewer < PLAYERS; ++viewer) {
+            for (std::size_t target = 0; target < PLAYERS; ++target) {
+                bool expected = sees(viewer, target);
+                errors        += ((builder.visible(viewer) >> target & 1U) != 0) != expected ? 1 : 0;
+                one_way       += expected && !sees(target, viewer) ? 1 : 0;
+            }
+        }
+        culled += builder.visible(0) != ~0U ? 1 : 0;
+    }
+    CHECK(errors == 0);
+    CHECK(one_way > 0);
+    CHECK(culled > 0);
+}
+
+TEST_CASE("world_update_builder drops stale slots of a reused viewer slot")
+{
+    auto                 map = TestMap::create();
+    world_update_builder builder;
+    builder.set_hidden_slot(spadesx::hidden_slot_type::stale);
+    builder.set_fog_distance(8.F);
+
+    auto place = [&](float distance) {
+        builder.set_player(0, standing(100.5F, 100.5F, team_type::a));
+        builder.set_player(1, standing(100.5F + distance, 100.5F, team_type::b));
+        for (std::size_t id = 2; id < PLAYERS; ++id) {
+            builder.set_player(id, {{}, {}, team_type::spectator, false, false});
+        }
+        builder.update(*map);
+    };
+
+    Body body{};
+    place(4.F);
+    builder.build(0, body.data());
+    CHECK_FALSE(is_zero(body, 1));
+
+    // out of the fog: the hidden slot keeps the last data sent
+    place(20.F);
+    REQUIRE((builder.visible(0) & 0x02U) == 0);
+    builder.build(0, body.data());
+    CHECK_FALSE(is_zero(body, 1));
+
+    // a new connection never received the slot
+    builder.reset_viewer(0);
+    builder.build(0, body.data());
+    CHECK(is_zero(body, 1));
+
+    // built from snapshots (encoder thread), the reset travels with the snapshot
+    world_snapshot snapshot;
+    place(4.F);
+    builder.store(snapshot);
+    builder.build(snapshot, 0, body.data());
+    CHECK_FALSE(is_zero(body, 1));
+
+    place(20.F);
+    builder.store(snapshot);
+    builder.build(snapshot, 0, body.data());
+    CHECK_FALSE(is_zero(body, 1));
+
+    builder.reset_viewer(0);
+    builder.build(snapshot, 0, body.data());
+    CHECK_FALSE(is_zero(body, 1)); // reset not published yet
+
+    builder.store(snapshot);
+    builder.build(snapshot, 0, body.data());
+    CHECK(is_zero(body, 1));
+    CHECK_FALSE(is_zero(body, 0));
+}
+
+} // namespace cxxserver::tests
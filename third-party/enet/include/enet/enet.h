@@ -116,6 +116,9 @@ typedef enum _ENetPacketFlag
    /** packet will be fragmented using unreliable (instead of reliable) sends
      * if it exceeds the MTU */
    ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT = (1 << 3),
+   /** packet data is not worth compressing (already compressed or random),
+     * datagrams made mostly of such data bypass the host compressor */
+   ENET_PACKET_FLAG_NO_COMPRESS = (1 << 4),
 
    /** whether the packet has been sent from all queues it has been entered into */
    ENET_PACKET_FLAG_SENT = (1<<8)
@@ -143,6 +146,9 @@ typedef void (ENET_CALLBACK * ENetPacketFreeCallback) (struct _ENetPacket *);
  *    ENET_PACKET_FLAG_UNRELIABLE_FRAGMENT - packet will be fragmented using unreliable
  *    (instead of reliable) sends if it exceeds the MTU
  *
+ *    ENET_PACKET_FLAG_NO_COMPRESS - packet data is not worth compressing, datagrams
+ *    made mostly of such data bypass the host compressor
+ *
  *    ENET_PACKET_FLAG_SENT - whether the packet has been sent from all queues it has been entered into
    @sa ENetPacketFlag
  */
@@ -379,6 +385,7 @@ typedef struct _ENetHost
    ENetList             dispatchQueue;
    enet_uint32          totalQueued;
    size_t               packetSize;
+   size_t               incompressibleSize;          /**< data of the current datagram flagged ENET_PACKET_FLAG_NO_COMPRESS */
    enet_uint16          headerFlags;
    ENetProtocol         commands [ENET_PROTOCOL_MAXIMUM_PACKET_COMMANDS];
    size_t               commandCount;
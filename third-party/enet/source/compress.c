@@ -1,4 +1,4 @@
-/** 
+/**
  @file compress.c
  @brief An adaptive order-2 PPM range coder
 */
@@ -18,7 +18,7 @@ typedef struct _ENetSymbol
     enet_uint16 symbols;
     enet_uint16 escapes;
     enet_uint16 total;
-    enet_uint16 parent; 
+    enet_uint16 parent;
 } ENetSymbol;
 
 /* adaptation constants tuned aggressively for small packet sizes rather than large file compression */
@@ -36,13 +36,19 @@ enum
     ENET_SUBCONTEXT_ESCAPE_DELTA = 5
 };
 
-/* context exclusion roughly halves compression speed, so disable for now */
-#undef ENET_CONTEXT_EXCLUSION
+/* context exclusion roughly halves compression speed and is not part of the wire format, so it is not implemented */
 
 typedef struct _ENetRangeCoder
 {
     /* only allocate enough symbols for reasonable MTUs, would need to be larger for large file compression */
     ENetSymbol symbols[4096];
+
+    /* the order-0 context keeps its counts in a binary indexed tree instead of a symbol tree, so lookups
+       take at most 8 steps whatever order the values arrived in; its symbol nodes only carry the order-1
+       contexts and are valid for values with a count */
+    enet_uint16 rootTree [257];
+    enet_uint16 rootSymbols [256];
+    enet_uint8 rootCounts [256];
 } ENetRangeCoder;
 
 void *
@@ -87,6 +93,13 @@ enet_range_coder_destroy (void * context)
     (context) -> symbols = 0; \
 }
 
+#define ENET_ROOT_CREATE(root, escapes_, minimum) \
+{ \
+    ENET_CONTEXT_CREATE (root, escapes_, minimum); \
+    memset (rangeCoder -> rootTree, 0, sizeof (rangeCoder -> rootTree)); \
+    memset (rangeCoder -> rootCounts, 0, sizeof (rangeCoder -> rootCounts)); \
+}
+
 static enet_uint16
 enet_symbol_rescale (ENetSymbol * symbol)
 {
@@ -100,7 +113,7 @@ enet_symbol_rescale (ENetSymbol * symbol)
         total += symbol -> under;
         if (! symbol -> right) break;
         symbol += symbol -> right;
-    } 
+    }
     return total;
 }
 
@@ -111,6 +124,35 @@ enet_symbol_rescale (ENetSymbol * symbol)
     (context) -> total += (context) -> escapes + 256*minimum; \
 }
 
+static enet_uint16
+enet_root_rescale (ENetRangeCoder * rangeCoder)
+{
+    enet_uint16 total = 0;
+    size_t index;
+    for (index = 0; index < 256; ++ index)
+    {
+        enet_uint8 count = rangeCoder -> rootCounts [index];
+        count -= count >> 1;
+        rangeCoder -> rootCounts [index] = count;
+        rangeCoder -> rootTree [index + 1] = count;
+        total += count;
+    }
+    for (index = 1; index < 256; ++ index)
+    {
+        size_t next = index + (index & (~ index + 1));
+        if (next <= 256)
+          rangeCoder -> rootTree [next] += rangeCoder -> rootTree [index];
+    }
+    return total;
+}
+
+#define ENET_ROOT_RESCALE(root, minimum) \
+{ \
+    (root) -> total = enet_root_rescale (rangeCoder); \
+    (root) -> escapes -= (root) -> escapes >> 1; \
+    (root) -> total += (root) -> escapes + 256*minimum; \
+}
+
 #define ENET_RANGE_CODER_OUTPUT(value) \
 { \
     if (outData >= outEnd) \
@@ -150,7 +192,7 @@ enet_symbol_rescale (ENetSymbol * symbol)
     if (nextSymbol >= sizeof (rangeCoder -> symbols) / sizeof (ENetSymbol) - ENET_SUBCONTEXT_ORDER ) \
     { \
         nextSymbol = 0; \
-        ENET_CONTEXT_CREATE (root, ENET_CONTEXT_ESCAPE_MINIMUM, ENET_CONTEXT_SYMBOL_MINIMUM); \
+        ENET_ROOT_CREATE (root, ENET_CONTEXT_ESCAPE_MINIMUM, ENET_CONTEXT_SYMBOL_MINIMUM); \
         predicted = 0; \
         order = 0; \
     } \
@@ -198,50 +240,31 @@ enet_symbol_rescale (ENetSymbol * symbol)
     } \
 }
 
-#ifdef ENET_CONTEXT_EXCLUSION
-static const ENetSymbol emptyContext = { 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-
-#define ENET_CONTEXT_WALK(context, body) \
+#define ENET_ROOT_UPDATE(symbol_, value_, count_, update, minimum) \
 { \
-    const ENetSymbol * node = (context) + (context) -> symbols; \
-    const ENetSymbol * stack [256]; \
-    size_t stackSize = 0; \
-    while (node -> left) \
+    size_t index = (size_t) (value_) + 1; \
+    count_ = rangeCoder -> rootCounts [value_] + minimum; \
+    if (! rangeCoder -> rootCounts [value_]) \
     { \
-        stack [stackSize ++] = node; \
-        node += node -> left; \
-    } \
-    for (;;) \
-    { \
-        body; \
-        if (node -> right) \
-        { \
-            node += node -> right; \
-            while (node -> left) \
-            { \
-                stack [stackSize ++] = node; \
-                node += node -> left; \
-            } \
-        } \
-        else \
-        if (stackSize <= 0) \
-            break; \
-        else \
-            node = stack [-- stackSize]; \
+        ENET_SYMBOL_CREATE (symbol_, value_, update); \
+        rangeCoder -> rootSymbols [value_] = (enet_uint16) (symbol_ - rangeCoder -> symbols); \
     } \
+    else \
+      symbol_ = & rangeCoder -> symbols [rangeCoder -> rootSymbols [value_]]; \
+    rangeCoder -> rootCounts [value_] += update; \
+    for (; index <= 256; index += index & (~ index + 1)) \
+      rangeCoder -> rootTree [index] += update; \
 }
 
-#define ENET_CONTEXT_ENCODE_EXCLUDE(context, value_, under, total, minimum) \
-ENET_CONTEXT_WALK(context, { \
-    if (node -> value != value_) \
-    { \
-        enet_uint16 parentCount = rangeCoder -> symbols [node -> parent].count + minimum; \
-        if (node -> value < value_) \
-          under -= parentCount; \
-        total -= parentCount; \
-    } \
-})
-#endif
+/* the counts below a value are the prefix sum of the binary indexed tree */
+#define ENET_ROOT_ENCODE(symbol_, value_, under_, count_, update, minimum) \
+{ \
+    size_t index = value_; \
+    under_ = value_*minimum; \
+    for (; index > 0; index &= index - 1) \
+      under_ += rangeCoder -> rootTree [index]; \
+    ENET_ROOT_UPDATE (symbol_, value_, count_, update, minimum); \
+}
 
 size_t
 enet_range_coder_compress (void * context, const ENetBuffer * inBuffers, size_t inBufferCount, size_t inLimit, enet_uint8 * outData, size_t outLimit)
@@ -262,14 +285,11 @@ enet_range_coder_compress (void * context, const ENetBuffer * inBuffers, size_t
     inBuffers ++;
     inBufferCount --;
 
-    ENET_CONTEXT_CREATE (root, ENET_CONTEXT_ESCAPE_MINIMUM, ENET_CONTEXT_SYMBOL_MINIMUM);
+    ENET_ROOT_CREATE (root, ENET_CONTEXT_ESCAPE_MINIMUM, ENET_CONTEXT_SYMBOL_MINIMUM);
 
     for (;;)
     {
         ENetSymbol * subcontext, * symbol;
-#ifdef ENET_CONTEXT_EXCLUSION
-        const ENetSymbol * childContext = & emptyContext;
-#endif
         enet_uint8 value;
         enet_uint16 count, under, * parent = & predicted, total;
         if (inData >= inEnd)
@@ -282,30 +302,23 @@ enet_range_coder_compress (void * context, const ENetBuffer * inBuffers, size_t
             inBufferCount --;
         }
         value = * inData ++;
-    
-        for (subcontext = & rangeCoder -> symbols [predicted]; 
-             subcontext != root; 
-#ifdef ENET_CONTEXT_EXCLUSION
-             childContext = subcontext, 
-#endif
-                subcontext = & rangeCoder -> symbols [subcontext -> parent])
+
+        for (subcontext = & rangeCoder -> symbols [predicted];
+             subcontext != root;
+             subcontext = & rangeCoder -> symbols [subcontext -> parent])
         {
             ENET_CONTEXT_ENCODE (subcontext, symbol, value, under, count, ENET_SUBCONTEXT_SYMBOL_DELTA, 0);
             * parent = symbol - rangeCoder -> symbols;
             parent = & symbol -> parent;
             total = subcontext -> total;
-#ifdef ENET_CONTEXT_EXCLUSION
-            if (childContext -> total > ENET_SUBCONTEXT_SYMBOL_DELTA + ENET_SUBCONTEXT_ESCAPE_DELTA)
-              ENET_CONTEXT_ENCODE_EXCLUDE (childContext, value, under, total, 0);
-#endif
             if (count > 0)
             {
                 ENET_RANGE_CODER_ENCODE (subcontext -> escapes + under, count, total);
             }
             else
             {
-                if (subcontext -> escapes > 0 && subcontext -> escapes < total) 
-                    ENET_RANGE_CODER_ENCODE (0, subcontext -> escapes, total); 
+                if (subcontext -> escapes > 0 && subcontext -> escapes < total)
+                    ENET_RANGE_CODER_ENCODE (0, subcontext -> escapes, total);
                 subcontext -> escapes += ENET_SUBCONTEXT_ESCAPE_DELTA;
                 subcontext -> total += ENET_SUBCONTEXT_ESCAPE_DELTA;
             }
@@ -315,23 +328,19 @@ enet_range_coder_compress (void * context, const ENetBuffer * inBuffers, size_t
             if (count > 0) goto nextInput;
         }
 
-        ENET_CONTEXT_ENCODE (root, symbol, value, under, count, ENET_CONTEXT_SYMBOL_DELTA, ENET_CONTEXT_SYMBOL_MINIMUM);
+        ENET_ROOT_ENCODE (symbol, value, under, count, ENET_CONTEXT_SYMBOL_DELTA, ENET_CONTEXT_SYMBOL_MINIMUM);
         * parent = symbol - rangeCoder -> symbols;
         parent = & symbol -> parent;
         total = root -> total;
-#ifdef ENET_CONTEXT_EXCLUSION
-        if (childContext -> total > ENET_SUBCONTEXT_SYMBOL_DELTA + ENET_SUBCONTEXT_ESCAPE_DELTA)
-          ENET_CONTEXT_ENCODE_EXCLUDE (childContext, value, under, total, ENET_CONTEXT_SYMBOL_MINIMUM); 
-#endif
         ENET_RANGE_CODER_ENCODE (root -> escapes + under, count, total);
-        root -> total += ENET_CONTEXT_SYMBOL_DELTA; 
+        root -> total += ENET_CONTEXT_SYMBOL_DELTA;
         if (count > 0xFF - 2*ENET_CONTEXT_SYMBOL_DELTA + ENET_CONTEXT_SYMBOL_MINIMUM || root -> total > ENET_RANGE_CODER_BOTTOM - 0x100)
-          ENET_CONTEXT_RESCALE (root, ENET_CONTEXT_SYMBOL_MINIMUM);
+          ENET_ROOT_RESCALE (root, ENET_CONTEXT_SYMBOL_MINIMUM);
 
     nextInput:
-        if (order >= ENET_SUBCONTEXT_ORDER) 
+        if (order >= ENET_SUBCONTEXT_ORDER)
           predicted = rangeCoder -> symbols [predicted].parent;
-        else 
+        else
           order ++;
         ENET_RANGE_CODER_FREE_SYMBOLS;
     }
@@ -343,9 +352,9 @@ enet_range_coder_compress (void * context, const ENetBuffer * inBuffers, size_t
 
 #define ENET_RANGE_CODER_SEED \
 { \
-    if (inData < inEnd) decodeCode |= * inData ++ << 24; \
-    if (inData < inEnd) decodeCode |= * inData ++ << 16; \
-    if (inData < inEnd) decodeCode |= * inData ++ << 8; \
+    if (inData < inEnd) decodeCode |= (enet_uint32) * inData ++ << 24; \
+    if (inData < inEnd) decodeCode |= (enet_uint32) * inData ++ << 16; \
+    if (inData < inEnd) decodeCode |= (enet_uint32) * inData ++ << 8; \
     if (inData < inEnd) decodeCode |= * inData ++; \
 }
 
@@ -370,33 +379,30 @@ enet_range_coder_compress (void * context, const ENetBuffer * inBuffers, size_t
     } \
 }
 
-#define ENET_CONTEXT_DECODE(context, symbol_, code, value_, under_, count_, update, minimum, createRoot, visitNode, createRight, createLeft) \
+#define ENET_CONTEXT_TRY_DECODE(context, symbol_, code, value_, under_, count_, update) \
 { \
     under_ = 0; \
-    count_ = minimum; \
+    count_ = 0; \
     if (! (context) -> symbols) \
-    { \
-        createRoot; \
-    } \
+      return 0; \
     else \
     { \
         ENetSymbol * node = (context) + (context) -> symbols; \
         for (;;) \
         { \
-            enet_uint16 after = under_ + node -> under + (node -> value + 1)*minimum, before = node -> count + minimum; \
-            visitNode; \
+            enet_uint16 after = under_ + node -> under, before = node -> count; \
             if (code >= after) \
             { \
                 under_ += node -> under; \
                 if (node -> right) { node += node -> right; continue; } \
-                createRight; \
+                return 0; \
             } \
             else \
             if (code < after - before) \
             { \
                 node -> under += update; \
                 if (node -> left) { node += node -> left; continue; } \
-                createLeft; \
+                return 0; \
             } \
             else \
             { \
@@ -412,88 +418,38 @@ enet_range_coder_compress (void * context, const ENetBuffer * inBuffers, size_t
     } \
 }
 
-#define ENET_CONTEXT_TRY_DECODE(context, symbol_, code, value_, under_, count_, update, minimum, exclude) \
-ENET_CONTEXT_DECODE (context, symbol_, code, value_, under_, count_, update, minimum, return 0, exclude (node -> value, after, before), return 0, return 0)
-
-#define ENET_CONTEXT_ROOT_DECODE(context, symbol_, code, value_, under_, count_, update, minimum, exclude) \
-ENET_CONTEXT_DECODE (context, symbol_, code, value_, under_, count_, update, minimum, \
-    { \
-        value_ = code / minimum; \
-        under_ = code - code%minimum; \
-        ENET_SYMBOL_CREATE (symbol_, value_, update); \
-        (context) -> symbols = symbol_ - (context); \
-    }, \
-    exclude (node -> value, after, before), \
-    { \
-        value_ = node->value + 1 + (code - after)/minimum; \
-        under_ = code - (code - after)%minimum; \
-        ENET_SYMBOL_CREATE (symbol_, value_, update); \
-        node -> right = symbol_ - node; \
-    }, \
-    { \
-        value_ = node->value - 1 - (after - before - code - 1)/minimum; \
-        under_ = code - (after - before - code - 1)%minimum; \
-        ENET_SYMBOL_CREATE (symbol_, value_, update); \
-        node -> left = symbol_ - node; \
-    }) \
+#ifdef _MSC_VER
+#define ENET_NOINLINE __declspec(noinline)
+#elif defined(__GNUC__) || defined(__clang__)
+#define ENET_NOINLINE __attribute__ ((noinline))
+#else
+#define ENET_NOINLINE
+#endif
 
-#ifdef ENET_CONTEXT_EXCLUSION
-typedef struct _ENetExclude
+/* descend the binary indexed tree to the value whose range contains the code, a node covers step values;
+   the direction of each step is as good as random, so steps are taken through a mask instead of a branch,
+   and the descent stays out of the decoder loop, whose context walk is slower once it shares the registers */
+static ENET_NOINLINE enet_uint8
+enet_root_find (const ENetRangeCoder * rangeCoder, enet_uint16 code, enet_uint16 minimum, enet_uint16 * under)
 {
-    enet_uint8 value;
-    enet_uint16 under;
-} ENetExclude;
-
-#define ENET_CONTEXT_DECODE_EXCLUDE(context, total, minimum) \
-{ \
-    enet_uint16 under = 0; \
-    nextExclude = excludes; \
-    ENET_CONTEXT_WALK (context, { \
-        under += rangeCoder -> symbols [node -> parent].count + minimum; \
-        nextExclude -> value = node -> value; \
-        nextExclude -> under = under; \
-        nextExclude ++; \
-    }); \
-    total -= under; \
+    size_t index = 0, step;
+    enet_uint32 rest = code;
+    for (step = 128; step > 0; step >>= 1)
+    {
+        enet_uint32 weight = rangeCoder -> rootTree [index + step] + step*minimum;
+        enet_uint32 take = 0 - (enet_uint32) (weight <= rest);
+        index += step & take;
+        rest -= weight & take;
+    }
+    * under = (enet_uint16) (code - rest);
+    return (enet_uint8) index;
 }
 
-#define ENET_CONTEXT_EXCLUDED(value_, after, before) \
+#define ENET_ROOT_DECODE(symbol_, code, value_, under_, count_, update, minimum) \
 { \
-    size_t low = 0, high = nextExclude - excludes; \
-    for(;;) \
-    { \
-        size_t mid = (low + high) >> 1; \
-        const ENetExclude * exclude = & excludes [mid]; \
-        if (value_ < exclude -> value) \
-        { \
-            if (low + 1 < high) \
-            { \
-                high = mid; \
-                continue; \
-            } \
-            if (exclude > excludes) \
-              after -= exclude [-1].under; \
-        } \
-        else \
-        { \
-            if (value_ > exclude -> value) \
-            { \
-                if (low + 1 < high) \
-                { \
-                    low = mid; \
-                    continue; \
-                } \
-            } \
-            else \
-              before = 0; \
-            after -= exclude -> under; \
-        } \
-        break; \
-    } \
+    value_ = enet_root_find (rangeCoder, code, minimum, & under_); \
+    ENET_ROOT_UPDATE (symbol_, value_, count_, update, minimum); \
 }
-#endif
-
-#define ENET_CONTEXT_NOT_EXCLUDED(value_, after, before)
 
 size_t
 enet_range_coder_decompress (void * context, const enet_uint8 * inData, size_t inLimit, enet_uint8 * outData, size_t outLimit)
@@ -505,60 +461,37 @@ enet_range_coder_decompress (void * context, const enet_uint8 * inData, size_t i
     ENetSymbol * root;
     enet_uint16 predicted = 0;
     size_t order = 0, nextSymbol = 0;
-#ifdef ENET_CONTEXT_EXCLUSION
-    ENetExclude excludes [256];
-    ENetExclude * nextExclude = excludes;
-#endif
-  
+
     if (rangeCoder == NULL || inLimit <= 0)
       return 0;
 
-    ENET_CONTEXT_CREATE (root, ENET_CONTEXT_ESCAPE_MINIMUM, ENET_CONTEXT_SYMBOL_MINIMUM);
+    ENET_ROOT_CREATE (root, ENET_CONTEXT_ESCAPE_MINIMUM, ENET_CONTEXT_SYMBOL_MINIMUM);
 
     ENET_RANGE_CODER_SEED;
 
     for (;;)
     {
         ENetSymbol * subcontext, * symbol, * patch;
-#ifdef ENET_CONTEXT_EXCLUSION
-        const ENetSymbol * childContext = & emptyContext;
-#endif
         enet_uint8 value = 0;
         enet_uint16 code, under, count, bottom, * parent = & predicted, total;
 
         for (subcontext = & rangeCoder -> symbols [predicted];
              subcontext != root;
-#ifdef ENET_CONTEXT_EXCLUSION
-             childContext = subcontext, 
-#endif
                 subcontext = & rangeCoder -> symbols [subcontext -> parent])
         {
             if (subcontext -> escapes <= 0)
               continue;
             total = subcontext -> total;
-#ifdef ENET_CONTEXT_EXCLUSION
-            if (childContext -> total > 0) 
-              ENET_CONTEXT_DECODE_EXCLUDE (childContext, total, 0); 
-#endif
             if (subcontext -> escapes >= total)
               continue;
             code = ENET_RANGE_CODER_READ (total);
-            if (code < subcontext -> escapes) 
+            if (code < subcontext -> escapes)
             {
-                ENET_RANGE_CODER_DECODE (0, subcontext -> escapes, total); 
+                ENET_RANGE_CODER_DECODE (0, subcontext -> escapes, total);
                 continue;
             }
             code -= subcontext -> escapes;
-#ifdef ENET_CONTEXT_EXCLUSION
-            if (childContext -> total > 0)
-            {
-                ENET_CONTEXT_TRY_DECODE (subcontext, symbol, code, value, under, count, ENET_SUBCONTEXT_SYMBOL_DELTA, 0, ENET_CONTEXT_EXCLUDED); 
-            }
-            else
-#endif
-            {
-                ENET_CONTEXT_TRY_DECODE (subcontext, symbol, code, value, under, count, ENET_SUBCONTEXT_SYMBOL_DELTA, 0, ENET_CONTEXT_NOT_EXCLUDED); 
-            }
+            ENET_CONTEXT_TRY_DECODE (subcontext, symbol, code, value, under, count, ENET_SUBCONTEXT_SYMBOL_DELTA);
             bottom = symbol - rangeCoder -> symbols;
             ENET_RANGE_CODER_DECODE (subcontext -> escapes + under, count, total);
             subcontext -> total += ENET_SUBCONTEXT_SYMBOL_DELTA;
@@ -568,32 +501,22 @@ enet_range_coder_decompress (void * context, const enet_uint8 * inData, size_t i
         }
 
         total = root -> total;
-#ifdef ENET_CONTEXT_EXCLUSION
-        if (childContext -> total > 0)
-          ENET_CONTEXT_DECODE_EXCLUDE (childContext, total, ENET_CONTEXT_SYMBOL_MINIMUM);  
-#endif
         code = ENET_RANGE_CODER_READ (total);
+        /* only a corrupted stream reads past the last value */
+        if (code >= total)
+          return 0;
         if (code < root -> escapes)
         {
             ENET_RANGE_CODER_DECODE (0, root -> escapes, total);
             break;
         }
         code -= root -> escapes;
-#ifdef ENET_CONTEXT_EXCLUSION
-        if (childContext -> total > 0)
-        {
-            ENET_CONTEXT_ROOT_DECODE (root, symbol, code, value, under, count, ENET_CONTEXT_SYMBOL_DELTA, ENET_CONTEXT_SYMBOL_MINIMUM, ENET_CONTEXT_EXCLUDED); 
-        }
-        else
-#endif
-        {
-            ENET_CONTEXT_ROOT_DECODE (root, symbol, code, value, under, count, ENET_CONTEXT_SYMBOL_DELTA, ENET_CONTEXT_SYMBOL_MINIMUM, ENET_CONTEXT_NOT_EXCLUDED); 
-        }
+        ENET_ROOT_DECODE (symbol, code, value, under, count, ENET_CONTEXT_SYMBOL_DELTA, ENET_CONTEXT_SYMBOL_MINIMUM);
         bottom = symbol - rangeCoder -> symbols;
         ENET_RANGE_CODER_DECODE (root -> escapes + under, count, total);
         root -> total += ENET_CONTEXT_SYMBOL_DELTA;
         if (count > 0xFF - 2*ENET_CONTEXT_SYMBOL_DELTA + ENET_CONTEXT_SYMBOL_MINIMUM || root -> total > ENET_RANGE_CODER_BOTTOM - 0x100)
-          ENET_CONTEXT_RESCALE (root, ENET_CONTEXT_SYMBOL_MINIMUM);
+          ENET_ROOT_RESCALE (root, ENET_CONTEXT_SYMBOL_MINIMUM);
 
     patchContexts:
         for (patch = & rangeCoder -> symbols [predicted];
@@ -608,7 +531,7 @@ enet_range_coder_decompress (void * context, const enet_uint8 * inData, size_t i
                 patch -> escapes += ENET_SUBCONTEXT_ESCAPE_DELTA;
                 patch -> total += ENET_SUBCONTEXT_ESCAPE_DELTA;
             }
-            patch -> total += ENET_SUBCONTEXT_SYMBOL_DELTA; 
+            patch -> total += ENET_SUBCONTEXT_SYMBOL_DELTA;
             if (count > 0xFF - 2*ENET_SUBCONTEXT_SYMBOL_DELTA || patch -> total > ENET_RANGE_CODER_BOTTOM - 0x100)
               ENET_CONTEXT_RESCALE (patch, 0);
         }
@@ -622,7 +545,7 @@ enet_range_coder_decompress (void * context, const enet_uint8 * inData, size_t i
           order ++;
         ENET_RANGE_CODER_FREE_SYMBOLS;
     }
-                        
+
     return (size_t) (outData - outStart);
 }
 
@@ -648,7 +571,7 @@ enet_host_compress_with_range_coder (ENetHost * host)
     enet_host_compress (host, & compressor);
     return 0;
 }
-    
+
 /** @} */
-    
-     
+
+
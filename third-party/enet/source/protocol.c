@@ -1571,6 +1571,8 @@ enet_protocol_check_outgoing_commands (ENetHost * host, ENetPeer * peer, ENetLis
           buffer -> dataLength = outgoingCommand -> fragmentLength;
 
           host -> packetSize += outgoingCommand -> fragmentLength;
+          if (outgoingCommand -> packet -> flags & ENET_PACKET_FLAG_NO_COMPRESS)
+            host -> incompressibleSize += outgoingCommand -> fragmentLength;
        }
        else
        if (! (outgoingCommand -> command.header.command & ENET_PROTOCOL_COMMAND_FLAG_ACKNOWLEDGE))
@@ -1620,6 +1622,7 @@ enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int ch
         host -> commandCount = 0;
         host -> bufferCount = 1;
         host -> packetSize = sizeof (ENetProtocolHeader);
+        host -> incompressibleSize = 0;
 
         if (! enet_list_empty (& currentPeer -> acknowledgements))
           enet_protocol_send_acknowledgements (host, currentPeer);
@@ -1680,7 +1683,8 @@ enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int ch
           host -> buffers -> dataLength = (size_t) & ((ENetProtocolHeader *) 0) -> sentTime;
 
         shouldCompress = 0;
-        if (host -> compressor.context != NULL && host -> compressor.compress != NULL)
+        if (host -> compressor.context != NULL && host -> compressor.compress != NULL &&
+            host -> incompressibleSize * 2 < host -> packetSize - sizeof (ENetProtocolHeader))
         {
             size_t originalSize = host -> packetSize - sizeof(ENetProtocolHeader),
                    compressedSize = host -> compressor.compress (host -> compressor.context,